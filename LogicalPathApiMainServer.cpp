@@ -4,6 +4,7 @@
 #include "LogicalPathApiImpl.h"
 
 #include "logger.hpp"
+#include "metrics_endpoint.hpp"
 
 using namespace io::swagger::server::api;
 
@@ -33,12 +34,18 @@ int main()
             threads = 4;
         }
 
+        auto metrics_endpoint = ir::start_metrics_endpoint(ir::service_name);
+
         auto addr = Pistache::Address(Pistache::Ipv4::any(), Pistache::Port(port.get<int>()));
         auto server = LogicalPathApiImpl(addr);
         server.init(threads.get<int>());
         server.start();
 
         server.shutdown();
+
+        if (metrics_endpoint) {
+            metrics_endpoint->shutdown();
+        }
     }
     catch (...) {
         return 1;
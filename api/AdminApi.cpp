@@ -47,6 +47,7 @@ void AdminApi::setupRoutes() {
     using namespace Pistache::Rest;
 
     Routes::Post(router, irods::rest::base_url + "/admin", Routes::bind(&AdminApi::handler, this));
+    Routes::Post(router, irods::rest::base_url + "/admin/batch", Routes::bind(&AdminApi::batch_handler, this));
 
     // Default handler, called when a route is not found
     router.addCustomHandler(Routes::bind(&AdminApi::default_handler, this));
@@ -63,6 +64,17 @@ void AdminApi::handler(const Pistache::Rest::Request& request,
     }
 }
 
+void AdminApi::batch_handler(const Pistache::Rest::Request& request,
+                             Pistache::Http::ResponseWriter response)
+{
+    try {
+        this->batch_handler_impl(request, response);
+    }
+    catch (const std::runtime_error& e) {
+        response.send(Pistache::Http::Code::Bad_Request, e.what());
+    }
+}
+
 void AdminApi::default_handler(const Pistache::Rest::Request& request,
                                Pistache::Http::ResponseWriter response)
 {
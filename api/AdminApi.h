@@ -49,12 +49,18 @@ private:
     void handler(const Pistache::Rest::Request& request,
                  Pistache::Http::ResponseWriter response);
 
+    void batch_handler(const Pistache::Rest::Request& request,
+                       Pistache::Http::ResponseWriter response);
+
     void default_handler(const Pistache::Rest::Request& request,
                          Pistache::Http::ResponseWriter response);
 
     virtual void handler_impl(const Pistache::Rest::Request& request,
                               Pistache::Http::ResponseWriter& response) = 0;
 
+    virtual void batch_handler_impl(const Pistache::Rest::Request& request,
+                                    Pistache::Http::ResponseWriter& response) = 0;
+
     std::shared_ptr<Pistache::Http::Endpoint> httpEndpoint;
     Pistache::Rest::Router router;
 };
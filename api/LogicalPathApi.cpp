@@ -47,6 +47,14 @@ namespace io::swagger::server::api
             router,
             irods::rest::base_url + "/logicalpath/replicate",
             Routes::bind(&LogicalPathApi::replicate_handler, this));
+        Routes::Post(
+            router, irods::rest::base_url + "/logicalpath/copy", Routes::bind(&LogicalPathApi::copy_handler, this));
+        Routes::Post(
+            router, irods::rest::base_url + "/logicalpath/batch", Routes::bind(&LogicalPathApi::batch_handler, this));
+        Routes::Get(
+            router, irods::rest::base_url + "/jobs/:id", Routes::bind(&LogicalPathApi::get_job_handler, this));
+        Routes::Delete(
+            router, irods::rest::base_url + "/jobs/:id", Routes::bind(&LogicalPathApi::cancel_job_handler, this));
 
         // Default handler, called when a route is not found
         router.addCustomHandler(Routes::bind(&LogicalPathApi::default_handler, this));
@@ -103,6 +111,47 @@ namespace io::swagger::server::api
             response.send(Pistache::Http::Code::Bad_Request, e.what());
         }
     }
+
+    void LogicalPathApi::copy_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response)
+    {
+        try {
+            this->copy_handler_impl(request, response);
+        }
+        catch (const std::runtime_error& e) {
+            response.send(Pistache::Http::Code::Bad_Request, e.what());
+        }
+    }
+
+    void LogicalPathApi::batch_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response)
+    {
+        try {
+            this->batch_handler_impl(request, response);
+        }
+        catch (const std::runtime_error& e) {
+            response.send(Pistache::Http::Code::Bad_Request, e.what());
+        }
+    }
+
+    void LogicalPathApi::get_job_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response)
+    {
+        try {
+            this->get_job_handler_impl(request, response);
+        }
+        catch (const std::runtime_error& e) {
+            response.send(Pistache::Http::Code::Bad_Request, e.what());
+        }
+    }
+
+    void LogicalPathApi::cancel_job_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response)
+    {
+        try {
+            this->cancel_job_handler_impl(request, response);
+        }
+        catch (const std::runtime_error& e) {
+            response.send(Pistache::Http::Code::Bad_Request, e.what());
+        }
+    }
+
     void LogicalPathApi::default_handler(
         const Pistache::Rest::Request& request,
         Pistache::Http::ResponseWriter response)
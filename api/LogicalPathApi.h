@@ -35,6 +35,10 @@ namespace io::swagger::server::api
         void rename_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response);
         void trim_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response);
         void replicate_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response);
+        void copy_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response);
+        void batch_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response);
+        void get_job_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response);
+        void cancel_job_handler(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter response);
 
         virtual void post_handler_impl(
             const Pistache::Rest::Request& request,
@@ -51,6 +55,18 @@ namespace io::swagger::server::api
         virtual void replicate_handler_impl(
             const Pistache::Rest::Request& request,
             Pistache::Http::ResponseWriter& response) = 0;
+        virtual void copy_handler_impl(
+            const Pistache::Rest::Request& request,
+            Pistache::Http::ResponseWriter& response) = 0;
+        virtual void batch_handler_impl(
+            const Pistache::Rest::Request& request,
+            Pistache::Http::ResponseWriter& response) = 0;
+        virtual void get_job_handler_impl(
+            const Pistache::Rest::Request& request,
+            Pistache::Http::ResponseWriter& response) = 0;
+        virtual void cancel_job_handler_impl(
+            const Pistache::Rest::Request& request,
+            Pistache::Http::ResponseWriter& response) = 0;
 
         std::shared_ptr<Pistache::Http::Endpoint> httpEndpoint;
         Pistache::Rest::Router router;
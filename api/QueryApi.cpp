@@ -48,6 +48,7 @@ void QueryApi::setupRoutes() {
     using namespace Pistache::Rest;
 
     Routes::Get(router, irods::rest::base_url + "/query", Routes::bind(&QueryApi::handler, this));
+    Routes::Post(router, irods::rest::base_url + "/query/batch", Routes::bind(&QueryApi::batch_handler, this));
 
     // Default handler, called when a route is not found
     router.addCustomHandler(Routes::bind(&QueryApi::default_handler, this));
@@ -64,6 +65,17 @@ void QueryApi::handler(const Pistache::Rest::Request& request,
     }
 }
 
+void QueryApi::batch_handler(const Pistache::Rest::Request& request,
+                             Pistache::Http::ResponseWriter response)
+{
+    try {
+        this->batch_handler_impl(request, response);
+    }
+    catch (const std::runtime_error& e) {
+        response.send(Pistache::Http::Code::Bad_Request, e.what());
+    }
+}
+
 void QueryApi::default_handler(const Pistache::Rest::Request& request,
                                Pistache::Http::ResponseWriter response)
 {
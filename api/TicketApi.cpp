@@ -48,6 +48,7 @@ void TicketApi::setupRoutes() {
     using namespace Pistache::Rest;
 
     Routes::Get(router, irods::rest::base_url + "/ticket", Routes::bind(&TicketApi::handler, this));
+    Routes::Post(router, irods::rest::base_url + "/ticket/batch", Routes::bind(&TicketApi::batch_handler, this));
 
     // Default handler, called when a route is not found
     router.addCustomHandler(Routes::bind(&TicketApi::default_handler, this));
@@ -64,6 +65,17 @@ void TicketApi::handler(const Pistache::Rest::Request& request,
     }
 }
 
+void TicketApi::batch_handler(const Pistache::Rest::Request& request,
+                              Pistache::Http::ResponseWriter response)
+{
+    try {
+        this->batch_handler_impl(request, response);
+    }
+    catch (const std::runtime_error& e) {
+        response.send(Pistache::Http::Code::Bad_Request, e.what());
+    }
+}
+
 void TicketApi::default_handler(const Pistache::Rest::Request& request,
                                 Pistache::Http::ResponseWriter response)
 {
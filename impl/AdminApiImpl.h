@@ -48,6 +48,9 @@ namespace io::swagger::server::api
         void handler_impl(const Pistache::Rest::Request& request,
                           Pistache::Http::ResponseWriter& response) override;
 
+        void batch_handler_impl(const Pistache::Rest::Request& request,
+                                Pistache::Http::ResponseWriter& response) override;
+
         irods::rest::admin irods_admin_;
     }; // class AdminApiImpl
 } // namespace io::swagger::server::api
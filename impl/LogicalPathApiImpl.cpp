@@ -60,4 +60,44 @@ namespace io::swagger::server::api
         };
         irods::rest::handle_request(irods_logic, request, response);
     }
+
+    void LogicalPathApiImpl::copy_handler_impl(
+        const Pistache::Rest::Request& request,
+        Pistache::Http::ResponseWriter& response)
+    {
+        const auto irods_logic = [this](const Pistache::Rest::Request& _req, Pistache::Http::ResponseWriter& _res) {
+            return irods_logical_path_.copy_dispatcher(_req, _res);
+        };
+        irods::rest::handle_request(irods_logic, request, response);
+    }
+
+    void LogicalPathApiImpl::batch_handler_impl(
+        const Pistache::Rest::Request& request,
+        Pistache::Http::ResponseWriter& response)
+    {
+        const auto irods_logic = [this](const Pistache::Rest::Request& _req, Pistache::Http::ResponseWriter& _res) {
+            return irods_logical_path_.batch_dispatcher(_req, _res);
+        };
+        irods::rest::handle_request(irods_logic, request, response);
+    }
+
+    void LogicalPathApiImpl::get_job_handler_impl(
+        const Pistache::Rest::Request& request,
+        Pistache::Http::ResponseWriter& response)
+    {
+        const auto irods_logic = [this](const Pistache::Rest::Request& _req, Pistache::Http::ResponseWriter& _res) {
+            return irods_logical_path_.get_job_dispatcher(_req, _res);
+        };
+        irods::rest::handle_request(irods_logic, request, response);
+    }
+
+    void LogicalPathApiImpl::cancel_job_handler_impl(
+        const Pistache::Rest::Request& request,
+        Pistache::Http::ResponseWriter& response)
+    {
+        const auto irods_logic = [this](const Pistache::Rest::Request& _req, Pistache::Http::ResponseWriter& _res) {
+            return irods_logical_path_.cancel_job_dispatcher(_req, _res);
+        };
+        irods::rest::handle_request(irods_logic, request, response);
+    }
 } // namespace io::swagger::server::api
@@ -40,6 +40,18 @@ namespace io::swagger::server::api
         void replicate_handler_impl(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter& response)
             override;
 
+        void copy_handler_impl(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter& response)
+            override;
+
+        void batch_handler_impl(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter& response)
+            override;
+
+        void get_job_handler_impl(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter& response)
+            override;
+
+        void cancel_job_handler_impl(const Pistache::Rest::Request& request, Pistache::Http::ResponseWriter& response)
+            override;
+
         irods::rest::logical_path irods_logical_path_;
     }; // class LogicalPathApiImpl
 } // namespace io::swagger::server::api
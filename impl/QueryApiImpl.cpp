@@ -27,7 +27,21 @@ namespace io::swagger::server::api
     void QueryApiImpl::handler_impl(const Pistache::Rest::Request& request,
                                     Pistache::Http::ResponseWriter& response)
     {
+        if (irods_query_.is_export_request(request)) {
+            irods::rest::handle_streaming_request(irods_query_, &irods::rest::query::export_rows, request, response);
+            return;
+        }
+
         irods::rest::handle_request(irods_query_, request, response);
     }
+
+    void QueryApiImpl::batch_handler_impl(const Pistache::Rest::Request& request,
+                                          Pistache::Http::ResponseWriter& response)
+    {
+        const auto irods_logic = [this](const Pistache::Rest::Request& _req, Pistache::Http::ResponseWriter& _res) {
+            return irods_query_.batch(_req, _res);
+        };
+        irods::rest::handle_request(irods_logic, request, response);
+    }
 } // namespace io::swagger::server::api
 
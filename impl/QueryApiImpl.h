@@ -50,6 +50,9 @@ namespace io::swagger::server::api
         void handler_impl(const Pistache::Rest::Request& request,
                           Pistache::Http::ResponseWriter& response) override;
 
+        void batch_handler_impl(const Pistache::Rest::Request& request,
+                                Pistache::Http::ResponseWriter& response) override;
+
         irods::rest::query irods_query_;
     }; // class QueryApiImpl
 } // namespace io::swagger::server::api
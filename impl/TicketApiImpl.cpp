@@ -29,5 +29,14 @@ namespace io::swagger::server::api
     {
         irods::rest::handle_request(irods_ticket_, request, response);
     }
+
+    void TicketApiImpl::batch_handler_impl(const Pistache::Rest::Request& request,
+                                           Pistache::Http::ResponseWriter& response)
+    {
+        const auto irods_logic = [this](const Pistache::Rest::Request& _req, Pistache::Http::ResponseWriter& _res) {
+            return irods_ticket_.batch(_req, _res);
+        };
+        irods::rest::handle_request(irods_logic, request, response);
+    }
 } // namespace io::swagger::server::api
 
@@ -48,6 +48,9 @@ namespace io::swagger::server::api
         void handler_impl(const Pistache::Rest::Request& request,
                           Pistache::Http::ResponseWriter& response) override;
 
+        void batch_handler_impl(const Pistache::Rest::Request& request,
+                                Pistache::Http::ResponseWriter& response) override;
+
         irods::rest::ticket irods_ticket_;
     }; // class TicketApiImpl
 } // namespace io::swagger::server::api
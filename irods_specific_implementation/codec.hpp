@@ -0,0 +1,209 @@
+#ifndef IRODS_REST_CPP_CODEC_HPP
+#define IRODS_REST_CPP_CODEC_HPP
+
+#include <irods/irods_exception.hpp>
+#include <irods/rodsErrorTable.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#elif defined(__SSE2__)
+#  include <emmintrin.h>
+#endif
+
+// Percent-decoding and base64 shared by all endpoints.
+namespace irods::rest::codec
+{
+    namespace detail
+    {
+        // Returns the position of the first '%' or '+' at or after _pos, or _s.size().
+        inline auto find_escape(std::string_view _s, std::size_t _pos) noexcept -> std::size_t
+        {
+            const auto* data = _s.data();
+            const auto size = _s.size();
+
+#if defined(__AVX2__)
+            const auto percent = _mm256_set1_epi8('%');
+            const auto plus = _mm256_set1_epi8('+');
+
+            for (; _pos + 32 <= size; _pos += 32) {
+                const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + _pos));
+                const auto hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, percent), _mm256_cmpeq_epi8(chunk, plus));
+
+                if (const auto mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(hits)); mask != 0) {
+                    return _pos + __builtin_ctz(mask);
+                }
+            }
+#elif defined(__SSE2__)
+            const auto percent = _mm_set1_epi8('%');
+            const auto plus = _mm_set1_epi8('+');
+
+            for (; _pos + 16 <= size; _pos += 16) {
+                const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + _pos));
+                const auto hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, percent), _mm_cmpeq_epi8(chunk, plus));
+
+                if (const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(hits)); mask != 0) {
+                    return _pos + __builtin_ctz(mask);
+                }
+            }
+#endif
+
+            for (; _pos < size; ++_pos) {
+                if ('%' == data[_pos] || '+' == data[_pos]) {
+                    return _pos;
+                }
+            }
+
+            return size;
+        } // find_escape
+
+        constexpr auto hex_value(char _c) noexcept -> int
+        {
+            if (_c >= '0' && _c <= '9') { return _c - '0'; }
+            if (_c >= 'a' && _c <= 'f') { return _c - 'a' + 10; }
+            if (_c >= 'A' && _c <= 'F') { return _c - 'A' + 10; }
+            return -1;
+        } // hex_value
+
+        // Maps each byte to its 6-bit value, or 0xff if it is not part of the alphabet.
+        constexpr auto make_base64_table(char _62, char _63) noexcept -> std::array<std::uint8_t, 256>
+        {
+            std::array<std::uint8_t, 256> table{};
+
+            for (auto& v : table) {
+                v = 0xff;
+            }
+
+            for (int i = 0; i < 26; ++i) {
+                table['A' + i] = static_cast<std::uint8_t>(i);
+                table['a' + i] = static_cast<std::uint8_t>(26 + i);
+            }
+
+            for (int i = 0; i < 10; ++i) {
+                table['0' + i] = static_cast<std::uint8_t>(52 + i);
+            }
+
+            table[static_cast<unsigned char>(_62)] = 62;
+            table[static_cast<unsigned char>(_63)] = 63;
+
+            return table;
+        } // make_base64_table
+
+        inline constexpr auto base64_table = make_base64_table('+', '/');
+
+        inline auto base64_decode(std::string_view _in, const std::array<std::uint8_t, 256>& _table) -> std::string
+        {
+            if (_in.size() % 4 != 0) {
+                THROW(SYS_INVALID_INPUT_PARAM, "base64 input is not a multiple of 4");
+            }
+
+            // Strip up to two padding characters.
+            for (int i = 0; i < 2 && !_in.empty() && '=' == _in.back(); ++i) {
+                _in.remove_suffix(1);
+            }
+
+            if (_in.size() % 4 == 1) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Invalid base64 input length");
+            }
+
+            std::string out;
+            out.resize(_in.size() / 4 * 3 + (_in.size() % 4 == 0 ? 0 : _in.size() % 4 - 1));
+
+            const auto* in = reinterpret_cast<const unsigned char*>(_in.data());
+            auto* o = out.data();
+
+            // Invalid characters map to 0xff, so OR-ing the values of a quantum detects them
+            // without a branch per character.
+            std::uint32_t invalid = 0;
+            std::size_t i = 0;
+
+            for (; i + 4 <= _in.size(); i += 4) {
+                const std::uint32_t a = _table[in[i]];
+                const std::uint32_t b = _table[in[i + 1]];
+                const std::uint32_t c = _table[in[i + 2]];
+                const std::uint32_t d = _table[in[i + 3]];
+                invalid |= a | b | c | d;
+
+                const auto t = (a << 18) | (b << 12) | (c << 6) | d;
+                *o++ = static_cast<char>(t >> 16);
+                *o++ = static_cast<char>(t >> 8);
+                *o++ = static_cast<char>(t);
+            }
+
+            if (const auto rest = _in.size() - i; rest > 0) {
+                const std::uint32_t a = _table[in[i]];
+                const std::uint32_t b = _table[in[i + 1]];
+                const std::uint32_t c = rest > 2 ? _table[in[i + 2]] : 0;
+                invalid |= a | b | c;
+
+                const auto t = (a << 18) | (b << 12) | (c << 6);
+                *o++ = static_cast<char>(t >> 16);
+
+                if (rest > 2) {
+                    *o++ = static_cast<char>(t >> 8);
+                }
+            }
+
+            if (invalid & 0x80) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Invalid base64 character");
+            }
+
+            return out;
+        } // base64_decode
+    } // namespace detail
+
+    /// \brief Decodes a URL-encoded string. "%XX" is replaced by the byte it encodes and "+"
+    /// is replaced by a space.
+    ///
+    /// Runs of bytes without escapes are located 16 or 32 bytes at a time (SSE2/AVX2) and
+    /// copied as a block.
+    ///
+    /// \throws irods::exception If an escape is not followed by two hexadecimal digits.
+    inline auto percent_decode(std::string_view _in) -> std::string
+    {
+        std::string out;
+        out.reserve(_in.size());
+
+        std::size_t pos = 0;
+
+        while (pos < _in.size()) {
+            const auto next = detail::find_escape(_in, pos);
+            out.append(_in.data() + pos, next - pos);
+
+            if (next == _in.size()) {
+                break;
+            }
+
+            if ('+' == _in[next]) {
+                out += ' ';
+                pos = next + 1;
+                continue;
+            }
+
+            const auto hi = next + 2 < _in.size() ? detail::hex_value(_in[next + 1]) : -1;
+            const auto lo = next + 2 < _in.size() ? detail::hex_value(_in[next + 2]) : -1;
+
+            if (hi < 0 || lo < 0) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Failed to decode URL");
+            }
+
+            out += static_cast<char>((hi << 4) | lo);
+            pos = next + 3;
+        }
+
+        return out;
+    } // percent_decode
+
+    /// \throws irods::exception If \p _in is not padded base64.
+    inline auto base64_decode(std::string_view _in) -> std::string
+    {
+        return detail::base64_decode(_in, detail::base64_table);
+    } // base64_decode
+} // namespace irods::rest::codec
+
+#endif // IRODS_REST_CPP_CODEC_HPP
@@ -0,0 +1,377 @@
+#ifndef IRODS_REST_CPP_COMPRESSION_HPP
+#define IRODS_REST_CPP_COMPRESSION_HPP
+
+#include <irods/irods_exception.hpp>
+#include <irods/rodsErrorTable.h>
+
+#include <fmt/format.h>
+#include <zlib.h>
+
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+#  include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+// Streaming gzip and zstd encoders/decoders used for HTTP content codings.
+namespace irods::rest::compression
+{
+    enum class content_coding
+    {
+        identity,
+        gzip,
+        zstd
+    }; // enum class content_coding
+
+    // Per-service thresholds for compressing responses.
+    struct settings
+    {
+        bool enabled = false;
+        std::size_t minimum_size_in_bytes = 1024;
+        int gzip_level = 6;
+        int zstd_level = 3;
+    }; // struct settings
+
+    constexpr auto zstd_supported() noexcept -> bool
+    {
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    } // zstd_supported
+
+    inline auto to_string(content_coding _coding) -> std::string_view
+    {
+        switch (_coding) {
+            case content_coding::gzip: return "gzip";
+            case content_coding::zstd: return "zstd";
+            default:                   return "identity";
+        }
+    } // to_string
+
+    // Picks the coding for a response from the value of an Accept-Encoding header. zstd is
+    // preferred over gzip when both are acceptable. Codings with a quality of zero are ignored.
+    inline auto negotiate(std::string_view _accept_encoding) -> content_coding
+    {
+        bool gzip = false;
+        bool zstd = false;
+
+        while (!_accept_encoding.empty()) {
+            auto pos = _accept_encoding.find(',');
+            auto item = _accept_encoding.substr(0, pos);
+            _accept_encoding.remove_prefix(pos == std::string_view::npos ? _accept_encoding.size() : pos + 1);
+
+            std::string_view params;
+
+            if (const auto semicolon = item.find(';'); semicolon != std::string_view::npos) {
+                params = item.substr(semicolon + 1);
+                item = item.substr(0, semicolon);
+            }
+
+            const auto trim = [](std::string_view _s) {
+                while (!_s.empty() && std::isspace(static_cast<unsigned char>(_s.front()))) { _s.remove_prefix(1); }
+                while (!_s.empty() && std::isspace(static_cast<unsigned char>(_s.back())))  { _s.remove_suffix(1); }
+                return _s;
+            };
+
+            // Content codings are case-insensitive.
+            std::string coding{trim(item)};
+            std::transform(std::begin(coding), std::end(coding), std::begin(coding), [](unsigned char _c) {
+                return std::tolower(_c);
+            });
+
+            params = trim(params);
+
+            if (params.size() > 2 && (params[0] == 'q' || params[0] == 'Q') && params[1] == '=') {
+                if (std::strtod(std::string{params.substr(2)}.c_str(), nullptr) <= 0.0) {
+                    continue;
+                }
+            }
+
+            if ("gzip" == coding || "*" == coding) {
+                gzip = true;
+            }
+
+            if ("zstd" == coding || "*" == coding) {
+                zstd = true;
+            }
+        }
+
+        if (zstd && zstd_supported()) {
+            return content_coding::zstd;
+        }
+
+        return gzip ? content_coding::gzip : content_coding::identity;
+    } // negotiate
+
+    // Identifies a compressed body by its magic number. Used when the declared Content-Encoding
+    // is not understood by the HTTP library.
+    inline auto detect(std::string_view _data) noexcept -> content_coding
+    {
+        if (_data.size() >= 2 && '\x1f' == _data[0] && '\x8b' == _data[1]) {
+            return content_coding::gzip;
+        }
+
+        if (_data.size() >= 4 && '\x28' == _data[0] && '\xb5' == _data[1] && '\x2f' == _data[2] && '\xfd' == _data[3]) {
+            return content_coding::zstd;
+        }
+
+        return content_coding::identity;
+    } // detect
+
+    // Compresses data incrementally. Output is appended to the string passed to each call.
+    class encoder
+    {
+    public:
+        encoder(content_coding _coding, int _level)
+            : coding_{_coding}
+            , zs_{}
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+            , zc_{}
+#endif
+        {
+            if (content_coding::gzip == coding_) {
+                // 15 + 16 selects the gzip wrapper.
+                if (deflateInit2(&zs_, std::clamp(_level, 1, 9), Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    THROW(SYS_MALLOC_ERR, "Failed to initialize gzip encoder");
+                }
+            }
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+            else if (content_coding::zstd == coding_) {
+                zc_ = ZSTD_createCCtx();
+
+                if (!zc_) {
+                    THROW(SYS_MALLOC_ERR, "Failed to initialize zstd encoder");
+                }
+
+                ZSTD_CCtx_setParameter(zc_, ZSTD_c_compressionLevel, _level);
+            }
+#endif
+        }
+
+        encoder(const encoder&) = delete;
+        auto operator=(const encoder&) -> encoder& = delete;
+
+        ~encoder()
+        {
+            if (content_coding::gzip == coding_) {
+                deflateEnd(&zs_);
+            }
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+            else if (zc_) {
+                ZSTD_freeCCtx(zc_);
+            }
+#endif
+        }
+
+        auto update(std::string_view _in, std::string& _out) -> void
+        {
+            process(_in, _out, false);
+        }
+
+        auto finish(std::string& _out) -> void
+        {
+            process({}, _out, true);
+        }
+
+    private:
+        auto process(std::string_view _in, std::string& _out, bool _finish) -> void
+        {
+            std::array<char, 16 * 1024> buffer;
+
+            if (content_coding::identity == coding_) {
+                _out.append(_in);
+                return;
+            }
+
+            if (content_coding::gzip == coding_) {
+                zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(_in.data()));
+                zs_.avail_in = static_cast<uInt>(_in.size());
+
+                int ec = Z_OK;
+
+                do {
+                    zs_.next_out = reinterpret_cast<Bytef*>(buffer.data());
+                    zs_.avail_out = static_cast<uInt>(buffer.size());
+                    ec = deflate(&zs_, _finish ? Z_FINISH : Z_NO_FLUSH);
+
+                    if (Z_STREAM_ERROR == ec) {
+                        THROW(SYS_INTERNAL_ERR, "gzip compression failed");
+                    }
+
+                    _out.append(buffer.data(), buffer.size() - zs_.avail_out);
+                } while (0 == zs_.avail_out || (_finish && Z_STREAM_END != ec));
+
+                return;
+            }
+
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+            ZSTD_inBuffer in{_in.data(), _in.size(), 0};
+
+            while (true) {
+                ZSTD_outBuffer out{buffer.data(), buffer.size(), 0};
+                const auto remaining = ZSTD_compressStream2(zc_, &out, &in, _finish ? ZSTD_e_end : ZSTD_e_continue);
+
+                if (ZSTD_isError(remaining)) {
+                    THROW(SYS_INTERNAL_ERR, fmt::format("zstd compression failed [{}]", ZSTD_getErrorName(remaining)));
+                }
+
+                _out.append(buffer.data(), out.pos);
+
+                if (_finish ? 0 == remaining : in.pos == in.size) {
+                    break;
+                }
+            }
+#endif
+        }
+
+        content_coding coding_;
+        z_stream zs_;
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+        ZSTD_CCtx* zc_;
+#endif
+    }; // class encoder
+
+    // Decompresses data incrementally, handing each decompressed chunk to a sink so that the
+    // decompressed data never has to be held in memory at once.
+    class decoder
+    {
+    public:
+        explicit decoder(content_coding _coding)
+            : coding_{_coding}
+            , zs_{}
+            , done_{content_coding::identity == _coding}
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+            , zd_{}
+#endif
+        {
+            if (content_coding::gzip == coding_) {
+                // 15 + 32 detects the gzip or zlib wrapper automatically.
+                if (inflateInit2(&zs_, 15 + 32) != Z_OK) {
+                    THROW(SYS_MALLOC_ERR, "Failed to initialize gzip decoder");
+                }
+            }
+            else if (content_coding::zstd == coding_) {
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+                zd_ = ZSTD_createDCtx();
+
+                if (!zd_) {
+                    THROW(SYS_MALLOC_ERR, "Failed to initialize zstd decoder");
+                }
+#else
+                THROW(SYS_NOT_SUPPORTED, "zstd content coding is not supported by this build");
+#endif
+            }
+        }
+
+        decoder(const decoder&) = delete;
+        auto operator=(const decoder&) -> decoder& = delete;
+
+        ~decoder()
+        {
+            if (content_coding::gzip == coding_) {
+                inflateEnd(&zs_);
+            }
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+            else if (zd_) {
+                ZSTD_freeDCtx(zd_);
+            }
+#endif
+        }
+
+        // Invokes _sink(const char*, std::size_t) for every decompressed chunk.
+        template <typename Sink>
+        auto update(std::string_view _in, Sink&& _sink) -> void
+        {
+            if (content_coding::identity == coding_) {
+                if (!_in.empty()) {
+                    _sink(_in.data(), _in.size());
+                }
+
+                return;
+            }
+
+            std::array<char, 64 * 1024> buffer;
+
+            if (content_coding::gzip == coding_) {
+                zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(_in.data()));
+                zs_.avail_in = static_cast<uInt>(_in.size());
+
+                // Keep going while output is pending, i.e. while the buffer is filled completely.
+                do {
+                    zs_.next_out = reinterpret_cast<Bytef*>(buffer.data());
+                    zs_.avail_out = static_cast<uInt>(buffer.size());
+
+                    const auto ec = inflate(&zs_, Z_NO_FLUSH);
+
+                    if (Z_OK != ec && Z_STREAM_END != ec) {
+                        THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Invalid gzip data [{}]", zs_.msg ? zs_.msg : "unknown error"));
+                    }
+
+                    if (const auto n = buffer.size() - zs_.avail_out; n > 0) {
+                        _sink(buffer.data(), n);
+                    }
+
+                    done_ = (Z_STREAM_END == ec);
+                } while (!done_ && (zs_.avail_in > 0 || 0 == zs_.avail_out));
+
+                return;
+            }
+
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+            ZSTD_inBuffer in{_in.data(), _in.size(), 0};
+
+            for (bool output_pending = false; in.pos < in.size || output_pending;) {
+                ZSTD_outBuffer out{buffer.data(), buffer.size(), 0};
+                const auto ec = ZSTD_decompressStream(zd_, &out, &in);
+
+                if (ZSTD_isError(ec)) {
+                    THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Invalid zstd data [{}]", ZSTD_getErrorName(ec)));
+                }
+
+                if (out.pos > 0) {
+                    _sink(buffer.data(), out.pos);
+                }
+
+                done_ = (0 == ec);
+                output_pending = (out.pos == out.size);
+            }
+#endif
+        }
+
+        // Returns true if the end of the compressed stream was reached.
+        auto done() const noexcept -> bool
+        {
+            return done_;
+        }
+
+    private:
+        content_coding coding_;
+        z_stream zs_;
+        bool done_;
+#ifdef IRODS_REST_CPP_ENABLE_ZSTD
+        ZSTD_DCtx* zd_;
+#endif
+    }; // class decoder
+
+    inline auto compress(std::string_view _data, content_coding _coding, int _level) -> std::string
+    {
+        std::string out;
+        out.reserve(_data.size() / 4);
+
+        encoder e{_coding, _level};
+        e.update(_data, out);
+        e.finish(out);
+
+        return out;
+    } // compress
+} // namespace irods::rest::compression
+
+#endif // IRODS_REST_CPP_COMPRESSION_HPP
@@ -0,0 +1,192 @@
+#ifndef IRODS_REST_CPP_EXPIRING_CACHE_HPP
+#define IRODS_REST_CPP_EXPIRING_CACHE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace irods::rest
+{
+    /// \brief A thread-safe key/value cache whose entries expire after a configurable time-to-live.
+    ///
+    /// Concurrent lookups of a key that is not cached are coalesced. The first caller computes
+    /// the value while every other caller waits for and shares that result. Failures are handed
+    /// to all waiting callers, but are never cached.
+    ///
+    /// A time-to-live of zero disables caching while keeping the coalescing behavior.
+    template <typename Key, typename Value>
+    class expiring_cache
+    {
+    public:
+        using clock_type = std::chrono::steady_clock;
+
+        explicit expiring_cache(std::chrono::seconds _time_to_live = std::chrono::seconds{0},
+                                std::size_t _max_entries = 1024)
+            : mutex_{}
+            , time_to_live_{_time_to_live}
+            , max_entries_{_max_entries}
+            , generation_{0}
+            , entries_{}
+        {
+        } // ctor
+
+        expiring_cache(const expiring_cache&) = delete;
+        auto operator=(const expiring_cache&) -> expiring_cache& = delete;
+
+        auto set_time_to_live(std::chrono::seconds _time_to_live) -> void
+        {
+            std::scoped_lock lk{mutex_};
+            time_to_live_ = _time_to_live;
+        } // set_time_to_live
+
+        auto set_maximum_number_of_entries(std::size_t _max_entries) -> void
+        {
+            std::scoped_lock lk{mutex_};
+            max_entries_ = _max_entries;
+        } // set_maximum_number_of_entries
+
+        /// \brief Returns the value mapped to \p _key, invoking \p _fn to compute it if necessary.
+        ///
+        /// \p _fn is invoked at most once for all concurrent callers requesting the same key.
+        ///
+        /// \throws Any exception thrown by \p _fn.
+        template <typename Fn>
+        auto get_or_compute(const Key& _key, Fn&& _fn) -> Value
+        {
+            std::promise<Value> promise;
+            std::shared_future<Value> future;
+            std::uint64_t generation = 0;
+
+            {
+                std::scoped_lock lk{mutex_};
+
+                const auto now = clock_type::now();
+
+                if (auto iter = entries_.find(_key); iter != std::end(entries_)) {
+                    if (iter->second.pending || now < iter->second.expires_at) {
+                        future = iter->second.value;
+                    }
+                    else {
+                        entries_.erase(iter);
+                    }
+                }
+
+                if (!future.valid()) {
+                    make_room_if_necessary(now);
+
+                    future = promise.get_future().share();
+                    generation = ++generation_;
+                    entries_.insert_or_assign(_key, entry{future, clock_type::time_point{}, generation, true});
+                }
+            }
+
+            // Another caller owns the computation (or the value is cached). Wait for it.
+            if (0 == generation) {
+                return future.get();
+            }
+
+            bool failed = false;
+
+            try {
+                promise.set_value(_fn());
+            }
+            catch (...) {
+                failed = true;
+                promise.set_exception(std::current_exception());
+            }
+
+            {
+                std::scoped_lock lk{mutex_};
+
+                // The entry may have been replaced or invalidated while the value was being computed.
+                if (auto iter = entries_.find(_key);
+                    iter != std::end(entries_) && iter->second.generation == generation)
+                {
+                    if (failed || time_to_live_.count() == 0) {
+                        entries_.erase(iter);
+                    }
+                    else {
+                        iter->second.pending = false;
+                        iter->second.expires_at = clock_type::now() + time_to_live_;
+                    }
+                }
+            }
+
+            return future.get();
+        } // get_or_compute
+
+        /// \brief Removes the entry mapped to \p _key.
+        ///
+        /// Callers already waiting on a pending computation still receive its result.
+        auto erase(const Key& _key) -> void
+        {
+            std::scoped_lock lk{mutex_};
+            entries_.erase(_key);
+        } // erase
+
+        auto clear() -> void
+        {
+            std::scoped_lock lk{mutex_};
+            entries_.clear();
+        } // clear
+
+    private:
+        struct entry
+        {
+            std::shared_future<Value> value;
+            clock_type::time_point expires_at;
+            std::uint64_t generation;
+            bool pending;
+        }; // struct entry
+
+        auto make_room_if_necessary(clock_type::time_point _now) -> void
+        {
+            if (entries_.size() < max_entries_) {
+                return;
+            }
+
+            // Release expired entries first.
+            for (auto iter = std::begin(entries_); iter != std::end(entries_);) {
+                if (!iter->second.pending && iter->second.expires_at <= _now) {
+                    iter = entries_.erase(iter);
+                }
+                else {
+                    ++iter;
+                }
+            }
+
+            // Then release the entries closest to expiring. Pending entries are never released
+            // because other callers may be waiting on them.
+            while (entries_.size() >= max_entries_) {
+                auto victim = std::end(entries_);
+
+                for (auto iter = std::begin(entries_); iter != std::end(entries_); ++iter) {
+                    if (!iter->second.pending &&
+                        (victim == std::end(entries_) || iter->second.expires_at < victim->second.expires_at))
+                    {
+                        victim = iter;
+                    }
+                }
+
+                if (victim == std::end(entries_)) {
+                    break;
+                }
+
+                entries_.erase(victim);
+            }
+        } // make_room_if_necessary
+
+        std::mutex mutex_;
+        std::chrono::seconds time_to_live_;
+        std::size_t max_entries_;
+        std::uint64_t generation_;
+        std::map<Key, entry> entries_;
+    }; // class expiring_cache
+} // namespace irods::rest
+
+#endif // IRODS_REST_CPP_EXPIRING_CACHE_HPP
@@ -0,0 +1,347 @@
+#ifndef IRODS_REST_CPP_GENQUERY_HPP
+#define IRODS_REST_CPP_GENQUERY_HPP
+
+#include "metrics.hpp"
+
+#include <irods/irods_exception.hpp>
+#include <irods/rcMisc.h>
+#include <irods/rodsClient.h>
+#include <irods/rodsErrorTable.h>
+#include <irods/rodsGenQuery.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Thin wrappers around rcGenQuery which expose the GenQuery continuation index.
+//
+// Unlike irods::query, these allow a caller to fetch a result set one batch at a time
+// and to keep the server-side statement open between batches.
+namespace irods::rest::genquery
+{
+    using row_type = std::vector<std::string>;
+
+    // Owns a genQueryInp_t, including the continuation index of an open statement.
+    class input
+    {
+    public:
+        input()
+            : input_{}
+        {
+        }
+
+        input(const std::string_view _query_string, int _options)
+            : input_{}
+        {
+            std::vector<char> query_string(std::begin(_query_string), std::end(_query_string));
+            query_string.push_back('\0');
+
+            if (const auto ec = fillGenQueryInpFromStrCond(query_string.data(), &input_); ec < 0) {
+                clearGenQueryInp(&input_);
+                THROW(ec, fmt::format("Failed to parse query [{}]", _query_string));
+            }
+
+            input_.options = _options;
+        }
+
+        input(const input&) = delete;
+        auto operator=(const input&) -> input& = delete;
+
+        ~input()
+        {
+            clearGenQueryInp(&input_);
+        }
+
+        auto get() noexcept -> genQueryInp_t*
+        {
+            return &input_;
+        }
+
+        auto continue_index() const noexcept -> int
+        {
+            return input_.continueInx;
+        }
+
+        auto set_row_offset(int _offset) noexcept -> void
+        {
+            input_.rowOffset = _offset;
+        }
+
+    private:
+        genQueryInp_t input_;
+    }; // class input
+
+    // Owns the genQueryOut_t produced by a single call to rcGenQuery.
+    class batch
+    {
+    public:
+        batch() noexcept
+            : output_{}
+        {
+        }
+
+        explicit batch(genQueryOut_t* _output) noexcept
+            : output_{_output}
+        {
+        }
+
+        batch(batch&& _other) noexcept
+            : output_{std::exchange(_other.output_, nullptr)}
+        {
+        }
+
+        batch(const batch&) = delete;
+        auto operator=(const batch&) -> batch& = delete;
+
+        ~batch()
+        {
+            if (output_) {
+                freeGenQueryOut(&output_);
+            }
+        }
+
+        auto row_count() const noexcept -> int
+        {
+            return output_ ? output_->rowCnt : 0;
+        }
+
+        auto column_count() const noexcept -> int
+        {
+            return output_ ? output_->attriCnt : 0;
+        }
+
+        auto total_row_count() const noexcept -> int
+        {
+            return output_ ? output_->totalRowCount : 0;
+        }
+
+        auto value(int _row, int _column) const noexcept -> std::string_view
+        {
+            const auto& result = output_->sqlResult[_column];
+            return &result.value[_row * result.len];
+        }
+
+        auto row(int _row) const -> row_type
+        {
+            row_type r;
+            r.reserve(column_count());
+
+            for (int c = 0; c < column_count(); ++c) {
+                r.emplace_back(value(_row, c));
+            }
+
+            return r;
+        }
+
+    private:
+        genQueryOut_t* output_;
+    }; // class batch
+
+    // Fetches the next batch of at most _max_rows rows. The continuation index stored in
+    // _input is updated so that the following call resumes where this one stopped. Once the
+    // result set is exhausted, the continuation index is zero.
+    inline auto fetch_batch(RcComm& _comm, input& _input, int _max_rows) -> batch
+    {
+        auto* inp = _input.get();
+        inp->maxRows = std::clamp(_max_rows, 1, MAX_SQL_ROWS);
+
+        genQueryOut_t* output{};
+
+        if (const auto ec = metrics::invoke("rcGenQuery", rcGenQuery, &_comm, inp, &output); ec < 0) {
+            if (output) {
+                freeGenQueryOut(&output);
+            }
+
+            if (CAT_NO_ROWS_FOUND == ec) {
+                inp->continueInx = 0;
+                return {};
+            }
+
+            THROW(ec, "Received error from rcGenQuery");
+        }
+
+        inp->continueInx = output->continueInx;
+
+        return batch{output};
+    } // fetch_batch
+
+    struct page
+    {
+        std::vector<row_type> rows;
+        int total_row_count;
+    }; // struct page
+
+    // Fetches up to _max_rows rows, issuing as many batches as required. The statement is left
+    // open if more rows are available (see input::continue_index()).
+    inline auto fetch_page(RcComm& _comm, input& _input, std::size_t _max_rows) -> page
+    {
+        page p{{}, 0};
+        p.rows.reserve(std::min<std::size_t>(_max_rows, MAX_SQL_ROWS));
+
+        do {
+            const auto remaining = static_cast<int>(std::min<std::size_t>(_max_rows - p.rows.size(), MAX_SQL_ROWS));
+            const auto b = fetch_batch(_comm, _input, remaining);
+
+            if (b.total_row_count() > 0) {
+                p.total_row_count = b.total_row_count();
+            }
+
+            for (int r = 0; r < b.row_count(); ++r) {
+                p.rows.push_back(b.row(r));
+            }
+        } while (_input.continue_index() > 0 && p.rows.size() < _max_rows);
+
+        return p;
+    } // fetch_page
+
+    // A GenQuery string containing "?" placeholders, parsed once. Each placeholder stands for a
+    // quoted literal in the WHERE clause. Binding values produces a ready-to-execute input without
+    // parsing the query string again.
+    class prepared_query
+    {
+    public:
+        explicit prepared_query(const std::string_view _query_template)
+            : selects_{}
+            , conditions_{}
+            , parameter_count_{}
+        {
+            // Replace each placeholder outside of a quoted literal with a marker literal so that the
+            // template can be parsed like any other query.
+            std::string query_string;
+            bool in_literal = false;
+
+            for (auto c : _query_template) {
+                if ('\'' == c) {
+                    in_literal = !in_literal;
+                }
+                else if ('?' == c && !in_literal) {
+                    query_string += fmt::format("'{}'", make_marker(parameter_count_++));
+                    continue;
+                }
+
+                query_string += c;
+            }
+
+            input parsed{query_string, 0};
+            const auto& select = parsed.get()->selectInp;
+            const auto& cond = parsed.get()->sqlCondInp;
+
+            for (int i = 0; i < select.len; ++i) {
+                selects_.emplace_back(select.inx[i], select.value[i]);
+            }
+
+            std::size_t markers_found = 0;
+
+            for (int i = 0; i < cond.len; ++i) {
+                auto& c = conditions_.emplace_back(condition_template{cond.inx[i], cond.value[i], {}});
+
+                // The marker offsets are recorded here so that bound values are never searched.
+                for (std::size_t p = 0; p < parameter_count_; ++p) {
+                    if (const auto pos = c.value.find(make_marker(p)); pos != std::string::npos) {
+                        c.markers.emplace_back(pos, p);
+                        ++markers_found;
+                    }
+                }
+
+                std::sort(std::begin(c.markers), std::end(c.markers));
+            }
+
+            if (markers_found != parameter_count_) {
+                THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Placeholders are only supported in the WHERE clause [{}]", _query_template));
+            }
+        }
+
+        auto parameter_count() const noexcept -> std::size_t
+        {
+            return parameter_count_;
+        }
+
+        // Fills _input with the parsed query and the bound values. Values may not contain single
+        // quotes because GenQuery literals cannot escape them.
+        auto bind(input& _input, const std::vector<std::string>& _values, int _options) const -> void
+        {
+            if (_values.size() != parameter_count_) {
+                THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Expected {} parameters, received {}", parameter_count_, _values.size()));
+            }
+
+            for (const auto& v : _values) {
+                if (v.find('\'') != std::string::npos) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Parameters may not contain single quotes");
+                }
+            }
+
+            auto* inp = _input.get();
+            inp->options = _options;
+
+            for (const auto& [inx, value] : selects_) {
+                addInxIval(&inp->selectInp, inx, value);
+            }
+
+            for (const auto& [inx, value, markers] : conditions_) {
+                std::string condition = value;
+
+                // Spliced right to left so that the recorded offsets stay valid.
+                for (auto m = std::rbegin(markers); m != std::rend(markers); ++m) {
+                    const auto& [pos, p] = *m;
+                    condition.replace(pos, make_marker(p).size(), _values[p]);
+                }
+
+                // Matches the behavior of upper-casing the query string for case-insensitive queries.
+                if (_options & UPPER_CASE_WHERE) {
+                    std::transform(std::begin(condition), std::end(condition), std::begin(condition), [](unsigned char c) {
+                        return std::toupper(c);
+                    });
+                }
+
+                addInxVal(&inp->sqlCondInp, inx, condition.c_str());
+            }
+        }
+
+    private:
+        static auto make_marker(std::size_t _index) -> std::string
+        {
+            return fmt::format("__IRODS_REST_PARAMETER_{}__", _index);
+        }
+
+        struct condition_template
+        {
+            int inx;
+            std::string value;
+            std::vector<std::pair<std::size_t, std::size_t>> markers; // Offset and parameter index.
+        }; // struct condition_template
+
+        std::vector<std::pair<int, int>> selects_;
+        std::vector<condition_template> conditions_;
+        std::size_t parameter_count_;
+    }; // class prepared_query
+
+    // Releases the server-side statement if it is still open.
+    inline auto close(RcComm& _comm, input& _input) noexcept -> void
+    {
+        auto* inp = _input.get();
+
+        if (inp->continueInx <= 0) {
+            return;
+        }
+
+        inp->maxRows = 0;
+
+        genQueryOut_t* output{};
+        metrics::invoke("rcGenQuery", rcGenQuery, &_comm, inp, &output);
+
+        if (output) {
+            freeGenQueryOut(&output);
+        }
+
+        inp->continueInx = 0;
+    } // close
+} // namespace irods::rest::genquery
+
+#endif // IRODS_REST_CPP_GENQUERY_HPP
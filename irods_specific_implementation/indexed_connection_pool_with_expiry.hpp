@@ -2,6 +2,7 @@
 #define IRODS_INDEXED_CONNECTION_POOL_HPP
 
 #include "configuration.hpp"
+#include "metrics.hpp"
 
 #include <irods/irods_exception.hpp>
 #include <irods/irods_random.hpp>
@@ -12,10 +13,15 @@
 #include "jwt.h"
 #include <fmt/format.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <map>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <chrono>
+#include <utility>
 
 namespace irods {
     namespace {
@@ -45,8 +51,8 @@ namespace irods {
                 const auto port = env.at("port").get<int>();
                 const char* zone = env.at("zone").get_ref<const std::string&>().data();
                 const char* rodsadmin_username = env.at("rodsadmin_username").get_ref<const std::string&>().data();
-                conn_ =
-                    _rcConnect(host, port, rodsadmin_username, zone, _client_name.c_str(), zone, &err_, 0, NO_RECONN);
+                conn_ = irods::rest::metrics::invoke(
+                    "rcConnect", _rcConnect, host, port, rodsadmin_username, zone, _client_name.c_str(), zone, &err_, 0, NO_RECONN);
             } // ctor
 
             connection_handle(
@@ -57,8 +63,8 @@ namespace irods {
                 const char* host = env.at("host").get_ref<const std::string&>().data();
                 const auto port = env.at("port").get<int>();
                 const char* zone = env.at("zone").get_ref<const std::string&>().data();
-                conn_ =
-                    _rcConnect(host, port, _proxy_name.c_str(), zone, _client_name.c_str(), zone, &err_, 0, NO_RECONN);
+                conn_ = irods::rest::metrics::invoke(
+                    "rcConnect", _rcConnect, host, port, _proxy_name.c_str(), zone, _client_name.c_str(), zone, &err_, 0, NO_RECONN);
             } // ctor
 
             virtual ~connection_handle()
@@ -88,13 +94,21 @@ namespace irods {
         bool                      in_use;
         bool                      evict_immediately;
         time_type                 access_time;
+        time_type                 pinned_until;
         connection_handle_pointer connection;
+        std::string               session_ticket;
+        std::mutex*               pool_mutex;
+        std::condition_variable*  released;
 
         connection_context()
             : in_use{false}
             , evict_immediately{false}
         , access_time{}
+        , pinned_until{}
         , connection{}
+        , session_ticket{}
+        , pool_mutex{nullptr}
+        , released{nullptr}
         {
             // ctor
         }
@@ -108,23 +122,78 @@ namespace irods {
     }
 
     class connection_proxy {
-        connection_context& ctx_;
+        connection_context* ctx_;
 
         public:
-            connection_proxy(connection_context& _ctx) : ctx_{_ctx}
+            connection_proxy(connection_context& _ctx) : ctx_{&_ctx}
             {
 
             } // connection_proxy
 
+            // Move-only. A copy would return the connection to the pool twice.
+            connection_proxy(connection_proxy&& _other) noexcept
+                : ctx_{std::exchange(_other.ctx_, nullptr)}
+            {
+            }
+
+            connection_proxy(const connection_proxy&) = delete;
+            auto operator=(const connection_proxy&) -> connection_proxy& = delete;
+            auto operator=(connection_proxy&&) -> connection_proxy& = delete;
+
             ~connection_proxy()
             {
-                ctx_.access_time = now_in_seconds();
-                ctx_.in_use = false;
+                if (!ctx_) {
+                    return;
+                }
+
+                // Once in_use is cleared, the pool may erase the context, so nothing may be read
+                // from it afterwards.
+                if (auto* released = ctx_->released; released) {
+                    {
+                        std::scoped_lock lk{*ctx_->pool_mutex};
+                        ctx_->access_time = now_in_seconds();
+                        ctx_->in_use = false;
+                    }
+
+                    released->notify_all();
+                    return;
+                }
+
+                ctx_->access_time = now_in_seconds();
+                ctx_->in_use = false;
             }
 
             auto operator()() -> rcComm_t*
             {
-                return ctx_.connection->get();
+                return ctx_->connection->get();
+            }
+
+            // Keeps the connection in the pool, regardless of the idle timeout, until
+            // the time point has passed. Used to keep server-side state (e.g. an open
+            // GenQuery statement) alive between requests.
+            auto pin_until(time_type _time) -> void
+            {
+                ctx_->pinned_until = _time;
+            }
+
+            // Releases a pin and evicts the connection as soon as it is returned.
+            auto unpin() -> void
+            {
+                ctx_->pinned_until = time_type{};
+                ctx_->evict_immediately = true;
+            }
+
+            // The session ticket applied to the connection, or an empty string. Remembered for
+            // the lifetime of the connection so that a pooled connection is not asked to apply
+            // the same ticket again.
+            auto session_ticket() const -> const std::string&
+            {
+                return ctx_->session_ticket;
+            }
+
+            auto set_session_ticket(std::string _ticket) -> void
+            {
+                ctx_->session_ticket = std::move(_ticket);
             }
 
     }; // connection_proxy
@@ -135,13 +204,18 @@ namespace irods {
         using sleep_type = std::chrono::duration<uint32_t>;
         using connection_pool_type = std::map<std::string, connection_context>;
 
-        std::mutex           pool_mutex_;
+        std::mutex              pool_mutex_;
+        std::condition_variable connection_released_;
         std::atomic_bool     exit_flag_{false};
         std::thread          life_time_manager_;
         time_type            max_idle_timeout_in_seconds_;
         sleep_type           sleep_time_;
         connection_pool_type pool_;
 
+        std::atomic<std::uint64_t> connections_created_{0};
+        std::atomic<std::uint64_t> connection_failures_{0};
+        std::atomic<std::uint64_t> connections_evicted_{0};
+
         auto manage_lifetimes() -> void
         {
             while(!exit_flag_) {
@@ -152,11 +226,12 @@ namespace irods {
                 while(!done) {
                     std::scoped_lock lk(pool_mutex_);
 
-                    if(!itr->second.in_use) {
+                    if(!itr->second.in_use && itr->second.pinned_until <= now_in_seconds()) {
                         // either the connection is old, or it is not to be kept
                         if(exp > itr->second.access_time || itr->second.evict_immediately) {
                             // release the connection
                             pool_.erase(itr);
+                            ++connections_evicted_;
 
                             // reset the iterator and start over
                             itr = pool_.begin();
@@ -179,23 +254,6 @@ namespace irods {
 
         } // manage_lifetimes
 
-        auto get_user_name_from_key(const std::string& _jwt) -> std::string
-        {
-            // decode the jwt
-            auto decoded = jwt::decode(_jwt);
-
-            const auto& signing_key = irods::rest::configuration::get_jwt_signing_key();
-
-            // verify the jwt
-            auto verifier =
-                jwt::verify().allow_algorithm(jwt::algorithm::hs256{signing_key}).with_issuer(keyword::issue_claim);
-            verifier.verify(decoded);
-
-            auto payload = decoded.get_payload_claims();
-
-            return payload[keyword::user_name].as_string();
-        } // get_user_name_from_key
-
         static auto save_rodsadmin_password_if_necessary() -> void
         {
             namespace irc = irods::rest::configuration;
@@ -211,23 +269,36 @@ namespace irods {
 
         auto make_connection(const std::string& _jwt) -> std::shared_ptr<connection_handle>
         {
-            auto user_name = get_user_name_from_key(_jwt);
+            return make_connection_for_user(get_user_name_from_key(_jwt));
+        } // make_connection
+
+        auto make_connection_for_user(const std::string& _user_name) -> std::shared_ptr<connection_handle>
+        {
+            const irods::rest::tracing::span span{"connection_pool.make_connection"};
 
-            auto conn = std::make_shared<connection_handle>(user_name);
+            try {
+                auto conn = std::make_shared<connection_handle>(_user_name);
 
-            // If we can't get the obfuscated password, the rodsadmin proxy user has not been authenticated.
-            // All currently supported authentication plugins require the obfuscated password file to exist
-            // when using clientLogin, so make sure this is done here before proceeding to authentication.
-            save_rodsadmin_password_if_necessary();
+                // If we can't get the obfuscated password, the rodsadmin proxy user has not been authenticated.
+                // All currently supported authentication plugins require the obfuscated password file to exist
+                // when using clientLogin, so make sure this is done here before proceeding to authentication.
+                save_rodsadmin_password_if_necessary();
 
-            auto err = clientLogin(conn->get());
-            if(err < 0) {
-                THROW(err, fmt::format("[{}] failed to login", user_name));
-            }
+                auto err = irods::rest::metrics::invoke("clientLogin", clientLogin, conn->get());
+                if(err < 0) {
+                    THROW(err, fmt::format("[{}] failed to login", _user_name));
+                }
 
-            return conn;
+                ++connections_created_;
 
-        } // make_connection
+                return conn;
+            }
+            catch(...) {
+                ++connection_failures_;
+                throw;
+            }
+
+        } // make_connection_for_user
 
         auto get_random_hint() -> std::string
         {
@@ -247,6 +318,16 @@ namespace irods {
 
              inline static const std::string do_not_cache_hint{"DO_NOT_CACHE_HINT"};
 
+             struct statistics
+             {
+                 std::size_t   connections;
+                 std::size_t   in_use;
+                 std::size_t   pinned;
+                 std::uint64_t created;
+                 std::uint64_t failures;
+                 std::uint64_t evicted;
+             }; // statistics
+
              indexed_connection_pool_with_expiry()
              : life_time_manager_(&indexed_connection_pool_with_expiry::manage_lifetimes, this)
              , max_idle_timeout_in_seconds_(std::chrono::seconds(default_idle_time_in_seconds))
@@ -269,6 +350,23 @@ namespace irods {
                  life_time_manager_.join();
              }
 
+             auto get_user_name_from_key(const std::string& _jwt) -> std::string
+             {
+                 // decode the jwt
+                 auto decoded = jwt::decode(_jwt);
+
+                 const auto& signing_key = irods::rest::configuration::get_jwt_signing_key();
+
+                 // verify the jwt
+                 auto verifier =
+                     jwt::verify().allow_algorithm(jwt::algorithm::hs256{signing_key}).with_issuer(keyword::issue_claim);
+                 verifier.verify(decoded);
+
+                 auto payload = decoded.get_payload_claims();
+
+                 return payload[keyword::user_name].as_string();
+             } // get_user_name_from_key
+
              auto set_idle_timeout(uint32_t _it) -> void
              {
                  max_idle_timeout_in_seconds_ = time_type{std::chrono::seconds(_it)};
@@ -298,17 +396,188 @@ namespace irods {
                  ctx.evict_immediately = do_not_cache_flag;
 
                  if(!ctx.connection.get()) {
-                     ctx.connection = make_connection(_jwt);
+                     try {
+                         ctx.connection = make_connection(_jwt);
+                         ctx.session_ticket.clear();
+                     }
+                     catch(...) {
+                         // Otherwise the entry stays in use without a connection and is never evicted.
+                         pool_.erase(key);
+                         throw;
+                     }
                  }
 
                  ctx.access_time = now_in_seconds();
 
-                 pool_[key] = ctx;
-
                  return connection_proxy{ctx};
 
              } // get
 
+             // Returns the first connection keyed by _jwt + _hint + [0, _count) which is not in use,
+             // so that a single request may use several connections of the same user concurrently.
+             // If all of them are in use, returns a connection which is released after use.
+             auto get_any(const std::string& _jwt, const std::string& _hint, std::size_t _count) -> connection_proxy
+             {
+                 if(auto conn = try_get_any(_jwt, _hint, _count); conn) {
+                     return std::move(*conn);
+                 }
+
+                 return get(_jwt, do_not_cache_hint);
+
+             } // get_any
+
+             // Returns one of _count connections of _user_name. Used for requests which carry no JWT,
+             // e.g. anonymous downloads with a ticket. The connections are shared by all such requests,
+             // so if all of them are in use, waits up to _timeout for one to be returned and then throws
+             // SYS_NOT_ALLOWED. Never creates more than _count connections.
+             auto get_any_for_user(const std::string& _user_name,
+                                   std::size_t _count,
+                                   std::chrono::milliseconds _timeout) -> connection_proxy
+             {
+                 // JWTs never contain '#', so these keys cannot collide with those of get_any.
+                 const auto prefix = "#" + _user_name + "#";
+                 const auto deadline = std::chrono::steady_clock::now() + _timeout;
+
+                 std::unique_lock lk(pool_mutex_);
+                 bool timed_out = false;
+
+                 while(true) {
+                     for(std::size_t i = 0; i < _count; ++i) {
+                         const auto key = prefix + std::to_string(i);
+                         auto& ctx = pool_[key];
+
+                         if(ctx.in_use) {
+                             continue;
+                         }
+
+                         ctx.in_use = true;
+                         ctx.evict_immediately = false;
+                         ctx.pool_mutex = &pool_mutex_;
+                         ctx.released = &connection_released_;
+
+                         if(!ctx.connection.get()) {
+                             // The slot stays reserved while in use, so the connection is made
+                             // without blocking requests for other connections.
+                             lk.unlock();
+
+                             try {
+                                 auto conn = make_connection_for_user(_user_name);
+                                 lk.lock();
+                                 ctx.connection = std::move(conn);
+                                 ctx.session_ticket.clear();
+                             }
+                             catch(...) {
+                                 lk.lock();
+                                 pool_.erase(key);
+                                 connection_released_.notify_all();
+                                 throw;
+                             }
+                         }
+
+                         ctx.access_time = now_in_seconds();
+
+                         return connection_proxy{ctx};
+                     }
+
+                     if(timed_out) {
+                         THROW(SYS_NOT_ALLOWED, "All anonymous connections are in use. Try again later.");
+                     }
+
+                     // Connections are returned under pool_mutex_, so no notification is missed.
+                     timed_out = std::cv_status::timeout == connection_released_.wait_until(lk, deadline);
+                 }
+
+             } // get_any_for_user
+
+             // Like get_any, but returns nothing instead of a new connection if all are in use.
+             auto try_get_any(const std::string& _jwt, const std::string& _hint, std::size_t _count)
+                 -> std::optional<connection_proxy>
+             {
+                 std::scoped_lock lk(pool_mutex_);
+
+                 for(std::size_t i = 0; i < _count; ++i) {
+                     auto hint = _hint + std::to_string(i);
+
+                     if(auto itr = pool_.find(_jwt + hint); pool_.end() == itr || !itr->second.in_use) {
+                         return get_locked(_jwt, hint);
+                     }
+                 }
+
+                 return std::nullopt;
+
+             } // try_get_any
+
+             // Returns the connection keyed by _jwt + _hint if it exists and is not in use. Never
+             // creates a connection.
+             auto try_get_existing(const std::string& _jwt, const std::string& _hint)
+                 -> std::optional<connection_proxy>
+             {
+                 std::scoped_lock lk(pool_mutex_);
+
+                 auto itr = pool_.find(_jwt + _hint);
+
+                 if(pool_.end() == itr || itr->second.in_use || !itr->second.connection) {
+                     return std::nullopt;
+                 }
+
+                 itr->second.in_use = true;
+                 itr->second.access_time = now_in_seconds();
+
+                 return connection_proxy{itr->second};
+
+             } // try_get_existing
+
+             auto get_statistics() -> statistics
+             {
+                 statistics stats{};
+
+                 {
+                     std::scoped_lock lk(pool_mutex_);
+
+                     const auto now = now_in_seconds();
+
+                     for(const auto& [key, ctx] : pool_) {
+                         ++stats.connections;
+                         stats.in_use += ctx.in_use ? 1 : 0;
+                         stats.pinned += (ctx.pinned_until > now) ? 1 : 0;
+                     }
+                 }
+
+                 stats.created = connections_created_;
+                 stats.failures = connection_failures_;
+                 stats.evicted = connections_evicted_;
+
+                 return stats;
+
+             } // get_statistics
+
+        private:
+
+             // Requires pool_mutex_ to be held.
+             auto get_locked(const std::string& _jwt, const std::string& _hint) -> connection_proxy
+             {
+                 auto& ctx = pool_[_jwt + _hint];
+
+                 ctx.in_use = true;
+                 ctx.evict_immediately = false;
+
+                 if(!ctx.connection.get()) {
+                     try {
+                         ctx.connection = make_connection(_jwt);
+                         ctx.session_ticket.clear();
+                     }
+                     catch(...) {
+                         pool_.erase(_jwt + _hint);
+                         throw;
+                     }
+                 }
+
+                 ctx.access_time = now_in_seconds();
+
+                 return connection_proxy{ctx};
+
+             } // get_locked
+
     }; // indexed_connection_pool_with_expiry
 
 } // namespace irods
@@ -2,6 +2,8 @@
 #define IRODS_REST_CPP_ADMIN_API_IMPLEMENTATION_H
 
 #include "irods_rest_api_base.h"
+#include "parallel.hpp"
+#include "utils.hpp"
 
 #include <irods/generalAdmin.h>
 #include <irods/rodsErrorTable.h>
@@ -11,21 +13,40 @@
 #include <pistache/router.h>
 
 #include <cstring>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace irods::rest
 {
     // this is contractually tied directly to the api implementation
     const std::string service_name{"irods_rest_cpp_admin_server"};
 
+    namespace
+    {
+        namespace configuration_keywords
+        {
+            const std::string batch_max_operations{"batch_maximum_number_of_operations"};
+            const std::string batch_parallelism{"batch_parallelism"};
+        } // namespace configuration_keywords
+    } // namespace
+
     class admin : public api_base
     {
     public:
         admin()
             : api_base{service_name}
         {
+            namespace keywords = configuration_keywords;
+
+            max_batch_size_ = get_configuration_option<std::size_t>(keywords::batch_max_operations, 1024);
+            batch_parallelism_ = std::max<std::size_t>(1, get_configuration_option<std::size_t>(keywords::batch_parallelism, 4));
+
             info("Endpoint initialized.");
         }
 
@@ -45,56 +66,235 @@ namespace irods::rest
 
                 auto conn = get_connection(_request.headers().getRaw("authorization").value());
 
-                const auto decoded_arg2 = decode_url(_arg2);
-                const auto decoded_arg4 = decode_url(_arg4);
-                const auto decoded_arg6 = decode_url(_arg6);
+                const operation op{std::move(_action),
+                                   std::move(_target),
+                                   decode_url(_arg2),
+                                   std::move(_arg3),
+                                   decode_url(_arg4),
+                                   std::move(_arg5),
+                                   decode_url(_arg6),
+                                   std::move(_arg7)};
+
+                service_account_password admin_password;
+
+                if (const auto ec = execute_operation(conn, op, admin_password); ec < 0) {
+                    error("Received error [{}] from rcGeneralAdmin.", ec);
+                    return make_error_response(ec, "Error on rcGeneralAdmin.");
+                }
+
+                return std::make_tuple(Pistache::Http::Code::Ok, SUCCESS);
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                return make_error_response(e.code(), e.what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // operator()
+
+        // Executes a JSON array of operations and returns one result per operation, in the
+        // order of the request. The password of the service account is read at most once.
+        std::tuple<Pistache::Http::Code, std::string>
+        batch(const Pistache::Rest::Request& _request,
+              Pistache::Http::ResponseWriter& _response)
+        {
+            try {
+                const auto auth_header = _request.headers().getRaw("authorization").value();
+                const auto ordered = is_set(_request.query().get("ordered").getOrElse("1"));
+                const auto continue_on_error = is_set(_request.query().get("continue-on-error").getOrElse("0"));
 
-                generalAdminInp_t input{};
-                std::string obfuscated_password;
+                const auto operations = nlohmann::json::parse(_request.body());
 
-                if (_action == "modify" && _target == "user" && _arg3 == "password") {
-                    // DO NOT print the user's password.
-                    debug("decoded arguments - _arg2=[{}], _arg6=[{}]", decoded_arg2, decoded_arg6);
+                if (!operations.is_array()) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Request body must be a JSON array of operations.");
+                }
 
-                    input.arg0 = _action.c_str();
-                    obfuscated_password = obfuscate_password(decoded_arg4);
-                    input.arg4 = obfuscated_password.c_str();
+                if (operations.size() > max_batch_size_) {
+                    THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Too many operations in batch: limit is {}.", max_batch_size_));
                 }
-                else {
-                    debug("decoded arguments - _arg2=[{}], _arg4=[{}], _arg6=[{}]",
-                          decoded_arg2, decoded_arg4, decoded_arg6);
 
-                    input.arg0 = (_action == "remove") ? "rm" : _action.c_str();
-                    input.arg4 = decoded_arg4.c_str();
+                // The new password is obfuscated with the session signature of the last login in
+                // the process, which only matches the connection of an ordered batch.
+                if (!ordered && std::any_of(std::begin(operations), std::end(operations), is_password_modification)) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Passwords can only be modified in ordered batches.");
                 }
 
-                input.arg1 = _target.c_str();
-                input.arg2 = decoded_arg2.c_str();
-                input.arg3 = _arg3.c_str();
-                input.arg5 = _arg5.c_str();
-                input.arg6 = decoded_arg6.c_str();
-                input.arg7 = _arg7.c_str();
+                std::vector<nlohmann::json> results(operations.size(), {{"status", "skipped"}});
+                std::atomic<bool> stop{false};
+                service_account_password admin_password;
 
-                trace("Invoking rcGeneralAdmin() ...");
+                const auto execute = [&](connection_proxy& _conn, std::size_t _i) {
+                    results[_i] = execute_batch_operation(_conn, operations[_i], admin_password);
 
-                if (const auto ec = rcGeneralAdmin(conn(), &input); ec < 0) {
-                    error("Received error [{}] from rcGeneralAdmin.", ec);
-                    return make_error_response(ec, "Error on rcGeneralAdmin.");
+                    if (!continue_on_error && "ok" != results[_i].at("status")) {
+                        stop = true;
+                    }
+                };
+
+                if (ordered) {
+                    auto conn = get_connection(auth_header);
+
+                    for (std::size_t i = 0; i < operations.size() && !stop; ++i) {
+                        execute(conn, i);
+                    }
+                }
+                else {
+                    for_each_index_in_parallel(operations.size(), batch_parallelism_, [&](std::size_t _i) {
+                        if (!stop) {
+                            auto conn = get_any_connection(auth_header, batch_connection_hint, batch_parallelism_);
+                            execute(conn, _i);
+                        }
+                    });
                 }
 
-                return std::make_tuple(Pistache::Http::Code::Ok, SUCCESS);
+                return std::make_tuple(Pistache::Http::Code::Ok, nlohmann::json(results).dump());
             }
             catch (const irods::exception& e) {
                 error("Caught exception - [error_code={}] {}", e.code(), e.what());
-                return make_error_response(e.code(), e.what());
+                return make_error_response(e.code(), e.client_display_what());
             }
             catch (const std::exception& e) {
                 error("Caught exception - {}", e.what());
                 return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
             }
-        } // operator()
+        } // batch
+
+    private:
+        // Prefix of the pooled connections used by unordered batches.
+        inline static const std::string batch_connection_hint{"admin_batch_"};
+
+        // The arguments of an rcGeneralAdmin call, without url encoding.
+        struct operation
+        {
+            std::string action;
+            std::string target;
+            std::string arg2;
+            std::string arg3;
+            std::string arg4;
+            std::string arg5;
+            std::string arg6;
+            std::string arg7;
+        };
 
-        std::string obfuscate_password(const std::string_view _new_password)
+        static auto is_password_modification(const nlohmann::json& _operation) -> bool
+        {
+            const auto equals = [&_operation](const char* _key, std::string_view _value) {
+                const auto iter = _operation.find(_key);
+                return iter != std::end(_operation) && iter->is_string() && iter->get_ref<const std::string&>() == _value;
+            };
+
+            return _operation.is_object() && equals("action", "modify") && equals("target", "user") && equals("arg3", "password");
+        } // is_password_modification
+
+        // The plain text password of the service account, read from .irodsA on first use and
+        // shared by every operation of a request.
+        class service_account_password
+        {
+        public:
+            auto get() -> const std::string&
+            {
+                std::call_once(once_, [this] {
+                    std::array<char, MAX_PASSWORD_LEN + 10> password{};
+
+                    // "obfGetPw" decodes the obfuscated password stored in .irods/.irodsA.
+                    if (obfGetPw(password.data()) != 0) {
+                        THROW(SYS_INTERNAL_ERR, "failed to unobfuscate admin password in .irodsA file.");
+                    }
+
+                    password_ = password.data();
+                });
+
+                return password_;
+            } // get
+
+        private:
+            std::once_flag once_;
+            std::string password_;
+        }; // class service_account_password
+
+        // Invokes rcGeneralAdmin and returns its result.
+        int execute_operation(connection_proxy& _conn, const operation& _op, service_account_password& _admin_password)
+        {
+            generalAdminInp_t input{};
+            std::string obfuscated_password;
+
+            if (_op.action == "modify" && _op.target == "user" && _op.arg3 == "password") {
+                // DO NOT print the user's password.
+                debug("decoded arguments - _arg2=[{}], _arg6=[{}]", _op.arg2, _op.arg6);
+
+                input.arg0 = _op.action.c_str();
+                obfuscated_password = obfuscate_password(_op.arg4, _admin_password.get());
+                input.arg4 = obfuscated_password.c_str();
+            }
+            else {
+                debug("decoded arguments - _arg2=[{}], _arg4=[{}], _arg6=[{}]", _op.arg2, _op.arg4, _op.arg6);
+
+                input.arg0 = (_op.action == "remove") ? "rm" : _op.action.c_str();
+                input.arg4 = _op.arg4.c_str();
+            }
+
+            input.arg1 = _op.target.c_str();
+            input.arg2 = _op.arg2.c_str();
+            input.arg3 = _op.arg3.c_str();
+            input.arg5 = _op.arg5.c_str();
+            input.arg6 = _op.arg6.c_str();
+            input.arg7 = _op.arg7.c_str();
+
+            trace("Invoking rcGeneralAdmin() ...");
+            return metrics::invoke("rcGeneralAdmin", rcGeneralAdmin, _conn(), &input);
+        } // execute_operation
+
+        // Executes one entry of a batch. Returns {"status": "ok"} or the error.
+        nlohmann::json execute_batch_operation(connection_proxy& _conn,
+                                               const nlohmann::json& _operation,
+                                               service_account_password& _admin_password)
+        {
+            const auto make_error_result = [](int _error_code, std::string_view _error_message) {
+                return nlohmann::json{{"status", "error"}, {"error_code", _error_code}, {"error_message", _error_message}};
+            };
+
+            try {
+                if (!_operation.is_object() || !_operation.contains("action") || !_operation.contains("target")) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Batch operation must be an object containing an action and a target.");
+                }
+
+                const auto arg = [&_operation](const std::string& _key) -> std::string {
+                    const auto iter = _operation.find(_key);
+
+                    if (iter == std::end(_operation)) {
+                        return "";
+                    }
+
+                    if (iter->is_number_integer()) {
+                        return std::to_string(iter->get<std::int64_t>());
+                    }
+
+                    return iter->get<std::string>();
+                };
+
+                const operation op{arg("action"), arg("target"), arg("arg2"), arg("arg3"),
+                                   arg("arg4"), arg("arg5"), arg("arg6"), arg("arg7")};
+
+                if (const auto ec = execute_operation(_conn, op, _admin_password); ec < 0) {
+                    error("Received error [{}] from rcGeneralAdmin.", ec);
+                    return make_error_result(ec, "Error on rcGeneralAdmin.");
+                }
+
+                return {{"status", "ok"}};
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception in batch operation - [error_code={}] {}", e.code(), e.what());
+                return make_error_result(e.code(), e.client_display_what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception in batch operation - {}", e.what());
+                return make_error_result(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // execute_batch_operation
+
+        std::string obfuscate_password(const std::string_view _new_password, const std::string& _admin_password)
         {
             std::array<char, MAX_PASSWORD_LEN + 10> plain_text_password{};
             std::strncpy(plain_text_password.data(), _new_password.data(), MAX_PASSWORD_LEN);
@@ -106,12 +306,7 @@ namespace irods::rest
             }
 
             std::array<char, MAX_PASSWORD_LEN + 10> admin_password{};
-
-            // Get the plain text password of the iRODS service account user.
-            // "obfGetPw" decodes the obfuscated password stored in .irods/.irodsA.
-            if (obfGetPw(admin_password.data()) != 0) {
-                THROW(SYS_INTERNAL_ERR, "failed to unobfuscate admin password in .irodsA file.");
-            }
+            std::strncpy(admin_password.data(), _admin_password.c_str(), MAX_PASSWORD_LEN);
 
             std::array<char, MAX_PASSWORD_LEN + 100> obfuscated_password{};
             obfEncodeByKeyV2(plain_text_password.data(),
@@ -121,6 +316,9 @@ namespace irods::rest
 
             return obfuscated_password.data();
         } // obfuscate_password
+
+        std::size_t max_batch_size_;
+        std::size_t batch_parallelism_;
     }; // class admin
 } // namespace irods::rest
 
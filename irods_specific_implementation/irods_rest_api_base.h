@@ -1,8 +1,15 @@
 #ifndef IRODS_REST_CPP_API_BASE_H
 #define IRODS_REST_CPP_API_BASE_H
 
+#include "codec.hpp"
+#include "compression.hpp"
 #include "configuration.hpp"
 #include "indexed_connection_pool_with_expiry.hpp"
+#include "json_writer.hpp"
+#include "metrics.hpp"
+#include "prefetch_buffer.hpp"
+#include "response_encoding.hpp"
+#include "tracing.hpp"
 
 #include <irods/rodsClient.h>
 #include <irods/rcConnect.h>
@@ -25,10 +32,15 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 using json = nlohmann::json;
 
@@ -50,7 +62,22 @@ namespace irods::rest
             const std::string timeout{"maximum_idle_timeout_in_seconds"};
             const std::string threads{"threads"};
             const std::string port{"port"};
+            const std::string metrics_port{"metrics_port"};
             const std::string log_level{"log_level"};
+            const std::string log_queue_size{"log_queue_size"};
+            const std::string log_overflow_report_interval{"log_overflow_report_interval_in_seconds"};
+            const std::string prefetch_ttl{"prefetch_time_to_live_in_seconds"};
+            const std::string prefetch_max_pages_per_user{"prefetch_maximum_number_of_pages_per_user"};
+            const std::string prefetch_report_interval{"prefetch_statistics_interval_in_seconds"};
+            const std::string response_compression{"response_compression"};
+            const std::string minimum_size_in_bytes{"minimum_size_in_bytes"};
+            const std::string gzip_level{"gzip_level"};
+            const std::string zstd_level{"zstd_level"};
+            const std::string tracing{"tracing"};
+            const std::string trace_file{"file"};
+            const std::string slow_request_threshold{"slow_request_threshold_in_milliseconds"};
+            const std::string maximum_number_of_spans{"maximum_number_of_spans_per_request"};
+            const std::string connections_per_ticket{"maximum_number_of_connections_per_ticket"};
         }
     } // namespace
 
@@ -59,7 +86,11 @@ namespace irods::rest
     public:
         api_base(const std::string& _service_name)
             : logger_{spdlog::get(_service_name)}
+            , service_name_{_service_name}
             , connection_pool_{}
+            , response_compression_{}
+            , connections_per_ticket_{}
+            , pool_metrics_{}
         {
             // sets the client name for the ips command
             setenv(SP_OPTION, _service_name.c_str(), 1);
@@ -73,6 +104,19 @@ namespace irods::rest
 
             connection_pool_.set_idle_timeout(it);
 
+            connections_per_ticket_ = std::max<std::size_t>(1, cfg.value(configuration_keywords::connections_per_ticket, std::size_t{4}));
+
+            // Responses are only compressed if the service is configured to do so.
+            if (const auto iter = cfg.find(configuration_keywords::response_compression); iter != cfg.end()) {
+                response_compression_.enabled = true;
+                response_compression_.minimum_size_in_bytes = iter->value(configuration_keywords::minimum_size_in_bytes, response_compression_.minimum_size_in_bytes);
+                response_compression_.gzip_level = iter->value(configuration_keywords::gzip_level, response_compression_.gzip_level);
+                response_compression_.zstd_level = iter->value(configuration_keywords::zstd_level, response_compression_.zstd_level);
+            }
+
+            register_pool_metrics();
+            configure_tracing(cfg);
+
             load_client_api_plugins();
         } // ctor
 
@@ -80,43 +124,69 @@ namespace irods::rest
         {
         } // dtor
 
+        auto response_compression() const noexcept -> const compression::settings&
+        {
+            return response_compression_;
+        } // response_compression
+
     protected:
         template <typename ...Args>
         void trace(fmt::format_string<Args...> _fmt, Args&&... _args) const
         {
-            logger_->trace(json{{"message", fmt::format(_fmt, std::forward<Args>(_args)...)}}.dump());
+            log(spdlog::level::trace, _fmt, std::forward<Args>(_args)...);
         } // trace
 
         template <typename ...Args>
         void debug(fmt::format_string<Args...> _fmt, Args&&... _args) const
         {
-            logger_->debug(json{{"message", fmt::format(_fmt, std::forward<Args>(_args)...)}}.dump());
+            log(spdlog::level::debug, _fmt, std::forward<Args>(_args)...);
         } // debug
 
         template <typename ...Args>
         void info(fmt::format_string<Args...> _fmt, Args&&... _args) const
         {
-            logger_->info(json{{"message", fmt::format(_fmt, std::forward<Args>(_args)...)}}.dump());
+            log(spdlog::level::info, _fmt, std::forward<Args>(_args)...);
         } // info
 
         template <typename ...Args>
         void warn(fmt::format_string<Args...> _fmt, Args&&... _args) const
         {
-            logger_->warn(json{{"message", fmt::format(_fmt, std::forward<Args>(_args)...)}}.dump());
+            log(spdlog::level::warn, _fmt, std::forward<Args>(_args)...);
         } // warn
 
         template <typename ...Args>
         void error(fmt::format_string<Args...> _fmt, Args&&... _args) const
         {
-            logger_->error(json{{"message", fmt::format(_fmt, std::forward<Args>(_args)...)}}.dump());
+            log(spdlog::level::err, _fmt, std::forward<Args>(_args)...);
         } // error
 
         template <typename ...Args>
         void critical(fmt::format_string<Args...> _fmt, Args&&... _args) const
         {
-            logger_->critical(json{{"message", fmt::format(_fmt, std::forward<Args>(_args)...)}}.dump());
+            log(spdlog::level::critical, _fmt, std::forward<Args>(_args)...);
         } // critical
 
+        // Formats the message only if the logger accepts _level. Messages are written as
+        // {"message": "..."} like they would be by nlohmann::json.
+        template <typename ...Args>
+        void log(spdlog::level::level_enum _level, fmt::format_string<Args...> _fmt, Args&&... _args) const
+        {
+            if (!logger_->should_log(_level)) {
+                return;
+            }
+
+            fmt::memory_buffer msg;
+            fmt::format_to(std::back_inserter(msg), _fmt, std::forward<Args>(_args)...);
+
+            std::string payload;
+            payload.reserve(msg.size() + 16);
+            payload += R"_({"message":)_";
+            json_writer::append_string(payload, {msg.data(), msg.size()});
+            payload += '}';
+
+            logger_->log(_level, payload);
+        } // log
+
         auto authenticate(const std::string& _user_name,
                           const std::string& _password,
                           const std::string& _auth_type) -> void
@@ -136,7 +206,7 @@ namespace irods::rest
             }
 
             auto conn = connection_handle(_user_name, _user_name);
-            const auto ec = clientLoginWithPassword(conn.get(), const_cast<char*>(_password.c_str()));
+            const auto ec = metrics::invoke("clientLoginWithPassword", clientLoginWithPassword, conn.get(), const_cast<char*>(_password.c_str()));
 
             if (ec < 0) {
                 THROW(ec, fmt::format("[{}] failed to login with type [{}]" , _user_name , _auth_type));
@@ -147,6 +217,73 @@ namespace irods::rest
                             const std::string& _hint = icp::do_not_cache_hint) -> connection_proxy
         {
             trace("Getting connection to iRODS server ...");
+
+            const auto jwt = extract_jwt(_header);
+
+            trace("Getting iRODS connection from pool ...");
+            auto conn = [this, &jwt, &_hint] {
+                const tracing::span span{"connection_pool.get"};
+                return connection_pool_.get(jwt, _hint);
+            }();
+            auto* ptr = conn();
+
+            trace("Invoking clientLogin() ...");
+            if (const int ec = metrics::invoke("clientLogin", clientLogin, ptr); ec < 0) {
+                THROW(ec, fmt::format("[{}] failed to login" , conn()->clientUser.userName));
+            }
+
+            trace("Returning connection ...");
+            return conn;
+        } // get_connection
+
+        // Returns one of up to _count pooled connections sharing the hint prefix _hint. Used when a
+        // single request executes several iRODS operations concurrently.
+        auto get_any_connection(const std::string& _header,
+                                const std::string& _hint,
+                                std::size_t _count) -> connection_proxy
+        {
+            trace("Getting any available iRODS connection from pool ...");
+            auto conn = [this, &_header, &_hint, _count] {
+                const tracing::span span{"connection_pool.get_any"};
+                return connection_pool_.get_any(extract_jwt(_header), _hint, _count);
+            }();
+
+            if (const int ec = metrics::invoke("clientLogin", clientLogin, conn()); ec < 0) {
+                THROW(ec, fmt::format("[{}] failed to login" , conn()->clientUser.userName));
+            }
+
+            return conn;
+        } // get_any_connection
+
+        // Like get_any_connection, but returns nothing if all of the connections are in use.
+        auto try_get_idle_connection(const std::string& _header,
+                                     const std::string& _hint,
+                                     std::size_t _count) -> std::optional<connection_proxy>
+        {
+            auto conn = [this, &_header, &_hint, _count] {
+                const tracing::span span{"connection_pool.try_get_any"};
+                return connection_pool_.try_get_any(extract_jwt(_header), _hint, _count);
+            }();
+
+            if (conn) {
+                if (const int ec = metrics::invoke("clientLogin", clientLogin, (*conn)()); ec < 0) {
+                    THROW(ec, fmt::format("[{}] failed to login" , (*conn)()->clientUser.userName));
+                }
+            }
+
+            return conn;
+        } // try_get_idle_connection
+
+        // Returns the pooled connection of the JWT _jwt for _hint if it exists and is not in use.
+        // Never creates a connection. Used to release server-side state held by a connection.
+        auto try_get_pooled_connection(const std::string& _jwt, const std::string& _hint)
+            -> std::optional<connection_proxy>
+        {
+            return connection_pool_.try_get_existing(_jwt, _hint);
+        } // try_get_pooled_connection
+
+        auto extract_jwt(const std::string& _header) const -> std::string
+        {
             trace("Extracting JWT from authorization header ...");
 
             // remove Authorization: from the string, the key is the
@@ -161,54 +298,93 @@ namespace irods::rest
                     [](unsigned char x) { return std::isspace(x); }),
                 jwt.end());
 
-            trace("Getting iRODS connection from pool ...");
-            auto conn = connection_pool_.get(jwt, _hint);
-            auto* ptr = conn();
+            return jwt;
+        } // extract_jwt
 
-            trace("Invoking clientLogin() ...");
-            if (const int ec = clientLogin(ptr); ec < 0) {
-                THROW(ec, fmt::format("[{}] failed to login" , conn()->clientUser.userName));
+        // Returns the name of the user identified by the JWT in the authorization header.
+        // The JWT is verified, so the result is safe to use for partitioning per-user state.
+        auto get_user_name(const std::string& _header) -> std::string
+        {
+            return connection_pool_.get_user_name_from_key(extract_jwt(_header));
+        } // get_user_name
+
+        // Returns the value of the option \p _key from the service's configuration or
+        // \p _default if the option is not set.
+        template <typename T>
+        auto get_configuration_option(const std::string& _key, T _default) const -> T
+        {
+            const auto& cfg = irods::rest::configuration::rest_service(service_name_);
+
+            if (const auto iter = cfg.find(_key); iter != cfg.end()) {
+                return iter->get<T>();
             }
 
-            trace("Returning connection ...");
-            return conn;
-        } // get_connection
+            return _default;
+        } // get_configuration_option
+
+        // Enables _buffer if a prefetch time-to-live is configured for the service. The hit and
+        // waste rates are logged periodically.
+        template <typename Value>
+        auto configure_prefetch(prefetch_buffer<Value>& _buffer) -> void
+        {
+            namespace keywords = configuration_keywords;
+
+            const auto ttl = get_configuration_option<std::uint32_t>(keywords::prefetch_ttl, 0);
+
+            if (0 == ttl) {
+                return;
+            }
+
+            const auto max_pages = get_configuration_option<std::size_t>(keywords::prefetch_max_pages_per_user, 2);
+            const auto interval = get_configuration_option<std::uint32_t>(keywords::prefetch_report_interval, 60);
+
+            _buffer.enable(std::chrono::seconds{ttl}, max_pages, std::chrono::seconds{interval}, [this](const auto& _stats) {
+                const auto lookups = _stats.hits + _stats.misses;
+                const auto hit_rate = lookups > 0 ? static_cast<double>(_stats.hits) / lookups : 0.0;
+                const auto waste_rate = _stats.scheduled > 0 ? static_cast<double>(_stats.wasted) / _stats.scheduled : 0.0;
+
+                info("Prefetch statistics: scheduled={} dropped={} hits={} misses={} wasted={} hit_rate={:.3f} waste_rate={:.3f}",
+                     _stats.scheduled, _stats.dropped, _stats.hits, _stats.misses, _stats.wasted, hit_rate, waste_rate);
+            });
+
+            _buffer.register_metrics();
+
+            info("Prefetch enabled [time_to_live={}s].", ttl);
+        } // configure_prefetch
 
         std::string decode_url(const std::string& _in) const
         {
             // Disabled so that sensitive input arguments aren't written to the log file.
             //trace("Decoding input [{}] ...", _in);
 
-            std::string out;
-            out.reserve(_in.size());
-
-            for (std::size_t i = 0; i < _in.size(); ++i) {
-                if (_in[i] == '%') {
-                    if (i + 3 <= _in.size()) {
-                        int value = 0;
-                        std::istringstream is(_in.substr(i + 1, 2));
-                        if (is >> std::hex >> value) {
-                            out += static_cast<char>(value);
-                            i += 2;
-                        }
-                        else {
-                            THROW(SYS_INVALID_INPUT_PARAM, "Failed to decode URL");
-                        }
-                    }
-                    else {
-                        THROW(SYS_INVALID_INPUT_PARAM, "Failed to decode URL");
-                    }
-                }
-                else if (_in[i] == '+') {
-                    out += ' ';
-                }
-                else {
-                    out += _in[i];
-                }
+            return codec::percent_decode(_in);
+        } // decode_url
+
+        // Returns a connection for a request which may carry an irods-ticket header. Requests
+        // carrying a ticket share a few pooled connections reserved for that ticket, so that the
+        // ticket is usually already applied to the connection they receive.
+        auto get_connection_for_session_ticket(const Pistache::Http::Header::Collection& _headers) -> connection_proxy
+        {
+            const auto auth_header = _headers.getRaw("authorization").value();
+
+            if (const auto h = _headers.tryGetRaw("irods-ticket"); !h.isEmpty()) {
+                return get_any_connection(auth_header, fmt::format("ticket_{}_", h.get().value()), connections_per_ticket_);
             }
 
-            return out;
-        } // decode_url
+            return get_connection(auth_header);
+        } // get_connection_for_session_ticket
+
+        // Returns one of the _count connections of _user_name shared by requests which carry a
+        // ticket instead of a JWT. The ticket is applied by set_session_ticket_if_available. Throws
+        // SYS_NOT_ALLOWED if all of them stay in use for longer than _timeout.
+        auto get_connection_for_anonymous_ticket(const std::string& _user_name,
+                                                 std::size_t _count,
+                                                 std::chrono::milliseconds _timeout) -> connection_proxy
+        {
+            trace("Getting iRODS connection for anonymous ticket access ...");
+            const tracing::span span{"connection_pool.get_any_for_user"};
+            return connection_pool_.get_any_for_user(_user_name, _count, _timeout);
+        } // get_connection_for_anonymous_ticket
 
         int set_session_ticket_if_available(const Pistache::Http::Header::Collection& _headers,
                                             connection_proxy& _conn)
@@ -216,16 +392,28 @@ namespace irods::rest
             trace("Setting session ticket if available ...");
 
             if (const auto h = _headers.tryGetRaw("irods-ticket"); !h.isEmpty()) {
+                const auto ticket = h.get().value();
+
+                if (_conn.session_ticket() == ticket) {
+                    trace("Session ticket already applied to connection.");
+                    return 0;
+                }
+
                 ticketAdminInp_t input{};
                 input.arg1 = const_cast<char*>("session");
-                input.arg2 = const_cast<char*>(h.get().value().data());
+                input.arg2 = const_cast<char*>(ticket.data());
                 input.arg3 = const_cast<char*>("");
                 input.arg4 = const_cast<char*>("");
                 input.arg5 = const_cast<char*>("");
                 input.arg6 = const_cast<char*>("");
 
                 trace("Invoking rcTicketAdmin() ...");
-                return rcTicketAdmin(_conn(), &input);
+                const auto ec = metrics::invoke("rcTicketAdmin", rcTicketAdmin, _conn(), &input);
+
+                // A failed attempt may leave the previous ticket in an unknown state.
+                _conn.set_session_ticket(ec < 0 ? "" : ticket);
+
+                return ec;
             }
             else {
                 trace("No session ticket information available.");
@@ -241,7 +429,9 @@ namespace irods::rest
             const auto& user = _conn()->clientUser;
 
             try {
-                const auto type = adm::client::type(*_conn(), adm::user{user.userName, user.rodsZone});
+                const auto type = metrics::invoke("user_type", [&_conn, &user] {
+                    return adm::client::type(*_conn(), adm::user{user.userName, user.rodsZone});
+                });
 
                 if (type && adm::user_type::rodsadmin != *type) {
                     if (std::strlen(user.rodsZone) > 0) {
@@ -267,9 +457,65 @@ namespace irods::rest
         }
 
         std::shared_ptr<spdlog::logger> logger_;
+        const std::string service_name_;
 
     private:
+        // Exposes the occupancy of the connection pool and how often connections are created,
+        // fail to be created and are evicted.
+        auto register_pool_metrics() -> void
+        {
+            auto& r = metrics::registry::instance();
+
+            const auto add = [this, &r](std::string_view _name, std::string_view _help, metrics::metric_type _type, metrics::label_list _labels, auto _fn) {
+                pool_metrics_.push_back(r.add_callback(_name, _help, _type, _labels, [this, _fn] {
+                    return static_cast<double>(_fn(connection_pool_.get_statistics()));
+                }));
+            };
+
+            constexpr auto* connections_help = "Pooled iRODS connections, by state.";
+            using stats = icp::statistics;
+
+            add("irods_rest_connection_pool_connections", connections_help, metrics::metric_type::gauge, {{"state", "in_use"}},
+                [](const stats& _s) { return _s.in_use; });
+            add("irods_rest_connection_pool_connections", connections_help, metrics::metric_type::gauge, {{"state", "idle"}},
+                [](const stats& _s) { return _s.connections - _s.in_use; });
+            add("irods_rest_connection_pool_connections", connections_help, metrics::metric_type::gauge, {{"state", "pinned"}},
+                [](const stats& _s) { return _s.pinned; });
+            add("irods_rest_connection_pool_connections_created_total", "iRODS connections created and authenticated.",
+                metrics::metric_type::counter, {}, [](const stats& _s) { return _s.created; });
+            add("irods_rest_connection_pool_connection_failures_total", "iRODS connections which could not be created or authenticated.",
+                metrics::metric_type::counter, {}, [](const stats& _s) { return _s.failures; });
+            add("irods_rest_connection_pool_evictions_total", "Idle iRODS connections closed by the pool.",
+                metrics::metric_type::counter, {}, [](const stats& _s) { return _s.evicted; });
+        } // register_pool_metrics
+
+        // Requests are traced if the service's configuration contains a "tracing" object.
+        auto configure_tracing(const nlohmann::json& _cfg) -> void
+        {
+            namespace keywords = configuration_keywords;
+
+            const auto iter = _cfg.find(keywords::tracing);
+
+            if (iter == _cfg.end()) {
+                return;
+            }
+
+            tracing::settings settings;
+            settings.file = iter->value(keywords::trace_file, settings.file);
+            settings.slow_request_threshold = std::chrono::milliseconds{iter->value(keywords::slow_request_threshold, 0)};
+            settings.maximum_number_of_spans_per_request = iter->value(keywords::maximum_number_of_spans, settings.maximum_number_of_spans_per_request);
+
+            info("Tracing enabled [file={}, slow_request_threshold={}ms].", settings.file, settings.slow_request_threshold.count());
+
+            tracing::tracer::instance().enable(service_name_, std::move(settings));
+        } // configure_tracing
+
         icp connection_pool_;
+        compression::settings response_compression_;
+        std::size_t connections_per_ticket_;
+
+        // Declared after the pool so that the callbacks are removed before it is destroyed.
+        std::vector<metrics::callback_registration> pool_metrics_;
     }; // class api_base
 } // namespace irods::rest
 
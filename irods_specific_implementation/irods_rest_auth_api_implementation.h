@@ -59,56 +59,6 @@ namespace irods::rest
             THROW(SYS_INVALID_INPUT_PARAM, fmt::format("invalid Authorization Header {}", _h));
         }
 
-        auto base64_decode(const std::string& _in)
-        {
-            static constexpr unsigned char table[] = {
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 62, 64, 64, 64, 63,
-                52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 64, 64, 64, 64, 64, 64,
-                64,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-                15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 64, 64, 64, 64, 64,
-                64, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-                41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-                64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64
-            };
-
-            auto in_len = _in.size();
-
-            if (in_len % 4 != 0) {
-                THROW(SYS_INVALID_INPUT_PARAM, "input is not a multiple of 4");
-            }
-
-            auto out_len = in_len / 4 * 3;
-
-            if (_in[in_len - 1] == '=') { --out_len; }
-            if (_in[in_len - 2] == '=') { --out_len; }
-
-            std::string out;
-            out.resize(out_len);
-
-            for (size_t i = 0, j = 0; i < in_len;) {
-                auto a = (_in[i] == '=') ? uint32_t{0} & i++ : table[static_cast<uint32_t>(_in[i++])];
-                auto b = (_in[i] == '=') ? uint32_t{0} & i++ : table[static_cast<uint32_t>(_in[i++])];
-                auto c = (_in[i] == '=') ? uint32_t{0} & i++ : table[static_cast<uint32_t>(_in[i++])];
-                auto d = (_in[i] == '=') ? uint32_t{0} & i++ : table[static_cast<uint32_t>(_in[i++])];
-                auto t = (a << 3 * 6) + (b << 2 * 6) + (c << 1 * 6) + (d << 0 * 6);
-
-                if (j < out_len) { out[j++] = (t >> 2 * 8) & 0xFF; }
-                if (j < out_len) { out[j++] = (t >> 1 * 8) & 0xFF; }
-                if (j < out_len) { out[j++] = (t >> 0 * 8) & 0xFF; }
-            } // for i
-
-            return out;
-        } // base64_decode
-
         auto parse_header(const std::string _header) -> std::tuple<std::string, std::string>
         {
             trace("Parsing header ...");
@@ -138,7 +88,7 @@ namespace irods::rest
 
             const auto [auth_type, token] = parse_header(_header);
 
-            auto creds = base64_decode(token);
+            auto creds = codec::base64_decode(token);
             auto user_name = creds.substr(0, creds.find_first_of(":"));
             auto password = creds.substr(creds.find_first_of(":") + 1);
 
@@ -4,12 +4,15 @@
 #include "irods_rest_api_base.h"
 
 #include "constants.hpp"
+#include "json_writer.hpp"
 #include <irods/filesystem.hpp>
 #include <irods/rodsErrorTable.h>
 
 #include <pistache/router.h>
 
+#include <algorithm>
 #include <fstream>
+#include <optional>
 #include <variant>
 
 namespace irods::rest {
@@ -27,6 +30,8 @@ namespace irods::rest {
         list()
             : api_base{service_name}
         {
+            configure_prefetch(prefetch_);
+
             info("Endpoint initialized.");
         }
 
@@ -45,37 +50,118 @@ namespace irods::rest {
                 auto _recursive    = _request.query().get("recursive").getOrElse("0");
                 // clang-format on
 
-                auto conn = get_connection(_request.headers().getRaw("authorization").value());
+                const auto auth_header = _request.headers().getRaw("authorization").value();
+                const auto user_name = get_user_name(auth_header);
 
-                std::string logical_path{decode_url(_logical_path)};
-                intmax_t limit_counter{0};
-                intmax_t offset_counter{0};
-                const intmax_t offset = std::stoi(_offset);
-                const intmax_t limit  = std::stoi(_limit);
+                const page_request page{_logical_path, _stat, _permissions, _metadata, _offset, _limit, _recursive, negotiate_response_encoding(_request)};
 
-                // clang-format off
-                const bool stat        = ("1" == _stat);
-                const bool permissions = ("1" == _permissions);
-                const bool metadata    = ("1" == _metadata);
-                const bool recursive   = ("1" == _recursive);
-                // clang-format on
+                auto result = prefetch_.take(user_name, make_prefetch_key(page));
 
-                nlohmann::json objects = nlohmann::json::array();
+                if (result) {
+                    trace("Serving prefetched page.");
+                }
+                else {
+                    auto conn = get_connection(auth_header);
+                    result = make_page(conn, page);
+                }
 
-                fsp start_path{logical_path};
+                // Clients usually follow the "next" link right away.
+                const auto limit = std::stoll(_limit);
+                if (Pistache::Http::Code::Ok == result->code && limit > 0 && result->entry_count == static_cast<std::size_t>(limit)) {
+                    prefetch_next_page(user_name, auth_header, page);
+                }
 
-                if (fcli::is_data_object(*conn(), start_path)) {
-                    const auto object_status = fcli::status(*conn(), start_path);
+                if (Pistache::Http::Code::Ok == result->code) {
+                    set_response_encoding(_response, page.encoding);
+                }
+
+                return std::make_tuple(result->code, std::move(result->body));
+            }
+            catch (const fs::filesystem_error& e) {
+                error("Caught exception - [error_code={}] {}", e.code().value(), e.what());
+                return make_error_response(e.code().value(), e.what());
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                return make_error_response(e.code(), e.what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // operator()
+
+    private:
+        // The parameters identifying a page of /list results, as received.
+        struct page_request
+        {
+            std::string logical_path;
+            std::string stat;
+            std::string permissions;
+            std::string metadata;
+            std::string offset;
+            std::string limit;
+            std::string recursive;
+            response_encoding encoding;
+        }; // struct page_request
+
+        struct page_response
+        {
+            Pistache::Http::Code code;
+            std::string body;
+            std::size_t entry_count;
+        }; // struct page_response
+
+        // Prefix of the pooled connection used to prefetch pages.
+        inline static const std::string prefetch_connection_hint{"list_prefetch_"};
+
+        auto make_page(connection_proxy& conn, const page_request& _page) -> page_response
+        {
+            const auto& [_logical_path, _stat, _permissions, _metadata, _offset, _limit, _recursive, _encoding] = _page;
+
+            std::string logical_path{decode_url(_logical_path)};
+            intmax_t limit_counter{0};
+            intmax_t offset_counter{0};
+            const intmax_t offset = std::stoi(_offset);
+            const intmax_t limit  = std::stoi(_limit);
 
-                    nlohmann::json obj_info = nlohmann::json::object();
-                    obj_info["type"] = type_to_string.at(object_status.type());
-                    obj_info["logical_path"] = start_path.string();
+            // clang-format off
+            const bool stat        = ("1" == _stat);
+            const bool permissions = ("1" == _permissions);
+            const bool metadata    = ("1" == _metadata);
+            const bool recursive   = ("1" == _recursive);
+            // clang-format on
 
-                    if (stat) { aggregate_stat_information(*conn(), obj_info, start_path); }
-                    if (permissions) { aggregate_permissions_information(obj_info, object_status.permissions()); }
-                    if (metadata) { aggregate_metadata_information(*conn(), obj_info, start_path); }
+            std::size_t entry_count = 0;
+            std::optional<page_response> failure;
 
-                    objects.push_back(obj_info);
+            constexpr auto* url_part = "/list?logical-path={}&stat={}&permissions={}&metadata={}&offset={}&limit={}";
+            const auto make_link = [&](const auto& _link_offset) {
+                return base_url + fmt::format(url_part, _logical_path, _stat, _permissions, _metadata, _link_offset, _limit);
+            };
+
+            auto body = write_document(_encoding, [&, this](auto& writer) {
+                // Keys are written in sorted order to match the output of nlohmann::json.
+                writer.begin_object().key("_embedded").begin_array();
+
+                const auto write_entry = [&, this](const fs::path& _path, const fs::object_status& _status) {
+                    writer.begin_object();
+                    writer.member("logical_path", _path.c_str());
+
+                    if (metadata) { write_metadata_information(*conn(), writer, _path); }
+                    if (permissions) { write_permissions_information(writer, _status.permissions()); }
+                    if (stat) { write_stat_information(*conn(), writer, _path); }
+
+                    writer.member("type", type_to_string.at(_status.type()));
+                    writer.end_object();
+
+                    ++entry_count;
+                };
+
+                fsp start_path{logical_path};
+
+                if (fcli::is_data_object(*conn(), start_path)) {
+                    write_entry(start_path, fcli::status(*conn(), start_path));
                 }
                 else if (fcli::is_collection(*conn(), start_path)) {
                     std::variant<fcli::collection_iterator, fcli::recursive_collection_iterator> itr_v;
@@ -88,7 +174,7 @@ namespace irods::rest {
 
                     try {
                         std::visit(
-                            [&, this](const auto& itr) {
+                            [&](const auto& itr) {
                                 for (const auto& p : itr) {
                                     // skip earlier entries for paging
                                     if (offset > 0 && offset_counter < offset) {
@@ -96,23 +182,7 @@ namespace irods::rest {
                                         continue;
                                     }
 
-                                    const auto object_status = fcli::status(*conn(), p.path());
-
-                                    nlohmann::json obj_info = nlohmann::json::object();
-                                    obj_info["type"] = type_to_string.at(object_status.type());
-                                    obj_info["logical_path"] = p.path().c_str();
-
-                                    if (stat) {
-                                        aggregate_stat_information(*conn(), obj_info, p.path());
-                                    }
-                                    if (permissions) {
-                                        aggregate_permissions_information(obj_info, object_status.permissions());
-                                    }
-                                    if (metadata) {
-                                        aggregate_metadata_information(*conn(), obj_info, p.path());
-                                    }
-
-                                    objects.push_back(obj_info);
+                                    write_entry(p.path(), fcli::status(*conn(), p.path()));
 
                                     ++limit_counter;
                                     if (limit > 0 && limit_counter >= limit) {
@@ -124,75 +194,78 @@ namespace irods::rest {
                     }
                     catch (const irods::exception& e) {
                         error("Caught exception - [error_code={}] {}", e.code(), e.what());
-                        return make_error_response(e.code(), e.client_display_what());
+                        auto [code, msg] = make_error_response(e.code(), e.client_display_what());
+                        failure = page_response{code, std::move(msg), 0};
+                        return;
                     }
                 }
                 else {
                     const auto msg = fmt::format("Logical path [{}] is not accessible.", logical_path);
                     error(fmt::runtime(msg));
-                    return make_error_response(SYS_INVALID_INPUT_PARAM, msg);
+                    auto [code, error_msg] = make_error_response(SYS_INVALID_INPUT_PARAM, msg);
+                    failure = page_response{code, std::move(error_msg), 0};
+                    return;
                 }
 
-                nlohmann::json results = nlohmann::json::object();
-                results["_embedded"] = objects;
-
-                nlohmann::json links = nlohmann::json::object();
-                constexpr auto* url_part = "/list?logical-path={}&stat={}&permissions={}&metadata={}&offset={}&limit={}";
-                links["self"] = base_url + fmt::format(url_part
-                                , _logical_path
-                                , _stat
-                                , _permissions
-                                , _metadata
-                                , _offset
-                                , _limit);
-                links["first"] = base_url + fmt::format(url_part
-                                , _logical_path
-                                , _stat
-                                , _permissions
-                                , _metadata
-                                , "0"
-                                , _limit);
-                links["last"] = base_url + fmt::format(url_part
-                                , _logical_path
-                                , _stat
-                                , _permissions
-                                , _metadata
-                                , "UNSUPPORTED"
-                                , _limit);
-                links["next"] = base_url + fmt::format(url_part
-                                , _logical_path
-                                , _stat
-                                , _permissions
-                                , _metadata
-                                , std::to_string(offset+limit)
-                                , _limit);
-                links["prev"] = base_url + fmt::format(url_part
-                                , _logical_path
-                                , _stat
-                                , _permissions
-                                , _metadata
-                                , std::to_string(std::max((intmax_t) 0, offset - limit))
-                                , _limit);
-
-                results["_links"] = links;
-
-                return std::make_tuple(Pistache::Http::Code::Ok, results.dump());
-            }
-            catch (const fs::filesystem_error& e) {
-                error("Caught exception - [error_code={}] {}", e.code().value(), e.what());
-                return make_error_response(e.code().value(), e.what());
-            }
-            catch (const irods::exception& e) {
-                error("Caught exception - [error_code={}] {}", e.code(), e.what());
-                return make_error_response(e.code(), e.what());
+                writer.end_array();
+
+                writer.key("_links").begin_object();
+                writer.member("first", make_link("0"));
+                writer.member("last", make_link("UNSUPPORTED"));
+                writer.member("next", make_link(offset + limit));
+                writer.member("prev", make_link(std::max((intmax_t) 0, offset - limit)));
+                writer.member("self", make_link(_offset));
+                writer.end_object();
+
+                writer.end_object();
+            });
+
+            if (failure) {
+                return std::move(*failure);
             }
-            catch (const std::exception& e) {
-                error("Caught exception - {}", e.what());
-                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+
+            return page_response{Pistache::Http::Code::Ok, std::move(body), entry_count};
+        } // make_page
+
+        auto make_prefetch_key(const page_request& _page) const -> std::string
+        {
+            return fmt::format("{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{}",
+                               decode_url(_page.logical_path),
+                               _page.stat,
+                               _page.permissions,
+                               _page.metadata,
+                               std::stoll(_page.offset),
+                               std::stoll(_page.limit),
+                               _page.recursive,
+                               static_cast<int>(_page.encoding));
+        } // make_prefetch_key
+
+        // Computes the page following _page in the background on an idle pooled connection.
+        auto prefetch_next_page(const std::string& _user_name, const std::string& _auth_header, page_request _page)
+            -> void
+        {
+            if (!prefetch_.enabled()) {
+                return;
             }
-        } // operator()
 
-    private:
+            _page.offset = std::to_string(std::stoll(_page.offset) + std::stoll(_page.limit));
+
+            prefetch_.schedule(_user_name, make_prefetch_key(_page), [this, _auth_header, _page]() -> std::optional<page_response> {
+                auto conn = try_get_idle_connection(_auth_header, prefetch_connection_hint, 1);
+
+                if (!conn) {
+                    trace("Skipping prefetch. No idle connection available.");
+                    return std::nullopt;
+                }
+
+                if (auto page = make_page(*conn, _page); Pistache::Http::Code::Ok == page.code) {
+                    return page;
+                }
+
+                return std::nullopt;
+            });
+        } // prefetch_next_page
+
         const std::map<irods::experimental::filesystem::perms, std::string> perm_to_string = {
             {irods::experimental::filesystem::perms::null,  "null"},
             {irods::experimental::filesystem::perms::read,  "read"},
@@ -209,52 +282,70 @@ namespace irods::rest {
             {irods::experimental::filesystem::object_type::unknown,            "unknown"},
         };
 
-        void aggregate_stat_information(rcComm_t& _comm,
-                                        nlohmann::json& _obj_info,
-                                        const fs::path& _path)
+        template <typename Writer>
+        void write_stat_information(rcComm_t& _comm, Writer& _writer, const fs::path& _path)
         {
-            auto stat_info = nlohmann::json::object();
+            using clock_type = std::chrono::system_clock;
+            const auto last_write_time = clock_type::to_time_t(fcli::last_write_time(_comm, _path));
+
+            _writer.key("status_information").begin_object();
+            _writer.member("last_write_time", std::to_string(last_write_time));
 
             // Only a data object has a size associated with it.
             if (fcli::is_data_object(_comm, _path)) {
-                stat_info["size"] = fcli::data_object_size(_comm, _path);
+                _writer.member("size", fcli::data_object_size(_comm, _path));
             }
 
-            using clock_type = std::chrono::system_clock;
-            const auto last_write_time = clock_type::to_time_t(fcli::last_write_time(_comm, _path));
-            stat_info["last_write_time"] = std::to_string(last_write_time);
-
-            _obj_info["status_information"] = stat_info;
-        } // aggregate_stat_information
+            _writer.end_object();
+        } // write_stat_information
 
-        void aggregate_permissions_information(nlohmann::json& _obj_info,
-                                               const std::vector<fs::entity_permission>& _perms)
+        template <typename Writer>
+        void write_permissions_information(Writer& _writer, const std::vector<fs::entity_permission>& _perms)
         {
-            auto perm_info = nlohmann::json::object();
+            // Entries are keyed by name. Like a JSON object, the last permission listed for a
+            // name wins and names are written in sorted order.
+            std::vector<const fs::entity_permission*> perms;
+            perms.reserve(_perms.size());
 
             for (auto&& p : _perms) {
-                perm_info[p.name] = perm_to_string.at(p.prms);
+                perms.push_back(&p);
             }
 
-            _obj_info["permission_information"] = perm_info;
-        } // aggregate_permissions_information
+            std::stable_sort(std::begin(perms), std::end(perms), [](const auto* _l, const auto* _r) {
+                return _l->name < _r->name;
+            });
+
+            _writer.key("permission_information").begin_object();
 
-        void aggregate_metadata_information(rcComm_t& _comm,
-                                            nlohmann::json& _obj_info,
-                                            const fs::path& _path)
+            for (std::size_t i = 0; i < perms.size(); ++i) {
+                if (i + 1 < perms.size() && perms[i]->name == perms[i + 1]->name) {
+                    continue;
+                }
+
+                _writer.member(perms[i]->name, perm_to_string.at(perms[i]->prms));
+            }
+
+            _writer.end_object();
+        } // write_permissions_information
+
+        template <typename Writer>
+        void write_metadata_information(rcComm_t& _comm, Writer& _writer, const fs::path& _path)
         {
-            auto meta_arr = nlohmann::json::array();
+            _writer.key("metadata").begin_array();
 
             for (auto&& avu : fcli::get_metadata(_comm, _path)) {
-                auto md = nlohmann::json::object();
-                md["attribute"] = avu.attribute;
-                md["value"] = avu.value;
-                md["units"] = avu.units;
-                meta_arr.push_back(md);
+                _writer.begin_object();
+                _writer.member("attribute", avu.attribute);
+                _writer.member("units", avu.units);
+                _writer.member("value", avu.value);
+                _writer.end_object();
             }
 
-            _obj_info["metadata"] = meta_arr;
-        } // aggregate_metadata_information
+            _writer.end_array();
+        } // write_metadata_information
+
+        // Declared last so that background work stops before the members it uses are destroyed.
+        prefetch_buffer<page_response> prefetch_;
     }; // class list
 } // namespace irods::rest
 
@@ -1,5 +1,7 @@
 #include "irods_rest_api_base.h"
 #include "constants.hpp"
+#include "jobs.hpp"
+#include "parallel.hpp"
 #include "utils.hpp"
 
 #include <irods/filesystem.hpp>
@@ -14,6 +16,16 @@
 #include <pistache/optional.h>
 #include <pistache/router.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace fs = irods::experimental::filesystem;
 namespace fscli = irods::experimental::filesystem::client;
 
@@ -21,6 +33,21 @@ namespace irods::rest
 {
     const std::string service_name{"irods_rest_cpp_logicalpath_server"};
 
+    namespace
+    {
+        namespace configuration_keywords
+        {
+            const std::string max_recursive_parallelism{"maximum_recursive_operation_parallelism"};
+            const std::string batch_max_operations{"batch_maximum_number_of_operations"};
+            const std::string batch_parallelism{"batch_parallelism"};
+            const std::string jobs{"jobs"};
+            const std::string journal_file{"journal_file"};
+            const std::string max_running_jobs{"maximum_number_of_running_jobs"};
+            const std::string max_queued_jobs{"maximum_number_of_queued_jobs"};
+            const std::string job_ttl{"time_to_live_in_seconds"};
+        } // namespace configuration_keywords
+    } // namespace
+
     // this is contractually tied directly to the api implementation
     class logical_path : public api_base
     {
@@ -28,9 +55,77 @@ namespace irods::rest
         logical_path()
             : api_base{service_name}
         {
+            namespace keywords = configuration_keywords;
+
+            max_recursive_parallelism_ = std::max<std::size_t>(1, get_configuration_option<std::size_t>(keywords::max_recursive_parallelism, 4));
+            max_batch_size_ = get_configuration_option<std::size_t>(keywords::batch_max_operations, 1024);
+            batch_parallelism_ = std::max<std::size_t>(1, get_configuration_option<std::size_t>(keywords::batch_parallelism, 4));
+
+            const auto jobs_cfg = get_configuration_option<nlohmann::json>(keywords::jobs, nlohmann::json::object());
+
+            jobs::settings job_settings;
+            job_settings.journal_file = jobs_cfg.value(keywords::journal_file, job_settings.journal_file);
+            job_settings.maximum_number_of_running_jobs = jobs_cfg.value(keywords::max_running_jobs, job_settings.maximum_number_of_running_jobs);
+            job_settings.maximum_number_of_queued_jobs = jobs_cfg.value(keywords::max_queued_jobs, job_settings.maximum_number_of_queued_jobs);
+            job_settings.time_to_live = std::chrono::seconds{jobs_cfg.value(keywords::job_ttl, job_settings.time_to_live.count())};
+
+            info("Starting job executor [journal_file={}, maximum_number_of_running_jobs={}].",
+                 job_settings.journal_file, job_settings.maximum_number_of_running_jobs);
+
+            jobs_.start(std::move(job_settings));
+
             info("Endpoint initialized.");
         }
 
+        // Returns the status and progress of a job submitted by the user.
+        auto get_job_dispatcher(const Pistache::Rest::Request& _request, Pistache::Http::ResponseWriter& _response)
+            -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            try {
+                const auto job = find_job(_request);
+
+                if (!job) {
+                    return std::make_tuple(Pistache::Http::Code::Not_Found, make_error(SYS_INVALID_INPUT_PARAM, "Job not found"));
+                }
+
+                return std::make_tuple(Pistache::Http::Code::Ok, job->to_json().dump());
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                return make_error_response(e.code(), e.client_display_what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // get_job_dispatcher
+
+        // Cancels a job submitted by the user. A running job stops once the data objects being
+        // processed are done.
+        auto cancel_job_dispatcher(const Pistache::Rest::Request& _request, Pistache::Http::ResponseWriter& _response)
+            -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            try {
+                const auto job = find_job(_request);
+
+                if (!job) {
+                    return std::make_tuple(Pistache::Http::Code::Not_Found, make_error(SYS_INVALID_INPUT_PARAM, "Job not found"));
+                }
+
+                jobs_.cancel(*job);
+
+                return std::make_tuple(Pistache::Http::Code::Ok, job->to_json().dump());
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                return make_error_response(e.code(), e.client_display_what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // cancel_job_dispatcher
+
         std::tuple<Pistache::Http::Code, std::string> rename_dispatcher(const Pistache::Rest::Request& _request,
                                                                         Pistache::Http::ResponseWriter& _response)
         {
@@ -97,6 +192,18 @@ namespace irods::rest
                                                  .recursive = recursive,
                                                  .unregister = "1" == _unregister};
 
+                if (is_set(_request.query().get("async").getOrElse("0"))) {
+                    const auto auth_header = _request.headers().getRaw("authorization").value();
+
+                    return submit_job(_request, _response, "delete", logical_path.string(), [this, auth_header, logical_path, opts](jobs::job&) {
+                        auto conn = get_connection(auth_header);
+
+                        if (!fs::client::remove(*conn(), logical_path, opts)) {
+                            THROW(SYS_UNKNOWN_ERROR, "Client experienced an unknown error while processing your delete request.");
+                        }
+                    });
+                }
+
                 bool status = fs::client::remove(*conn(), logical_path, opts);
 
                 if (!status) {
@@ -164,38 +271,36 @@ namespace irods::rest
             -> std::tuple<Pistache::Http::Code, std::string>
         {
             try {
-                auto conn = get_connection(_request.headers().getRaw("authorization").value());
+                const auto auth_header = _request.headers().getRaw("authorization").value();
+                auto conn = get_connection(auth_header);
 
-                auto inp = create_data_obj_trim_inp(_request);
+                auto inp = create_data_obj_trim_inp(query_parameters(_request));
 
                 // This will ensure that the KeyValPair member of the input is free'd.
                 const auto trim_input_lm = irods::at_scope_exit{[&inp] { clearKeyVal(&inp.condInput); }};
 
-                if (fscli::is_collection(fscli::status(*conn(), decode_url(inp.objPath)))) {
-                    if (!is_set(_request.query().get("recursive").getOrElse("0"))) {
-                        return make_error_response(
-                            USER_INCOMPATIBLE_PARAMS,
-                            "'recursive=1' required to trim a collection. Make sure you want to trim the whole "
-                            "sub-tree.");
-                    }
+                const auto collection = fscli::is_collection(fscli::status(*conn(), decode_url(inp.objPath)));
 
-                    for (const auto& pathname : fscli::recursive_collection_iterator(*conn(), inp.objPath)) {
-                        if (fscli::is_collection(fscli::status(*conn(), decode_url(pathname.path())))) {
-                            continue;
-                        }
+                if (collection && !is_set(_request.query().get("recursive").getOrElse("0"))) {
+                    return make_error_response(
+                        USER_INCOMPATIBLE_PARAMS,
+                        "'recursive=1' required to trim a collection. Make sure you want to trim the whole "
+                        "sub-tree.");
+                }
 
-                        std::strncpy(inp.objPath, pathname.path().c_str(), MAX_NAME_LEN);
+                if (is_set(_request.query().get("async").getOrElse("0"))) {
+                    return submit_data_object_job(_request, _response, "trim", inp, collection, "rcDataObjTrim", rcDataObjTrim);
+                }
 
-                        if (const auto ec = rcDataObjTrim(conn(), &inp); ec < 0) {
-                            const auto msg = fmt::format("Error occurred during trim of [{}]", inp.objPath);
-                            return make_error_response(ec, msg);
-                        }
-                    }
+                if (collection) {
+                    const auto parallelism = get_recursive_parallelism(_request);
+                    jobs::progress progress;
+                    for_each_data_object(auth_header, conn, inp, parallelism, "rcDataObjTrim", rcDataObjTrim, progress);
 
-                    return std::make_tuple(Pistache::Http::Code::Ok, "");
+                    return make_recursive_response("trim", progress);
                 }
 
-                if (const auto ec = rcDataObjTrim(conn(), &inp); ec < 0) {
+                if (const auto ec = metrics::invoke("rcDataObjTrim", rcDataObjTrim, conn(), &inp); ec < 0) {
                     const auto msg = fmt::format("Error occurred during trim of [{}]", inp.objPath);
                     return make_error_response(ec, msg);
                 }
@@ -224,39 +329,131 @@ namespace irods::rest
             -> std::tuple<Pistache::Http::Code, std::string>
         {
             try {
-                auto conn = get_connection(_request.headers().getRaw("authorization").value());
+                const auto auth_header = _request.headers().getRaw("authorization").value();
+                auto conn = get_connection(auth_header);
 
-                auto inp = create_data_obj_repl_inp(_request);
+                auto inp = create_data_obj_repl_inp(query_parameters(_request));
 
                 // This will ensure that the KeyValPair member of the input is free'd.
                 const auto trim_input_lm = irods::at_scope_exit{[&inp] { clearKeyVal(&inp.condInput); }};
 
-                if (fscli::is_collection(fscli::status(*conn(), decode_url(inp.objPath)))) {
+                const auto collection = fscli::is_collection(fscli::status(*conn(), decode_url(inp.objPath)));
+
+                if (collection && !is_set(_request.query().get("recursive").getOrElse("0"))) {
+                    return std::make_tuple(
+                        Pistache::Http::Code::Bad_Request,
+                        "'recursive=1' required to replicate a collection. Make sure you want to replicate the "
+                        "whole sub-tree.");
+                }
+
+                if (is_set(_request.query().get("async").getOrElse("0"))) {
+                    return submit_data_object_job(_request, _response, "replicate", inp, collection, "rcDataObjRepl", rcDataObjRepl);
+                }
+
+                if (collection) {
+                    const auto parallelism = get_recursive_parallelism(_request);
+                    jobs::progress progress;
+                    for_each_data_object(auth_header, conn, inp, parallelism, "rcDataObjRepl", rcDataObjRepl, progress);
+
+                    return make_recursive_response("replicate", progress);
+                }
+
+                if (const auto ec = metrics::invoke("rcDataObjRepl", rcDataObjRepl, conn(), &inp); ec < 0) {
+                    const auto msg = fmt::format("Error occurred during replication of [{}]", inp.objPath);
+                    return make_error_response(ec, msg);
+                }
+
+                return std::make_tuple(Pistache::Http::Code::Ok, "");
+            }
+            catch (const fs::filesystem_error& e) {
+                error("Caught exception - [error_code={}] {}", e.code().value(), e.what());
+                return make_error_response(e.code().value(), e.what());
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                return make_error_response(e.code(), e.what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+            catch (...) {
+                error("Caught unknown exception.");
+                return make_error_response(SYS_UNKNOWN_ERROR, "Caught unknown exception");
+            }
+        } // replicate_dispatcher
+
+        // Copies a data object or collection within the zone. The data moves between resources
+        // on the server side.
+        auto copy_dispatcher(const Pistache::Rest::Request& _request, Pistache::Http::ResponseWriter& _response)
+            -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            try {
+                const auto auth_header = _request.headers().getRaw("authorization").value();
+                auto conn = get_connection(auth_header);
+
+                auto inp = create_data_obj_copy_inp(query_parameters(_request));
+
+                // This will ensure that the KeyValPair members of the input are free'd.
+                const auto copy_input_lm = irods::at_scope_exit{[&inp] {
+                    clearKeyVal(&inp.srcDataObjInp.condInput);
+                    clearKeyVal(&inp.destDataObjInp.condInput);
+                }};
+
+                const fs::path src = decode_url(inp.srcDataObjInp.objPath);
+                const fs::path dst = decode_url(inp.destDataObjInp.objPath);
+                std::strncpy(inp.srcDataObjInp.objPath, src.c_str(), MAX_NAME_LEN);
+                std::strncpy(inp.destDataObjInp.objPath, dst.c_str(), MAX_NAME_LEN);
+
+                const auto collection = fscli::is_collection(fscli::status(*conn(), src));
+
+                if (collection) {
                     if (!is_set(_request.query().get("recursive").getOrElse("0"))) {
-                        return std::make_tuple(
-                            Pistache::Http::Code::Bad_Request,
-                            "'recursive=1' required to replicate a collection. Make sure you want to replicate the "
-                            "whole sub-tree.");
+                        return make_error_response(
+                            USER_INCOMPATIBLE_PARAMS,
+                            "'recursive=1' required to copy a collection. Make sure you want to copy the whole "
+                            "sub-tree.");
                     }
 
-                    for (const auto& pathname : fscli::recursive_collection_iterator(*conn(), inp.objPath)) {
-                        if (fscli::is_collection(fscli::status(*conn(), decode_url(pathname.path())))) {
-                            continue;
+                    if (const auto rel = dst.lexically_relative(src); !rel.empty() && *rel.begin() != "..") {
+                        return make_error_response(USER_INCOMPATIBLE_PARAMS, "Cannot copy a collection into itself.");
+                    }
+                }
+
+                const auto parallelism = get_recursive_parallelism(_request);
+
+                if (is_set(_request.query().get("async").getOrElse("0"))) {
+                    auto operation = [this, auth_header, inp = copy_data_obj_copy_inp(inp), collection, parallelism](jobs::job& _job) {
+                        auto conn = get_connection(auth_header);
+                        auto& progress = _job.get_progress();
+
+                        if (collection) {
+                            copy_collection(auth_header, conn, *inp, parallelism, progress);
+                            return;
                         }
 
-                        std::strncpy(inp.objPath, pathname.path().c_str(), MAX_NAME_LEN);
+                        const auto size = fscli::data_object_size(*conn(), inp->srcDataObjInp.objPath);
 
-                        if (const auto ec = rcDataObjRepl(conn(), &inp); ec != 0) {
-                            const auto msg = fmt::format("Error occurred during replication of [{}]", inp.objPath);
-                            return make_error_response(ec, msg);
+                        if (const auto ec = metrics::invoke("rcDataObjCopy", rcDataObjCopy, conn(), inp.get()); ec < 0) {
+                            progress.add_failure(inp->srcDataObjInp.objPath, ec);
                         }
-                    }
+                        else {
+                            progress.add_success(size);
+                        }
+                    };
 
-                    return std::make_tuple(Pistache::Http::Code::Ok, "");
+                    return submit_job(_request, _response, "copy", src.string(), std::move(operation));
                 }
 
-                if (const auto ec = rcDataObjRepl(conn(), &inp); ec != 0) {
-                    const auto msg = fmt::format("Error occurred during replication of [{}]", inp.objPath);
+                if (collection) {
+                    jobs::progress progress;
+                    copy_collection(auth_header, conn, inp, parallelism, progress);
+
+                    return make_recursive_response("copy", progress);
+                }
+
+                if (const auto ec = metrics::invoke("rcDataObjCopy", rcDataObjCopy, conn(), &inp); ec < 0) {
+                    const auto msg = fmt::format("Error occurred during copy of [{}]", inp.srcDataObjInp.objPath);
                     return make_error_response(ec, msg);
                 }
 
@@ -278,9 +475,464 @@ namespace irods::rest
                 error("Caught unknown exception.");
                 return make_error_response(SYS_UNKNOWN_ERROR, "Caught unknown exception");
             }
-        } // replicate_dispatcher
+        } // copy_dispatcher
+
+        // Executes a JSON array of operations and returns their results in input order. Ordered
+        // batches run on a single connection. Unordered batches run concurrently on pooled
+        // connections of the user.
+        auto batch_dispatcher(const Pistache::Rest::Request& _request, Pistache::Http::ResponseWriter& _response)
+            -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            try {
+                const auto auth_header = _request.headers().getRaw("authorization").value();
+                const auto ordered = is_set(_request.query().get("ordered").getOrElse("1"));
+                const auto continue_on_error = is_set(_request.query().get("continue-on-error").getOrElse("0"));
+
+                const auto operations = nlohmann::json::parse(_request.body());
+
+                if (!operations.is_array()) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Request body must be a JSON array of operations.");
+                }
+
+                if (operations.size() > max_batch_size_) {
+                    THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Too many operations in batch: limit is {}.", max_batch_size_));
+                }
+
+                std::vector<nlohmann::json> results(operations.size(), {{"status", "skipped"}});
+                std::atomic<bool> stop{false};
+
+                const auto execute = [&](connection_proxy& _conn, std::size_t _i) {
+                    results[_i] = execute_batch_operation(auth_header, _conn, operations[_i]);
+
+                    if (!continue_on_error && "ok" != results[_i].at("status")) {
+                        stop = true;
+                    }
+                };
+
+                if (ordered) {
+                    auto conn = get_connection(auth_header);
+
+                    for (std::size_t i = 0; i < operations.size() && !stop; ++i) {
+                        execute(conn, i);
+                    }
+                }
+                else {
+                    for_each_index_in_parallel(operations.size(), batch_parallelism_, [&](std::size_t _i) {
+                        if (!stop) {
+                            auto conn = get_any_connection(auth_header, batch_connection_hint, batch_parallelism_);
+                            execute(conn, _i);
+                        }
+                    });
+                }
+
+                return std::make_tuple(Pistache::Http::Code::Ok, nlohmann::json(results).dump());
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                return make_error_response(e.code(), e.client_display_what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // batch_dispatcher
 
       private:
+        // Prefix of the pooled connections used by the workers of recursive operations.
+        inline static const std::string recursive_connection_hint{"logicalpath_recursive_"};
+
+        // Prefix of the pooled connections used by unordered batches.
+        inline static const std::string batch_connection_hint{"logicalpath_batch_"};
+
+        // Returns the value of a parameter of an operation, or the default if it is not set.
+        using parameter_getter = std::function<std::string(const std::string&, const std::string&)>;
+
+        static auto query_parameters(const Pistache::Http::Request& _request) -> parameter_getter
+        {
+            return [&_request](const std::string& _key, const std::string& _default) {
+                return _request.query().get(_key).getOrElse(_default);
+            };
+        } // query_parameters
+
+        // Batch operations accept the parameters of the endpoints as strings or integers.
+        static auto batch_parameters(const nlohmann::json& _operation) -> parameter_getter
+        {
+            return [&_operation](const std::string& _key, const std::string& _default) -> std::string {
+                const auto iter = _operation.find(_key);
+
+                if (iter == std::end(_operation)) {
+                    return _default;
+                }
+
+                if (iter->is_number_integer()) {
+                    return std::to_string(iter->get<std::int64_t>());
+                }
+
+                return iter->get<std::string>();
+            };
+        } // batch_parameters
+
+        // Executes one operation of a batch on _conn. Returns {"status": "ok"} on success and the
+        // error otherwise.
+        auto execute_batch_operation(const std::string& _auth_header, connection_proxy& _conn, const nlohmann::json& _operation)
+            -> nlohmann::json
+        {
+            const auto make_error_result = [](int _error_code, std::string_view _error_message) {
+                return nlohmann::json{{"status", "error"}, {"error_code", _error_code}, {"error_message", _error_message}};
+            };
+
+            try {
+                if (!_operation.is_object() || !_operation.contains("op")) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Batch operation must be an object containing an op.");
+                }
+
+                const auto op = _operation.at("op").get<std::string>();
+                const auto param = batch_parameters(_operation);
+
+                const auto required = [&param](const std::string& _key) -> fs::path {
+                    auto value = param(_key, "");
+
+                    if (value.empty()) {
+                        THROW(SYS_INVALID_INPUT_PARAM, fmt::format("{} missing from operation or empty", _key));
+                    }
+
+                    return value;
+                };
+
+                if ("rename" == op) {
+                    fscli::rename(*_conn(), required("src"), required("dst"));
+                }
+                else if ("mkdir" == op) {
+                    const auto path = required("logical-path");
+
+                    if (is_set(param("create-parent-collections", "0"))) {
+                        fscli::create_collections(*_conn(), path);
+                    }
+                    else if (!fscli::create_collection(*_conn(), path)) {
+                        THROW(CATALOG_ALREADY_HAS_ITEM_BY_THAT_NAME,
+                              fmt::format("Creating collection [{}] failed. Logical path already exists.", path.c_str()));
+                    }
+                }
+                else if ("delete" == op) {
+                    const auto path = required("logical-path");
+                    const auto recursive = is_set(param("recursive", "0"));
+
+                    if (!recursive && fscli::is_collection(fscli::status(*_conn(), path))) {
+                        THROW(USER_INCOMPATIBLE_PARAMS, "'recursive=1' required to delete a collection.");
+                    }
+
+                    fs::extended_remove_options opts{.no_trash = is_set(param("no-trash", "0")),
+                                                     .verbose = false,
+                                                     .progress = false,
+                                                     .recursive = recursive,
+                                                     .unregister = is_set(param("unregister", "0"))};
+
+                    if (!fscli::remove(*_conn(), path, opts)) {
+                        THROW(SYS_UNKNOWN_ERROR, "Client experienced an unknown error while processing the delete operation.");
+                    }
+                }
+                else if ("trim" == op || "replicate" == op) {
+                    const auto trim = "trim" == op;
+                    auto inp = trim ? create_data_obj_trim_inp(param) : create_data_obj_repl_inp(param);
+                    const auto inp_lm = irods::at_scope_exit{[&inp] { clearKeyVal(&inp.condInput); }};
+                    const auto api_name = trim ? "rcDataObjTrim" : "rcDataObjRepl";
+                    const auto fn = trim ? rcDataObjTrim : rcDataObjRepl;
+
+                    if (fscli::is_collection(fscli::status(*_conn(), inp.objPath))) {
+                        if (!is_set(param("recursive", "0"))) {
+                            THROW(USER_INCOMPATIBLE_PARAMS, fmt::format("'recursive=1' required to {} a collection.", op));
+                        }
+
+                        const auto requested = std::stoi(param("parallelism", "1"));
+                        const auto parallelism = std::min<std::size_t>(std::max(requested, 1), max_recursive_parallelism_);
+
+                        jobs::progress progress;
+                        for_each_data_object(_auth_header, _conn, inp, parallelism, api_name, fn, progress);
+
+                        if (auto [code, body] = make_recursive_response(op, progress); Pistache::Http::Code::Ok != code) {
+                            auto result = nlohmann::json::parse(body);
+                            result["status"] = "error";
+                            return result;
+                        }
+                    }
+                    else if (const auto ec = metrics::invoke(api_name, fn, _conn(), &inp); ec < 0) {
+                        THROW(ec, fmt::format("Error occurred during {} of [{}]", op, inp.objPath));
+                    }
+                }
+                else {
+                    THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Unknown op [{}].", op));
+                }
+
+                return {{"status", "ok"}};
+            }
+            catch (const fs::filesystem_error& e) {
+                error("Caught exception in batch operation - [error_code={}] {}", e.code().value(), e.what());
+                return make_error_result(e.code().value(), e.what());
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception in batch operation - [error_code={}] {}", e.code(), e.what());
+                return make_error_result(e.code(), e.client_display_what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception in batch operation - {}", e.what());
+                return make_error_result(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // execute_batch_operation
+
+        // Returns the number of workers requested with the "parallelism" parameter, capped by the
+        // service's configuration.
+        auto get_recursive_parallelism(const Pistache::Rest::Request& _request) const -> std::size_t
+        {
+            const auto requested = std::stoi(_request.query().get("parallelism").getOrElse("1"));
+
+            if (requested < 1) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Invalid parallelism: must be greater than 0.");
+            }
+
+            return std::min<std::size_t>(requested, max_recursive_parallelism_);
+        } // get_recursive_parallelism
+
+        // Walks the collection _collection on _conn while _parallelism workers drain a bounded
+        // queue of its data objects. Each worker calls _make_processor once and then invokes the
+        // function it returns for every data object it pops. A negative result is recorded as a
+        // failure in _progress and the walk continues. _on_collection is invoked on the walking
+        // thread for every subcollection, before its contents. The walk stops early if
+        // cancellation is requested.
+        template <typename OnCollection, typename MakeProcessor>
+        auto walk_collection_in_parallel(connection_proxy& _conn,
+                                         const std::string& _collection,
+                                         std::size_t _parallelism,
+                                         std::string_view _operation,
+                                         jobs::progress& _progress,
+                                         OnCollection _on_collection,
+                                         MakeProcessor _make_processor) -> void
+        {
+            constexpr std::size_t paths_queued_per_worker = 16;
+
+            struct data_object
+            {
+                std::string path;
+                std::uintmax_t size;
+            };
+
+            const auto produce = [&](auto _push) {
+                for (const auto& entry : fscli::recursive_collection_iterator(*_conn(), _collection)) {
+                    if (_progress.cancellation_requested()) {
+                        return;
+                    }
+
+                    if (entry.is_collection()) {
+                        _on_collection(entry.path());
+                    }
+                    else if (entry.is_data_object() && !_push(data_object{entry.path().string(), entry.data_size()})) {
+                        return;
+                    }
+                }
+            };
+
+            const auto consume = [&](bounded_queue<data_object>& _queue) {
+                auto process = _make_processor();
+
+                while (auto data_object = _queue.pop()) {
+                    // Queued data objects are skipped so that the producer is not left blocked.
+                    if (_progress.cancellation_requested()) {
+                        continue;
+                    }
+
+                    if (const auto ec = process(data_object->path); ec < 0) {
+                        error("Error occurred during {} of [{}] - [error_code={}]", _operation, data_object->path, ec);
+                        _progress.add_failure(std::move(data_object->path), ec);
+                    }
+                    else {
+                        _progress.add_success(data_object->size);
+                    }
+                }
+            };
+
+            produce_and_consume_in_parallel<data_object>(_parallelism, paths_queued_per_worker * _parallelism, produce, consume);
+        } // walk_collection_in_parallel
+
+        // Invokes _op on every data object under the collection _inp.objPath. Each worker uses
+        // its own pooled connection.
+        template <typename Op>
+        auto for_each_data_object(const std::string& _auth_header,
+                                  connection_proxy& _conn,
+                                  const DataObjInp& _inp,
+                                  std::size_t _parallelism,
+                                  std::string_view _api_name,
+                                  Op _op,
+                                  jobs::progress& _progress) -> void
+        {
+            walk_collection_in_parallel(_conn, _inp.objPath, _parallelism, _api_name, _progress, [](const fs::path&) {}, [&] {
+                // Every worker needs its own copy of the input because objPath changes per call.
+                return [conn = get_any_connection(_auth_header, recursive_connection_hint, max_recursive_parallelism_),
+                        inp = copy_data_obj_inp(_inp),
+                        _api_name,
+                        _op](const std::string& _path) mutable {
+                    std::strncpy(inp->objPath, _path.c_str(), MAX_NAME_LEN);
+                    return metrics::invoke(_api_name, _op, conn(), inp.get());
+                };
+            });
+        } // for_each_data_object
+
+        // Copies every data object under the collection _inp.srcDataObjInp.objPath to the same
+        // relative path under _inp.destDataObjInp.objPath. Collections are created by the walk
+        // before their contents are copied.
+        auto copy_collection(const std::string& _auth_header,
+                             connection_proxy& _conn,
+                             const DataObjCopyInp& _inp,
+                             std::size_t _parallelism,
+                             jobs::progress& _progress) -> void
+        {
+            const fs::path src = _inp.srcDataObjInp.objPath;
+            const fs::path dst = _inp.destDataObjInp.objPath;
+
+            fscli::create_collections(*_conn(), dst);
+
+            const auto on_collection = [&](const fs::path& _path) {
+                fscli::create_collection(*_conn(), dst / _path.lexically_relative(src));
+            };
+
+            walk_collection_in_parallel(_conn, src.string(), _parallelism, "copy", _progress, on_collection, [&] {
+                return [&src,
+                        &dst,
+                        conn = get_any_connection(_auth_header, recursive_connection_hint, max_recursive_parallelism_),
+                        inp = copy_data_obj_copy_inp(_inp)](const std::string& _path) mutable {
+                    const auto target = dst / fs::path{_path}.lexically_relative(src);
+                    std::strncpy(inp->srcDataObjInp.objPath, _path.c_str(), MAX_NAME_LEN);
+                    std::strncpy(inp->destDataObjInp.objPath, target.c_str(), MAX_NAME_LEN);
+                    return metrics::invoke("rcDataObjCopy", rcDataObjCopy, conn(), inp.get());
+                };
+            });
+        } // copy_collection
+
+        // Returns an empty response if every data object was processed successfully. Otherwise,
+        // the error describes every data object that failed.
+        auto make_recursive_response(std::string_view _operation, const jobs::progress& _progress) const
+            -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            const auto failures = _progress.failures();
+
+            debug("Recursive {} processed {} data objects with {} failures.", _operation, _progress.data_objects(), failures.size());
+
+            if (failures.empty()) {
+                return std::make_tuple(Pistache::Http::Code::Ok, "");
+            }
+
+            auto failures_json = nlohmann::json::array();
+
+            for (const auto& f : failures) {
+                failures_json.push_back({{"logical_path", f.logical_path}, {"error_code", f.error_code}});
+            }
+
+            const auto msg = fmt::format("Error occurred during {} of {} of {} data objects",
+                                         _operation, failures.size(), _progress.data_objects());
+
+            nlohmann::json body{{"error_code", failures.front().error_code},
+                                {"error_message", msg},
+                                {"failures", std::move(failures_json)}};
+
+            return std::make_tuple(Pistache::Http::Code::Bad_Request, body.dump());
+        } // make_recursive_response
+
+        // Returns a deep copy of _inp which frees its KeyValPair when destroyed.
+        static auto copy_data_obj_inp(const DataObjInp& _inp) -> std::shared_ptr<DataObjInp>
+        {
+            auto copy = std::shared_ptr<DataObjInp>{new DataObjInp{_inp}, [](DataObjInp* _p) {
+                clearKeyVal(&_p->condInput);
+                delete _p;
+            }};
+
+            copy->condInput = {};
+            replKeyVal(&_inp.condInput, &copy->condInput);
+
+            return copy;
+        } // copy_data_obj_inp
+
+        // Returns a deep copy of _inp which frees its KeyValPairs when destroyed.
+        static auto copy_data_obj_copy_inp(const DataObjCopyInp& _inp) -> std::shared_ptr<DataObjCopyInp>
+        {
+            auto copy = std::shared_ptr<DataObjCopyInp>{new DataObjCopyInp{_inp}, [](DataObjCopyInp* _p) {
+                clearKeyVal(&_p->srcDataObjInp.condInput);
+                clearKeyVal(&_p->destDataObjInp.condInput);
+                delete _p;
+            }};
+
+            copy->srcDataObjInp.condInput = {};
+            copy->destDataObjInp.condInput = {};
+            replKeyVal(&_inp.srcDataObjInp.condInput, &copy->srcDataObjInp.condInput);
+            replKeyVal(&_inp.destDataObjInp.condInput, &copy->destDataObjInp.condInput);
+
+            return copy;
+        } // copy_data_obj_copy_inp
+
+        // Queues _operation as a job owned by the user and returns 202 Accepted with the job's
+        // status. The Location header identifies the job.
+        auto submit_job(const Pistache::Rest::Request& _request,
+                        Pistache::Http::ResponseWriter& _response,
+                        std::string _operation_name,
+                        std::string _logical_path,
+                        jobs::job_manager::operation_type _operation) -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            const auto user_name = get_user_name(_request.headers().getRaw("authorization").value());
+
+            const auto job = jobs_.submit(user_name, std::move(_operation_name), std::move(_logical_path), std::move(_operation));
+
+            if (!job) {
+                return std::make_tuple(Pistache::Http::Code::Service_Unavailable,
+                                       make_error(SYS_NOT_ALLOWED, "Too many jobs are queued. Try again later."));
+            }
+
+            debug("Submitted job [{}].", job->id());
+
+            _response.headers().addRaw(Pistache::Http::Header::Raw{"Location", fmt::format("{}/jobs/{}", base_url, job->id())});
+
+            return std::make_tuple(Pistache::Http::Code::Accepted, job->to_json().dump());
+        } // submit_job
+
+        // Submits _op on _inp.objPath as a job. Collections are processed like a synchronous
+        // recursive request.
+        template <typename Op>
+        auto submit_data_object_job(const Pistache::Rest::Request& _request,
+                                    Pistache::Http::ResponseWriter& _response,
+                                    std::string _operation_name,
+                                    const DataObjInp& _inp,
+                                    bool _collection,
+                                    std::string_view _api_name,
+                                    Op _op) -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            const auto auth_header = _request.headers().getRaw("authorization").value();
+            const auto parallelism = get_recursive_parallelism(_request);
+
+            auto operation = [this, auth_header, inp = copy_data_obj_inp(_inp), _collection, parallelism, api_name = std::string{_api_name}, _op](jobs::job& _job) {
+                auto conn = get_connection(auth_header);
+                auto& progress = _job.get_progress();
+
+                if (_collection) {
+                    for_each_data_object(auth_header, conn, *inp, parallelism, api_name, _op, progress);
+                    return;
+                }
+
+                const auto size = fscli::data_object_size(*conn(), inp->objPath);
+
+                if (const auto ec = metrics::invoke(api_name, _op, conn(), inp.get()); ec < 0) {
+                    progress.add_failure(inp->objPath, ec);
+                }
+                else {
+                    progress.add_success(size);
+                }
+            };
+
+            return submit_job(_request, _response, std::move(_operation_name), _inp.objPath, std::move(operation));
+        } // submit_data_object_job
+
+        // Returns the job identified by the "id" path parameter if it belongs to the user.
+        auto find_job(const Pistache::Rest::Request& _request) -> std::shared_ptr<jobs::job>
+        {
+            const auto user_name = get_user_name(_request.headers().getRaw("authorization").value());
+            return jobs_.find(_request.param(":id").as<std::string>(), user_name);
+        } // find_job
+
         auto mkdir(const fs::path& _path, const Pistache::Rest::Request& _request)
             -> std::tuple<Pistache::Http::Code, std::string>
         {
@@ -312,9 +964,9 @@ namespace irods::rest
             return std::make_tuple(Pistache::Http::Code::Ok, "");
         } // mkdir
 
-        static auto create_data_obj_trim_inp(const Pistache::Http::Request& _request) -> DataObjInp
+        static auto create_data_obj_trim_inp(const parameter_getter& _param) -> DataObjInp
         {
-            const auto _logical_path = _request.query().get("logical-path").getOrElse("");
+            const auto _logical_path = _param("logical-path", "");
             if (_logical_path.empty()) {
                 throw std::runtime_error{"logical-path missing from request or empty"};
             }
@@ -324,30 +976,30 @@ namespace irods::rest
 
             auto kvp = irods::experimental::key_value_proxy{inp.condInput};
 
-            if (is_set(_request.query().get("recursive").getOrElse("0"))) {
+            if (is_set(_param("recursive", "0"))) {
                 kvp[RECURSIVE_OPR__KW] = "";
             }
 
-            if (is_set(_request.query().get("admin-mode").getOrElse("0"))) {
+            if (is_set(_param("admin-mode", "0"))) {
                 kvp[ADMIN_KW] = "";
             }
 
-            const auto _num = _request.query().get("minimum-number-of-remaining-replicas").getOrElse("");
+            const auto _num = _param("minimum-number-of-remaining-replicas", "");
             if (!_num.empty()) {
                 kvp[COPIES_KW] = _num.c_str();
             }
 
-            const auto _age = _request.query().get("minimum-age-in-minutes").getOrElse("");
+            const auto _age = _param("minimum-age-in-minutes", "");
             if (!_age.empty()) {
                 kvp[AGE_KW] = _age.c_str();
             }
 
-            const auto _replica_number = _request.query().get("replica-number").getOrElse("");
+            const auto _replica_number = _param("replica-number", "");
             if (!_replica_number.empty()) {
                 kvp[REPL_NUM_KW] = _replica_number.c_str();
             }
 
-            const auto _src_resc = _request.query().get("src-resource").getOrElse("");
+            const auto _src_resc = _param("src-resource", "");
             if (!_src_resc.empty()) {
                 kvp[RESC_NAME_KW] = _src_resc.c_str();
             }
@@ -355,9 +1007,9 @@ namespace irods::rest
             return inp;
         } // create_data_obj_trim_inp
 
-        static auto create_data_obj_repl_inp(const Pistache::Http::Request& _request) -> DataObjInp
+        static auto create_data_obj_repl_inp(const parameter_getter& _param) -> DataObjInp
         {
-            const auto _logical_path = _request.query().get("logical-path").getOrElse("");
+            const auto _logical_path = _param("logical-path", "");
             if (_logical_path.empty()) {
                 throw std::runtime_error{"logical-path missing from request or empty"};
             }
@@ -367,12 +1019,12 @@ namespace irods::rest
 
             auto kvp = irods::experimental::key_value_proxy{inp.condInput};
 
-            const auto _replica_number = _request.query().get("replica-number").getOrElse("");
+            const auto _replica_number = _param("replica-number", "");
             if (!_replica_number.empty()) {
                 kvp[REPL_NUM_KW] = _replica_number.c_str();
             }
 
-            const auto _thread_count = _request.query().get("thread-count").getOrElse("");
+            const auto _thread_count = _param("thread-count", "");
             if (!_thread_count.empty()) {
                 inp.numThreads = std::stoi(_thread_count);
             }
@@ -380,12 +1032,12 @@ namespace irods::rest
                 inp.numThreads = NO_THREADING;
             }
 
-            const auto _src_resource = _request.query().get("src-resource").getOrElse("");
+            const auto _src_resource = _param("src-resource", "");
             if (!_src_resource.empty()) {
                 kvp[RESC_NAME_KW] = _src_resource.c_str();
             }
 
-            const auto _dst_resource = _request.query().get("dst-resource").getOrElse("");
+            const auto _dst_resource = _param("dst-resource", "");
             if (!_dst_resource.empty()) {
                 kvp[DEST_RESC_NAME_KW] = _dst_resource.c_str();
             }
@@ -394,19 +1046,67 @@ namespace irods::rest
                 kvp[DEST_RESC_NAME_KW] = cfg.at("default_resource").get_ref<const std::string&>();
             }
 
-            if (is_set(_request.query().get("recursive").getOrElse("0"))) {
+            if (is_set(_param("recursive", "0"))) {
                 kvp[RECURSIVE_OPR__KW] = "";
             }
 
-            if (is_set(_request.query().get("admin-mode").getOrElse("0"))) {
+            if (is_set(_param("admin-mode", "0"))) {
                 kvp[ADMIN_KW] = "";
             }
 
-            if (is_set(_request.query().get("all").getOrElse("0"))) {
+            if (is_set(_param("all", "0"))) {
                 kvp[ALL_KW] = "";
             }
 
             return inp;
         } // create_data_obj_repl_inp
+
+        static auto create_data_obj_copy_inp(const parameter_getter& _param) -> DataObjCopyInp
+        {
+            const auto _src = _param("src", "");
+            const auto _dst = _param("dst", "");
+            if (_src.empty() || _dst.empty()) {
+                throw std::runtime_error{"src or dst missing from request or empty"};
+            }
+
+            DataObjCopyInp inp{};
+            std::strncpy(inp.srcDataObjInp.objPath, _src.c_str(), MAX_NAME_LEN);
+            std::strncpy(inp.destDataObjInp.objPath, _dst.c_str(), MAX_NAME_LEN);
+            inp.srcDataObjInp.oprType = COPY_SRC;
+            inp.destDataObjInp.oprType = COPY_DEST;
+            inp.srcDataObjInp.dataSize = -1;
+
+            auto kvp = irods::experimental::key_value_proxy{inp.destDataObjInp.condInput};
+
+            const auto _dst_resource = _param("dst-resource", "");
+            if (!_dst_resource.empty()) {
+                kvp[DEST_RESC_NAME_KW] = _dst_resource.c_str();
+            }
+            else {
+                const auto& cfg = irods::rest::configuration::irods_client_environment();
+                kvp[DEST_RESC_NAME_KW] = cfg.at("default_resource").get_ref<const std::string&>();
+            }
+
+            if (is_set(_param("overwrite", "0"))) {
+                kvp[FORCE_FLAG_KW] = "";
+            }
+
+            const auto _thread_count = _param("thread-count", "");
+            if (!_thread_count.empty()) {
+                inp.destDataObjInp.numThreads = std::stoi(_thread_count);
+            }
+            else {
+                inp.destDataObjInp.numThreads = NO_THREADING;
+            }
+
+            return inp;
+        } // create_data_obj_copy_inp
+
+        std::size_t max_recursive_parallelism_;
+        std::size_t max_batch_size_;
+        std::size_t batch_parallelism_;
+
+        // Declared last so that running jobs finish before the members they use are destroyed.
+        jobs::job_manager jobs_;
     }; // class logical_path_rename
 } // namespace irods::rest
@@ -4,25 +4,91 @@
 #include "irods_rest_api_base.h"
 
 #include "constants.hpp"
+#include "expiring_cache.hpp"
+#include "genquery.hpp"
+#include "json_writer.hpp"
+#include "parallel.hpp"
+#include <irods/irods_at_scope_exit.hpp>
 #include <irods/irods_query.hpp>
+#include <irods/irods_random.hpp>
 #include <irods/rodsGenQuery.h>
 #include <irods/rodsErrorTable.h>
 
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
 
 #include <pistache/router.h>
 
+#include "utils.hpp"
+
 namespace irods::rest
 {
     // this is contractually tied directly to the api implementation
     const std::string service_name{"irods_rest_cpp_query_server"};
 
+    namespace
+    {
+        namespace configuration_keywords
+        {
+            const std::string query_cache_ttl{"query_cache_time_to_live_in_seconds"};
+            const std::string query_cache_max_entries{"query_cache_maximum_number_of_entries"};
+            const std::string query_cursor_ttl{"query_cursor_time_to_live_in_seconds"};
+            const std::string query_cursor_max_cursors{"maximum_number_of_query_cursors"};
+            const std::string query_batch_max_queries{"query_batch_maximum_number_of_queries"};
+            const std::string query_batch_parallelism{"query_batch_parallelism"};
+            const std::string prepared_queries{"prepared_queries"};
+            const std::string max_export_parallelism{"maximum_export_parallelism"};
+        } // namespace configuration_keywords
+    } // namespace
+
     class query : public api_base
     {
     public:
         query()
             : api_base{service_name}
+            , query_cache_{}
+            , cursors_mutex_{}
+            , cursors_{}
         {
+            namespace keywords = configuration_keywords;
+
+            const auto ttl = get_configuration_option<std::uint32_t>(keywords::query_cache_ttl, 0);
+            query_cache_.set_time_to_live(std::chrono::seconds{ttl});
+
+            const auto max_entries = get_configuration_option<std::size_t>(keywords::query_cache_max_entries, 1024);
+            query_cache_.set_maximum_number_of_entries(max_entries);
+
+            cursor_ttl_ = std::chrono::seconds{get_configuration_option<std::uint32_t>(keywords::query_cursor_ttl, 30)};
+            max_cursors_ = get_configuration_option<std::size_t>(keywords::query_cursor_max_cursors, 32);
+
+            max_batch_size_ = get_configuration_option<std::size_t>(keywords::query_batch_max_queries, 64);
+            batch_parallelism_ = std::max<std::size_t>(1, get_configuration_option<std::size_t>(keywords::query_batch_parallelism, 4));
+            max_export_parallelism_ = std::max<std::size_t>(1, get_configuration_option<std::size_t>(keywords::max_export_parallelism, 4));
+
+            configure_prefetch(prefetch_);
+
+            const auto prepared = get_configuration_option<nlohmann::json>(keywords::prepared_queries, nlohmann::json::object());
+
+            for (auto&& [name, query_template] : prepared.items()) {
+                try {
+                    prepared_queries_.try_emplace(name, query_template.get<std::string>());
+                }
+                catch (const std::exception& e) {
+                    error("Ignoring prepared query [{}] - {}", name, e.what());
+                }
+            }
+
             info("Endpoint initialized.");
         }
 
@@ -31,6 +97,27 @@ namespace irods::rest
                    Pistache::Http::ResponseWriter& _response)
         {
             try {
+                const auto encoding = negotiate_response_encoding(_request);
+
+                // Successful responses are written in the encoding requested. Errors are
+                // re-encoded by handle_request.
+                const auto encoded = [&_response, encoding](std::tuple<Pistache::Http::Code, std::string> _result) {
+                    set_response_encoding(_response, encoding);
+                    return _result;
+                };
+
+                // "cursor=1" opens a cursor. Any other value (except "0") identifies an open cursor.
+                if (const auto _cursor = _request.query().get("cursor").getOrElse("0"); "1" == _cursor) {
+                    return encoded(open_cursor(_request, encoding));
+                }
+                else if ("0" != _cursor) {
+                    return encoded(continue_cursor(_request, _cursor, encoding));
+                }
+
+                if (const auto _prepared = _request.query().get("prepared").getOrElse(""); !_prepared.empty()) {
+                    return encoded(execute_prepared(_request, _prepared, encoding));
+                }
+
                 auto _query_string = _request.query().get("query").get();
                 auto _query_limit = _request.query().get("limit").getOrElse("25");
                 auto _row_offset = _request.query().get("offset").getOrElse("0");
@@ -38,7 +125,7 @@ namespace irods::rest
                 auto _case_sensitive = _request.query().get("case-sensitive").getOrElse("1");
                 auto _distinct = _request.query().get("distinct").getOrElse("1");
 
-                auto conn = get_connection(_request.headers().getRaw("authorization").value(), _query_string);
+                const auto auth_header = _request.headers().getRaw("authorization").value();
 
                 std::string query_string{decode_url(_query_string)};
                 if ("0" == _case_sensitive) {
@@ -47,93 +134,73 @@ namespace irods::rest
                     });
                 }
 
-                uintmax_t row_offset  = std::stoi(_row_offset);
-                uintmax_t query_limit = std::stoi(_query_limit);
+                const page_request page{query_string, _query_limit, _row_offset, _query_type, _case_sensitive, _distinct, encoding};
+                const auto user_name = get_user_name(auth_header);
+
+                auto result = prefetch_.take(user_name, make_prefetch_key(page));
+
+                if (result) {
+                    trace("Serving prefetched page.");
+                }
+                else {
+                    result = make_page(user_name, page, [&] {
+                        return get_connection(auth_header, _query_string);
+                    });
+                }
+
+                // Clients usually follow the "next" link right away.
+                if (result->row_count > 0 && result->row_count == std::stoull(_query_limit)) {
+                    prefetch_next_page(user_name, auth_header, page);
+                }
+
+                return encoded(std::make_tuple(Pistache::Http::Code::Ok, std::move(result->body)));
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                return make_error_response(e.code(), e.client_display_what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // operator()
+
+        // Executes a JSON array of queries concurrently and returns their results in input order.
+        std::tuple<Pistache::Http::Code, std::string>
+        batch(const Pistache::Rest::Request& _request,
+              Pistache::Http::ResponseWriter& _response)
+        {
+            try {
+                const auto auth_header = _request.headers().getRaw("authorization").value();
+                const auto user_name = get_user_name(auth_header);
 
-                const auto query_type = irods::query<rcComm_t>::convert_string_to_query_type(_query_type);
-                const auto options = init_query_options(_case_sensitive, _distinct);
+                const auto queries = nlohmann::json::parse(_request.body());
 
-                irods::query query{conn(), query_string, query_limit, row_offset, query_type, options};
+                if (!queries.is_array()) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Request body must be a JSON array of queries.");
+                }
 
-                uintmax_t current_row_count = 0;
-                uintmax_t total_row_count = query.size();
-                nlohmann::json arrays = nlohmann::json::array();
-                for (auto&& row : query) {
-                    ++current_row_count;
+                if (queries.size() > max_batch_size_) {
+                    THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Too many queries in batch: limit is {}.", max_batch_size_));
+                }
 
-                    nlohmann::json array = nlohmann::json::array();
-                    for (auto&& e : row) {
-                        array.push_back(e);
+                std::vector<nlohmann::json> results(queries.size());
+
+                for_each_index_in_parallel(queries.size(), batch_parallelism_, [&](std::size_t _i) {
+                    try {
+                        results[_i] = execute_batch_entry(auth_header, user_name, queries[_i]);
+                    }
+                    catch (const irods::exception& e) {
+                        error("Caught exception in batch entry [{}] - [error_code={}] {}", _i, e.code(), e.what());
+                        results[_i] = {{"error_code", e.code()}, {"error_message", e.client_display_what()}};
+                    }
+                    catch (const std::exception& e) {
+                        error("Caught exception in batch entry [{}] - {}", _i, e.what());
+                        results[_i] = {{"error_code", SYS_INVALID_INPUT_PARAM}, {"error_message", e.what()}};
                     }
+                });
 
-                    arrays.push_back(array);
-                }
-
-                total_row_count += row_offset;
-
-                nlohmann::json results = nlohmann::json::object();
-                results["_embedded"] = arrays;
-                results["count"] = std::to_string(current_row_count);
-                results["total"] = std::to_string(total_row_count);
-
-                double dbl_row_offset  = static_cast<double>(row_offset);
-                double dbl_query_limit = static_cast<double>(query_limit);
-                double dbl_total_row_count = static_cast<double>(total_row_count);
-                nlohmann::json links = nlohmann::json::object();
-                constexpr auto* url_part = "/query?query={}&limit={}&offset={}&type={}&case-sensitive={}&distinct={}";
-                links["self"] = base_url + fmt::format(url_part,
-                                            query_string,
-                                            _query_limit,
-                                            _row_offset,
-                                            _query_type,
-                                            _case_sensitive,
-                                            _distinct);
-
-                links["first"] = base_url + fmt::format(url_part,
-                                             query_string,
-                                             _query_limit,
-                                             "0",
-                                             _query_type,
-                                             _case_sensitive,
-                                             _distinct);
-
-                double total_pages = dbl_total_row_count / dbl_query_limit;
-                double fraction_remaining_pages = total_pages - std::trunc(total_pages);
-                double remaining_rows = fraction_remaining_pages * static_cast<double>(dbl_query_limit);
-                double final_page_delta = (remaining_rows == 0.0) ? dbl_query_limit : remaining_rows;
-                double last_page_number = dbl_total_row_count - final_page_delta;
-
-                links["last"] = base_url + fmt::format(url_part,
-                                            query_string,
-                                            _query_limit,
-                                            static_cast<int>(last_page_number),
-                                            _query_type,
-                                            _case_sensitive,
-                                            _distinct);
-
-                double current_page_number = dbl_row_offset / dbl_query_limit;
-                double next_page_number = std::trunc(current_page_number) + 1 * dbl_query_limit;
-                next_page_number = (next_page_number >= dbl_total_row_count) ? last_page_number : next_page_number;
-
-                links["next"] = base_url + fmt::format(url_part,
-                                            query_string,
-                                            _query_limit,
-                                            static_cast<int>(next_page_number),
-                                            _query_type,
-                                            _case_sensitive,
-                                            _distinct);
-
-                auto prev_count = dbl_row_offset - dbl_query_limit;
-                links["prev"] = base_url + fmt::format(url_part,
-                                            query_string,
-                                            _query_limit,
-                                            static_cast<int>(std::max(0.0, prev_count)),
-                                            _query_type,
-                                            _case_sensitive,
-                                            _distinct);
-                results["_links"] = links;
-
-                return std::make_tuple(Pistache::Http::Code::Ok, results.dump());
+                return std::make_tuple(Pistache::Http::Code::Ok, nlohmann::json(results).dump());
             }
             catch (const irods::exception& e) {
                 error("Caught exception - [error_code={}] {}", e.code(), e.what());
@@ -143,9 +210,1065 @@ namespace irods::rest
                 error("Caught exception - {}", e.what());
                 return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
             }
-        } // operator()
+        } // batch
+
+        // Returns true if the client asked for the results to be streamed in an export format.
+        auto is_export_request(const Pistache::Rest::Request& _request) const -> bool
+        {
+            return accepts(_request, csv_media_type) || accepts(_request, ndjson_media_type);
+        } // is_export_request
+
+        // Streams every row of a general query using chunked transfer encoding. Rows are written
+        // as each GenQuery batch arrives, so memory use does not depend on the size of the result.
+        auto export_rows(const Pistache::Rest::Request& _request,
+                         Pistache::Http::ResponseWriter& _response) -> Pistache::Http::Code
+        {
+            const auto csv = accepts(_request, csv_media_type);
+
+            std::optional<genquery::input> input;
+            std::optional<connection_proxy> conn;
+            std::string auth_header;
+            std::string query_string;
+            int options = 0;
+            std::size_t query_limit = 0;
+            std::size_t row_offset = 0;
+            std::size_t parallelism = 1;
+
+            try {
+                auto _query_string = _request.query().get("query").get();
+                auto _query_limit = _request.query().get("limit").getOrElse("0");
+                auto _row_offset = _request.query().get("offset").getOrElse("0");
+                auto _query_type = _request.query().get("type").getOrElse("general");
+                auto _case_sensitive = _request.query().get("case-sensitive").getOrElse("1");
+                auto _distinct = _request.query().get("distinct").getOrElse("1");
+                auto _parallelism = _request.query().get("parallelism").getOrElse("1");
+
+                if ("general" != _query_type) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Export is only supported for general queries.");
+                }
+
+                auth_header = _request.headers().getRaw("authorization").value();
+
+                query_string = decode_url(_query_string);
+                if ("0" == _case_sensitive) {
+                    std::transform(query_string.begin(), query_string.end(), query_string.begin(), [](unsigned char c) {
+                        return std::toupper(c);
+                    });
+                }
+
+                const auto limit = std::stoi(_query_limit);
+                const auto offset = std::stoi(_row_offset);
+                const auto requested_parallelism = std::stoi(_parallelism);
+
+                if (limit < 0 || offset < 0) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Invalid limit or offset: neither may be negative.");
+                }
+
+                if (requested_parallelism < 1) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Invalid parallelism: must be greater than 0.");
+                }
+
+                query_limit = static_cast<std::size_t>(limit);
+                row_offset = static_cast<std::size_t>(offset);
+                parallelism = std::min<std::size_t>(requested_parallelism, max_export_parallelism_);
+                options = init_query_options(_case_sensitive, _distinct);
+
+                // Windows are separate executions of the query, so they only partition the result
+                // set if its order is stable. The catalog orders distinct queries by every selected
+                // column, but applies no order to the others.
+                if (parallelism > 1 && "0" == _distinct) {
+                    debug("Exporting on a single connection because distinct=0 results are unordered.");
+                    parallelism = 1;
+                }
+
+                // Parsing here reports invalid queries before the response is started.
+                input.emplace(query_string, options);
+                input->set_row_offset(offset);
+
+                trace("Exporting query results ...");
+
+                if (1 == parallelism) {
+                    conn.emplace(get_connection(auth_header));
+                }
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                _response.send(Pistache::Http::Code::Bad_Request, make_error(e.code(), e.client_display_what()));
+                return Pistache::Http::Code::Bad_Request;
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                _response.send(Pistache::Http::Code::Bad_Request, make_error(SYS_INVALID_INPUT_PARAM, e.what()));
+                return Pistache::Http::Code::Bad_Request;
+            }
+
+            const auto media_type = csv ? "text/csv; charset=utf-8" : "application/x-ndjson";
+            _response.headers().add<Pistache::Http::Header::ContentType>(Pistache::Http::Mime::MediaType::fromString(media_type));
+
+            auto stream = _response.stream(Pistache::Http::Code::Ok);
+            std::string chunk;
+            std::size_t rows_written = 0;
+
+            try {
+                if (csv) {
+                    append_csv_header(*input, chunk);
+                    stream << chunk;
+                    chunk.clear();
+                }
+
+                if (parallelism > 1) {
+                    rows_written = export_windows(stream, auth_header, query_string, options, row_offset, query_limit, parallelism, csv);
+                    stream.ends();
+
+                    debug("Exported {} rows using {} connections.", rows_written, parallelism);
+
+                    return Pistache::Http::Code::Ok;
+                }
+
+                do {
+                    const auto remaining = (0 == query_limit) ? static_cast<std::size_t>(MAX_SQL_ROWS) : query_limit - rows_written;
+                    const auto batch = genquery::fetch_batch(*(*conn)(), *input, static_cast<int>(std::min<std::size_t>(remaining, MAX_SQL_ROWS)));
+
+                    for (int r = 0; r < batch.row_count(); ++r) {
+                        csv ? append_csv_row(batch, r, chunk) : append_ndjson_row(batch, r, chunk);
+                    }
+
+                    rows_written += batch.row_count();
+
+                    // A zero-length chunk terminates the response.
+                    if (!chunk.empty()) {
+                        stream << chunk;
+                        stream.flush();
+                        chunk.clear();
+                    }
+                } while (input->continue_index() > 0 && (0 == query_limit || rows_written < query_limit));
+
+                genquery::close(*(*conn)(), *input);
+                stream.ends();
+
+                debug("Exported {} rows.", rows_written);
+
+                return Pistache::Http::Code::Ok;
+            }
+            catch (const std::exception& e) {
+                // The status line has already been sent. Terminate the response early and, when
+                // the format allows it, tell the client why.
+                error("Caught exception while exporting query results after {} rows - {}", rows_written, e.what());
+
+                if (!csv) {
+                    const auto* ie = dynamic_cast<const irods::exception*>(&e);
+                    stream << make_error(ie ? ie->code() : SYS_INTERNAL_ERR, ie ? ie->client_display_what() : e.what()) + '\n';
+                }
+
+                stream.ends();
+
+                return Pistache::Http::Code::Ok;
+            }
+        } // export_rows
 
     private:
+        // Prefix of the pooled connections shared by batch entries and prepared queries.
+        inline static const std::string shared_connection_hint{"query_shared_"};
+
+        // Prefix of the pooled connection used to prefetch pages.
+        inline static const std::string prefetch_connection_hint{"query_prefetch_"};
+
+        // Prefix of the pooled connections used by parallel exports.
+        inline static const std::string export_connection_hint{"query_export_"};
+
+        // Fetches consecutive windows of the result set concurrently, each worker using its own
+        // pooled connection, and writes them to _stream in order. At most _parallelism windows are
+        // fetched ahead of the window being written, which bounds memory use. Returns the number
+        // of rows written.
+        auto export_windows(Pistache::Http::ResponseStream& _stream,
+                            const std::string& _auth_header,
+                            const std::string& _query_string,
+                            int _options,
+                            std::size_t _row_offset,
+                            std::size_t _query_limit,
+                            std::size_t _parallelism,
+                            bool _csv) -> std::size_t
+        {
+            constexpr std::size_t window_size = 4 * MAX_SQL_ROWS;
+
+            struct window
+            {
+                std::string text;
+                std::size_t row_count;
+            };
+
+            std::mutex mutex;
+            std::condition_variable cv;
+            std::map<std::size_t, window> ready;
+            std::size_t next_to_fetch = 0;
+            std::size_t next_to_write = 0;
+            std::size_t end = (0 == _query_limit)
+                ? std::numeric_limits<std::size_t>::max()
+                : (_query_limit + window_size - 1) / window_size;
+            std::exception_ptr failure;
+            bool stop = false;
+
+            const auto fetch_windows = [&] {
+                try {
+                    auto conn = get_any_connection(_auth_header, export_connection_hint, max_export_parallelism_);
+
+                    while (true) {
+                        std::size_t w = 0;
+
+                        {
+                            std::unique_lock lk{mutex};
+                            cv.wait(lk, [&] {
+                                return stop || failure || next_to_fetch >= end || next_to_fetch < next_to_write + _parallelism;
+                            });
+
+                            if (stop || failure || next_to_fetch >= end) {
+                                return;
+                            }
+
+                            w = next_to_fetch++;
+                        }
+
+                        const auto first_row = w * window_size;
+                        const auto max_rows = (0 == _query_limit) ? window_size : std::min(window_size, _query_limit - first_row);
+
+                        genquery::input input{_query_string, _options};
+                        input.set_row_offset(static_cast<int>(_row_offset + first_row));
+
+                        window win{{}, 0};
+
+                        do {
+                            const auto remaining = std::min<std::size_t>(max_rows - win.row_count, MAX_SQL_ROWS);
+                            const auto batch = genquery::fetch_batch(*conn(), input, static_cast<int>(remaining));
+
+                            for (int r = 0; r < batch.row_count(); ++r) {
+                                _csv ? append_csv_row(batch, r, win.text) : append_ndjson_row(batch, r, win.text);
+                            }
+
+                            win.row_count += batch.row_count();
+                        } while (input.continue_index() > 0 && win.row_count < max_rows);
+
+                        genquery::close(*conn(), input);
+
+                        {
+                            std::scoped_lock lk{mutex};
+
+                            // A short window is the last one.
+                            if (win.row_count < max_rows) {
+                                end = std::min(end, w + 1);
+                            }
+
+                            ready.emplace(w, std::move(win));
+                        }
+
+                        cv.notify_all();
+                    }
+                }
+                catch (...) {
+                    {
+                        std::scoped_lock lk{mutex};
+                        if (!failure) {
+                            failure = std::current_exception();
+                        }
+                    }
+
+                    cv.notify_all();
+                }
+            };
+
+            std::vector<std::thread> workers;
+            workers.reserve(_parallelism);
+
+            const auto join_workers = irods::at_scope_exit{[&] {
+                {
+                    std::scoped_lock lk{mutex};
+                    stop = true;
+                }
+
+                cv.notify_all();
+
+                for (auto& t : workers) {
+                    t.join();
+                }
+            }};
+
+            for (std::size_t i = 0; i < std::min(_parallelism, end); ++i) {
+                workers.emplace_back(fetch_windows);
+            }
+
+            std::size_t rows_written = 0;
+
+            while (true) {
+                window win{{}, 0};
+
+                {
+                    std::unique_lock lk{mutex};
+                    cv.wait(lk, [&] { return failure || next_to_write >= end || ready.count(next_to_write) > 0; });
+
+                    // Windows which completed before a failure are still written, in order.
+                    if (0 == ready.count(next_to_write)) {
+                        if (failure) {
+                            std::rethrow_exception(failure);
+                        }
+
+                        break;
+                    }
+
+                    win = std::move(ready.extract(next_to_write).mapped());
+                    ++next_to_write;
+                }
+
+                cv.notify_all();
+
+                // A zero-length chunk terminates the response.
+                if (!win.text.empty()) {
+                    _stream << win.text;
+                    _stream.flush();
+                }
+
+                rows_written += win.row_count;
+            }
+
+            return rows_written;
+        } // export_windows
+
+        static constexpr std::string_view csv_media_type = "text/csv";
+        static constexpr std::string_view ndjson_media_type = "application/x-ndjson";
+
+        // Writes the names of the selected columns as the first CSV record.
+        static auto append_csv_header(genquery::input& _input, std::string& _out) -> void
+        {
+            const auto& select = _input.get()->selectInp;
+
+            for (int i = 0; i < select.len; ++i) {
+                if (i > 0) {
+                    _out += ',';
+                }
+
+                const auto* name = getAttrNameFromAttrId(select.inx[i]);
+                append_csv_field(name ? name : "", _out);
+            }
+
+            _out += "\r\n";
+        } // append_csv_header
+
+        static auto append_csv_row(const genquery::batch& _batch, int _row, std::string& _out) -> void
+        {
+            for (int c = 0; c < _batch.column_count(); ++c) {
+                if (c > 0) {
+                    _out += ',';
+                }
+
+                append_csv_field(_batch.value(_row, c), _out);
+            }
+
+            _out += "\r\n";
+        } // append_csv_row
+
+        // Quotes the field as described by RFC 4180 if it contains a delimiter, quote or line break.
+        static auto append_csv_field(const std::string_view _value, std::string& _out) -> void
+        {
+            if (_value.find_first_of(",\"\r\n") == std::string_view::npos) {
+                _out += _value;
+                return;
+            }
+
+            _out += '"';
+
+            for (auto c : _value) {
+                if ('"' == c) {
+                    _out += '"';
+                }
+
+                _out += c;
+            }
+
+            _out += '"';
+        } // append_csv_field
+
+        // Writes the "_embedded" member holding one array of strings per row.
+        template <typename Writer>
+        static auto write_rows(Writer& _writer, const std::vector<std::vector<std::string>>& _rows) -> void
+        {
+            _writer.key("_embedded").begin_array();
+
+            for (const auto& row : _rows) {
+                _writer.string_array(row);
+            }
+
+            _writer.end_array();
+        } // write_rows
+
+        static auto append_ndjson_row(const genquery::batch& _batch, int _row, std::string& _out) -> void
+        {
+            json_writer writer{_out};
+            writer.begin_array();
+
+            for (int c = 0; c < _batch.column_count(); ++c) {
+                writer.value(_batch.value(_row, c));
+            }
+
+            writer.end_array();
+            _out += '\n';
+        } // append_ndjson_row
+
+        // A GenQuery statement which is kept open on a pinned pooled connection so that
+        // subsequent pages can be fetched without executing the query again.
+        struct query_cursor
+        {
+            query_cursor(const std::string_view _query_string, int _options)
+                : input{_query_string, _options}
+            {
+            }
+
+            genquery::input input;
+            std::string token;
+            std::string jwt;
+            std::size_t limit{};
+            time_type expires_at{};
+            bool in_use{};
+        }; // struct query_cursor
+
+        using query_cursor_pointer = std::shared_ptr<query_cursor>;
+
+        auto open_cursor(const Pistache::Rest::Request& _request, response_encoding _encoding)
+            -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            auto _query_string = _request.query().get("query").get();
+            auto _query_limit = _request.query().get("limit").getOrElse("25");
+            auto _row_offset = _request.query().get("offset").getOrElse("0");
+            auto _query_type = _request.query().get("type").getOrElse("general");
+            auto _case_sensitive = _request.query().get("case-sensitive").getOrElse("1");
+            auto _distinct = _request.query().get("distinct").getOrElse("1");
+            auto _total = _request.query().get("total").getOrElse("0");
+
+            if ("general" != _query_type) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Cursors are only supported for general queries.");
+            }
+
+            const auto auth_header = _request.headers().getRaw("authorization").value();
+
+            std::string query_string{decode_url(_query_string)};
+            if ("0" == _case_sensitive) {
+                std::transform(query_string.begin(), query_string.end(), query_string.begin(), [](unsigned char c) {
+                    return std::toupper(c);
+                });
+            }
+
+            const auto query_limit = std::stoi(_query_limit);
+            const auto row_offset = std::stoi(_row_offset);
+
+            if (query_limit <= 0 || row_offset < 0) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Invalid limit or offset: limit must be positive and offset must not be negative.");
+            }
+
+            auto options = init_query_options(_case_sensitive, _distinct);
+            if ("1" == _total) {
+                options |= RETURN_TOTAL_ROW_COUNT;
+            }
+
+            auto cursor = std::make_shared<query_cursor>(query_string, options);
+            cursor->token = make_cursor_token();
+            cursor->jwt = extract_jwt(auth_header);
+            cursor->limit = query_limit;
+            cursor->input.set_row_offset(row_offset);
+            cursor->in_use = true;
+
+            std::vector<query_cursor_pointer> expired;
+            bool reserved = false;
+
+            {
+                std::scoped_lock lk{cursors_mutex_};
+
+                expired = remove_expired_cursors();
+
+                // The cursor takes its slot under the same lock as the check, so that concurrent
+                // opens cannot exceed the limit. The slot is released if the first page is the last.
+                if (cursors_.size() < max_cursors_) {
+                    cursors_.emplace(cursor->token, cursor);
+                    reserved = true;
+                }
+            }
+
+            close_cursors(expired);
+
+            if (!reserved) {
+                THROW(SYS_NOT_ALLOWED, "Maximum number of open query cursors reached. Try again later.");
+            }
+
+            const auto release_cursor = irods::at_scope_exit{[this, &cursor] {
+                std::scoped_lock lk{cursors_mutex_};
+                cursor->in_use = false;
+            }};
+
+            trace("Opening query cursor ...");
+            auto conn = [this, &auth_header, &cursor] {
+                try {
+                    return get_connection(auth_header, make_cursor_hint(cursor->token));
+                }
+                catch (...) {
+                    std::scoped_lock lk{cursors_mutex_};
+                    cursors_.erase(cursor->token);
+                    throw;
+                }
+            }();
+
+            try {
+                const auto page = genquery::fetch_page(*conn(), cursor->input, cursor->limit);
+
+                // The total row count is only computed for the first page.
+                cursor->input.get()->options &= ~RETURN_TOTAL_ROW_COUNT;
+
+                constexpr auto* url_part = "/query?query={}&limit={}&offset={}&type={}&case-sensitive={}&distinct={}&cursor=1";
+                const auto self = base_url + fmt::format(url_part,
+                                                         query_string,
+                                                         _query_limit,
+                                                         _row_offset,
+                                                         _query_type,
+                                                         _case_sensitive,
+                                                         _distinct);
+
+                return make_cursor_response(conn, cursor, page, "1" == _total, self, _encoding);
+            }
+            catch (...) {
+                {
+                    std::scoped_lock lk{cursors_mutex_};
+                    cursors_.erase(cursor->token);
+                }
+
+                genquery::close(*conn(), cursor->input);
+                conn.unpin();
+                throw;
+            }
+        } // open_cursor
+
+        auto continue_cursor(const Pistache::Rest::Request& _request, const std::string& _token, response_encoding _encoding)
+            -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            const auto auth_header = _request.headers().getRaw("authorization").value();
+            const auto jwt = extract_jwt(auth_header);
+
+            query_cursor_pointer cursor;
+            std::vector<query_cursor_pointer> expired;
+
+            {
+                std::scoped_lock lk{cursors_mutex_};
+
+                expired = remove_expired_cursors();
+
+                // Cursors are only visible to the token which opened them.
+                if (const auto iter = cursors_.find(_token); std::end(cursors_) != iter && iter->second->jwt == jwt) {
+                    cursor = iter->second;
+                }
+            }
+
+            close_cursors(expired);
+
+            {
+                std::scoped_lock lk{cursors_mutex_};
+
+                if (!cursor || cursors_.count(_token) == 0) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Query cursor does not exist or has expired.");
+                }
+
+                if (cursor->in_use) {
+                    THROW(SYS_NOT_ALLOWED, "Query cursor is in use.");
+                }
+
+                cursor->in_use = true;
+            }
+
+            const auto release_cursor = irods::at_scope_exit{[this, &cursor] {
+                std::scoped_lock lk{cursors_mutex_};
+                cursor->in_use = false;
+            }};
+
+            trace("Fetching next page from query cursor ...");
+            auto conn = get_connection(auth_header, make_cursor_hint(cursor->token));
+
+            try {
+                const auto page = genquery::fetch_page(*conn(), cursor->input, cursor->limit);
+                const auto self = base_url + fmt::format("/query?cursor={}", cursor->token);
+                return make_cursor_response(conn, cursor, page, false, self, _encoding);
+            }
+            catch (...) {
+                {
+                    std::scoped_lock lk{cursors_mutex_};
+                    cursors_.erase(cursor->token);
+                }
+
+                genquery::close(*conn(), cursor->input);
+                conn.unpin();
+                throw;
+            }
+        } // continue_cursor
+
+        auto make_cursor_response(connection_proxy& _conn,
+                                  const query_cursor_pointer& _cursor,
+                                  const genquery::page& _page,
+                                  bool _include_total,
+                                  const std::string& _self,
+                                  response_encoding _encoding) -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            const bool has_next = _cursor->input.continue_index() > 0;
+
+            if (has_next) {
+                // Keep the statement (and the connection it lives on) open until the cursor expires.
+                const auto expiration = time_type{std::chrono::system_clock::now() + cursor_ttl_};
+                _conn.pin_until(expiration);
+
+                std::scoped_lock lk{cursors_mutex_};
+                _cursor->expires_at = expiration;
+                cursors_.insert_or_assign(_cursor->token, _cursor);
+            }
+            else {
+                trace("Query cursor exhausted.");
+
+                {
+                    std::scoped_lock lk{cursors_mutex_};
+                    cursors_.erase(_cursor->token);
+                }
+
+                _conn.unpin();
+            }
+
+            auto body = write_document(_encoding, [&](auto& writer) {
+                writer.begin_object();
+                write_rows(writer, _page.rows);
+
+                writer.key("_links").begin_object();
+                if (has_next) {
+                    writer.member("next", base_url + fmt::format("/query?cursor={}", _cursor->token));
+                }
+                writer.member("self", _self);
+                writer.end_object();
+
+                writer.member("count", std::to_string(_page.rows.size()));
+
+                if (has_next) {
+                    writer.member("cursor", _cursor->token);
+                }
+
+                if (_include_total) {
+                    writer.member("total", std::to_string(_page.total_row_count));
+                }
+
+                writer.end_object();
+            });
+
+            return std::make_tuple(Pistache::Http::Code::Ok, std::move(body));
+        } // make_cursor_response
+
+        // Requires cursors_mutex_ to be held. Returns the cursors removed. The caller must pass
+        // them to close_cursors once the lock is released.
+        auto remove_expired_cursors() -> std::vector<query_cursor_pointer>
+        {
+            const auto now = std::chrono::system_clock::now();
+
+            std::vector<query_cursor_pointer> expired;
+
+            for (auto iter = std::begin(cursors_); iter != std::end(cursors_);) {
+                if (!iter->second->in_use && iter->second->expires_at <= now) {
+                    expired.push_back(std::move(iter->second));
+                    iter = cursors_.erase(iter);
+                }
+                else {
+                    ++iter;
+                }
+            }
+
+            return expired;
+        } // remove_expired_cursors
+
+        // Closes the statements of removed cursors and releases the connections they pinned. A
+        // connection which has already been evicted took its statement with it.
+        auto close_cursors(const std::vector<query_cursor_pointer>& _cursors) -> void
+        {
+            for (const auto& cursor : _cursors) {
+                if (auto conn = try_get_pooled_connection(cursor->jwt, make_cursor_hint(cursor->token)); conn) {
+                    trace("Closing expired query cursor ...");
+                    genquery::close(*(*conn)(), cursor->input);
+                    conn->unpin();
+                }
+            }
+        } // close_cursors
+
+        static auto make_cursor_token() -> std::string
+        {
+            constexpr int token_len = 32;
+
+            unsigned char random_bytes[token_len];
+            irods::getRandomBytes(random_bytes, token_len);
+
+            constexpr std::string_view character_set = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+
+            std::string token;
+            token.reserve(token_len);
+
+            for (auto b : random_bytes) {
+                token += character_set[b % character_set.size()];
+            }
+
+            return token;
+        } // make_cursor_token
+
+        static auto make_cursor_hint(const std::string_view _token) -> std::string
+        {
+            return fmt::format("query_cursor_{}", _token);
+        } // make_cursor_hint
+
+        auto execute_prepared(const Pistache::Rest::Request& _request, const std::string& _name, response_encoding _encoding)
+            -> std::tuple<Pistache::Http::Code, std::string>
+        {
+            const auto iter = prepared_queries_.find(_name);
+
+            if (iter == std::end(prepared_queries_)) {
+                THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Prepared query [{}] does not exist.", _name));
+            }
+
+            const auto& prepared = iter->second;
+
+            auto _query_limit = _request.query().get("limit").getOrElse("25");
+            auto _row_offset = _request.query().get("offset").getOrElse("0");
+            auto _case_sensitive = _request.query().get("case-sensitive").getOrElse("1");
+            auto _distinct = _request.query().get("distinct").getOrElse("1");
+
+            const auto auth_header = _request.headers().getRaw("authorization").value();
+
+            const auto query_limit = std::stoi(_query_limit);
+            const auto row_offset = std::stoi(_row_offset);
+
+            if (query_limit <= 0 || row_offset < 0) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Invalid limit or offset: limit must be positive and offset must not be negative.");
+            }
+
+            const auto options = init_query_options(_case_sensitive, _distinct);
+
+            std::vector<std::string> parameters;
+            parameters.reserve(prepared.parameter_count());
+
+            std::string self = base_url + fmt::format("/query?prepared={}", _name);
+
+            for (std::size_t i = 1; i <= prepared.parameter_count(); ++i) {
+                const auto p = _request.query().get(fmt::format("p{}", i));
+
+                if (p.isEmpty()) {
+                    THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Missing parameter [p{}] for prepared query [{}].", i, _name));
+                }
+
+                parameters.push_back(decode_url(p.get()));
+                self += fmt::format("&p{}={}", i, p.get());
+            }
+
+            // The cache key is built from the name and the parameters. The query string is never
+            // assembled or parsed.
+            std::string cache_key = fmt::format("{}\x1fprepared\x1f{}", get_user_name(auth_header), _name);
+            for (const auto& p : parameters) {
+                cache_key += '\x1e';
+                cache_key += p;
+            }
+            cache_key += fmt::format("\x1f{}\x1f{}\x1f{}", query_limit, row_offset, options);
+
+            const auto result = query_cache_.get_or_compute(cache_key, [&] {
+                trace("Executing prepared query [{}] ...", _name);
+                auto conn = get_any_connection(auth_header, shared_connection_hint, batch_parallelism_);
+
+                // The catalog counts the rows of the whole query, so that "total" does not depend
+                // on the page requested.
+                genquery::input input;
+                prepared.bind(input, parameters, options | RETURN_TOTAL_ROW_COUNT);
+                input.set_row_offset(row_offset);
+
+                auto page = genquery::fetch_page(*conn(), input, query_limit);
+                genquery::close(*conn(), input);
+
+                auto r = std::make_shared<query_result>();
+                r->rows = std::move(page.rows);
+                r->size = static_cast<uintmax_t>(std::max(0, page.total_row_count));
+
+                return query_result_pointer{r};
+            });
+
+            self += fmt::format("&case-sensitive={}&distinct={}&limit={}", _case_sensitive, _distinct, query_limit);
+
+            const auto next_offset = static_cast<uintmax_t>(row_offset) + result->rows.size();
+
+            auto body = write_document(_encoding, [&](auto& writer) {
+                writer.begin_object();
+                write_rows(writer, result->rows);
+
+                writer.key("_links").begin_object();
+                writer.member("first", self + "&offset=0");
+                if (next_offset < result->size) {
+                    writer.member("next", self + fmt::format("&offset={}", next_offset));
+                }
+                writer.member("prev", self + fmt::format("&offset={}", std::max(0, row_offset - query_limit)));
+                writer.member("self", self + fmt::format("&offset={}", row_offset));
+                writer.end_object();
+
+                writer.member("count", std::to_string(result->rows.size()));
+                writer.member("total", std::to_string(result->size));
+                writer.end_object();
+            });
+
+            return std::make_tuple(Pistache::Http::Code::Ok, std::move(body));
+        } // execute_prepared
+
+        // The parameters identifying a page of /query results. query_string is decoded.
+        struct page_request
+        {
+            std::string query_string;
+            std::string limit;
+            std::string offset;
+            std::string type;
+            std::string case_sensitive;
+            std::string distinct;
+            response_encoding encoding;
+        }; // struct page_request
+
+        struct page_response
+        {
+            std::string body;
+            std::size_t row_count;
+        }; // struct page_response
+
+        template <typename GetConnection>
+        auto make_page(const std::string& _user_name, const page_request& _page, GetConnection _get_connection)
+            -> page_response
+        {
+            const auto& [query_string, _query_limit, _row_offset, _query_type, _case_sensitive, _distinct, _encoding] = _page;
+
+            uintmax_t row_offset  = std::stoi(_row_offset);
+            uintmax_t query_limit = std::stoi(_query_limit);
+
+            const auto query_type = irods::query<rcComm_t>::convert_string_to_query_type(_query_type);
+            const auto options = init_query_options(_case_sensitive, _distinct);
+
+            const auto result = get_result(_user_name, query_string, query_type, query_limit, row_offset, options, _get_connection);
+
+            uintmax_t current_row_count = result->rows.size();
+            uintmax_t total_row_count = result->size + row_offset;
+
+            double dbl_row_offset  = static_cast<double>(row_offset);
+            double dbl_query_limit = static_cast<double>(query_limit);
+            double dbl_total_row_count = static_cast<double>(total_row_count);
+
+            double total_pages = dbl_total_row_count / dbl_query_limit;
+            double fraction_remaining_pages = total_pages - std::trunc(total_pages);
+            double remaining_rows = fraction_remaining_pages * static_cast<double>(dbl_query_limit);
+            double final_page_delta = (remaining_rows == 0.0) ? dbl_query_limit : remaining_rows;
+            double last_page_number = dbl_total_row_count - final_page_delta;
+
+            double current_page_number = dbl_row_offset / dbl_query_limit;
+            double next_page_number = std::trunc(current_page_number) + 1 * dbl_query_limit;
+            next_page_number = (next_page_number >= dbl_total_row_count) ? last_page_number : next_page_number;
+
+            auto prev_count = dbl_row_offset - dbl_query_limit;
+
+            constexpr auto* url_part = "/query?query={}&limit={}&offset={}&type={}&case-sensitive={}&distinct={}";
+            const auto make_link = [&](const auto& _link_offset) {
+                return base_url + fmt::format(url_part, query_string, _query_limit, _link_offset, _query_type, _case_sensitive, _distinct);
+            };
+
+            auto body = write_document(_encoding, [&](auto& writer) {
+                // Keys are written in sorted order to match the output of nlohmann::json.
+                writer.begin_object();
+                write_rows(writer, result->rows);
+
+                writer.key("_links").begin_object();
+                writer.member("first", make_link("0"));
+                writer.member("last", make_link(static_cast<int>(last_page_number)));
+                writer.member("next", make_link(static_cast<int>(next_page_number)));
+                writer.member("prev", make_link(static_cast<int>(std::max(0.0, prev_count))));
+                writer.member("self", make_link(_row_offset));
+                writer.end_object();
+
+                writer.member("count", std::to_string(current_row_count));
+                writer.member("total", std::to_string(total_row_count));
+                writer.end_object();
+            });
+
+            return {std::move(body), result->rows.size()};
+        } // make_page
+
+        static auto make_prefetch_key(const page_request& _page) -> std::string
+        {
+            return fmt::format("{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{}",
+                               normalize_query_string(_page.query_string),
+                               std::stoull(_page.limit),
+                               std::stoull(_page.offset),
+                               _page.type,
+                               _page.case_sensitive,
+                               _page.distinct,
+                               static_cast<int>(_page.encoding));
+        } // make_prefetch_key
+
+        // Computes the page following _page in the background on an idle pooled connection.
+        auto prefetch_next_page(const std::string& _user_name, const std::string& _auth_header, page_request _page)
+            -> void
+        {
+            if (!prefetch_.enabled()) {
+                return;
+            }
+
+            _page.offset = std::to_string(std::stoull(_page.offset) + std::stoull(_page.limit));
+
+            prefetch_.schedule(_user_name, make_prefetch_key(_page), [this, _user_name, _auth_header, _page]() -> std::optional<page_response> {
+                auto conn = try_get_idle_connection(_auth_header, prefetch_connection_hint, 1);
+
+                if (!conn) {
+                    trace("Skipping prefetch. No idle connection available.");
+                    return std::nullopt;
+                }
+
+                return make_page(_user_name, _page, [&conn] { return std::move(*conn); });
+            });
+        } // prefetch_next_page
+
+        // Accepts strings and numbers so that batch entries may use either for numeric options.
+        static auto get_batch_option(const nlohmann::json& _entry, const std::string& _key, const std::string& _default)
+            -> std::string
+        {
+            const auto iter = _entry.find(_key);
+
+            if (iter == std::end(_entry)) {
+                return _default;
+            }
+
+            if (iter->is_string()) {
+                return iter->get<std::string>();
+            }
+
+            if (iter->is_number_integer()) {
+                return std::to_string(iter->get<std::int64_t>());
+            }
+
+            THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Invalid value for [{}] in batch entry.", _key));
+        } // get_batch_option
+
+        auto execute_batch_entry(const std::string& _auth_header,
+                                 const std::string& _user_name,
+                                 const nlohmann::json& _entry) -> nlohmann::json
+        {
+            if (!_entry.is_object() || !_entry.contains("query")) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Batch entry must be an object containing a query.");
+            }
+
+            auto query_string = _entry.at("query").get<std::string>();
+            const auto _query_limit = get_batch_option(_entry, "limit", "25");
+            const auto _row_offset = get_batch_option(_entry, "offset", "0");
+            const auto _query_type = get_batch_option(_entry, "type", "general");
+            const auto _case_sensitive = get_batch_option(_entry, "case-sensitive", "1");
+            const auto _distinct = get_batch_option(_entry, "distinct", "1");
+
+            if ("0" == _case_sensitive) {
+                std::transform(query_string.begin(), query_string.end(), query_string.begin(), [](unsigned char c) {
+                    return std::toupper(c);
+                });
+            }
+
+            uintmax_t row_offset  = std::stoi(_row_offset);
+            uintmax_t query_limit = std::stoi(_query_limit);
+
+            const auto query_type = irods::query<rcComm_t>::convert_string_to_query_type(_query_type);
+            const auto options = init_query_options(_case_sensitive, _distinct);
+
+            const auto result = get_result(_user_name, query_string, query_type, query_limit, row_offset, options, [&] {
+                return get_any_connection(_auth_header, shared_connection_hint, batch_parallelism_);
+            });
+
+            nlohmann::json results = nlohmann::json::object();
+            results["_embedded"] = result->rows;
+            results["count"] = std::to_string(result->rows.size());
+            results["total"] = std::to_string(result->size + row_offset);
+
+            return results;
+        } // execute_batch_entry
+
+        struct query_result
+        {
+            std::vector<std::vector<std::string>> rows;
+            uintmax_t size;
+        }; // struct query_result
+
+        using query_result_pointer = std::shared_ptr<const query_result>;
+
+        auto execute_query(connection_proxy& _conn,
+                           const std::string& _query_string,
+                           uintmax_t _query_limit,
+                           uintmax_t _row_offset,
+                           irods::query<rcComm_t>::query_type _query_type,
+                           int _options) -> query_result_pointer
+        {
+            irods::query query{_conn(), _query_string, _query_limit, _row_offset, _query_type, _options};
+
+            auto result = std::make_shared<query_result>();
+            result->size = query.size();
+            result->rows.reserve(result->size);
+
+            for (auto&& row : query) {
+                result->rows.push_back(row);
+            }
+
+            return result;
+        } // execute_query
+
+        // Identical requests from the same user share a single execution of the query. _get_connection
+        // is only invoked if the query needs to be executed.
+        template <typename GetConnection>
+        auto get_result(const std::string& _user_name,
+                        const std::string& _query_string,
+                        irods::query<rcComm_t>::query_type _query_type,
+                        uintmax_t _query_limit,
+                        uintmax_t _row_offset,
+                        int _options,
+                        GetConnection _get_connection) -> query_result_pointer
+        {
+            const auto cache_key = fmt::format("{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{}",
+                                               _user_name,
+                                               normalize_query_string(_query_string),
+                                               static_cast<int>(_query_type),
+                                               _query_limit,
+                                               _row_offset,
+                                               _options);
+
+            return query_cache_.get_or_compute(cache_key, [&] {
+                trace("Executing query ...");
+                auto conn = _get_connection();
+                return execute_query(conn, _query_string, _query_limit, _row_offset, _query_type, _options);
+            });
+        } // get_result
+
+        // Collapses runs of whitespace outside of quoted literals so that queries which only
+        // differ in formatting map to the same cache entry.
+        static auto normalize_query_string(const std::string_view _query_string) -> std::string
+        {
+            std::string normalized;
+            normalized.reserve(_query_string.size());
+
+            bool in_literal = false;
+            bool pending_space = false;
+
+            for (auto c : _query_string) {
+                if (!in_literal && std::isspace(static_cast<unsigned char>(c))) {
+                    pending_space = !normalized.empty();
+                    continue;
+                }
+
+                if (pending_space) {
+                    normalized += ' ';
+                    pending_space = false;
+                }
+
+                if ('\'' == c) {
+                    in_literal = !in_literal;
+                }
+
+                normalized += c;
+            }
+
+            return normalized;
+        } // normalize_query_string
+
         int init_query_options(const std::string_view _case_sensitive,
                                const std::string_view _distinct)
         {
@@ -167,6 +1290,23 @@ namespace irods::rest
 
             return options;
         } // init_query_options
+
+        expiring_cache<std::string, query_result_pointer> query_cache_;
+
+        std::mutex cursors_mutex_;
+        std::map<std::string, query_cursor_pointer> cursors_;
+        std::chrono::seconds cursor_ttl_;
+        std::size_t max_cursors_;
+
+        std::size_t max_batch_size_;
+        std::size_t batch_parallelism_;
+
+        std::map<std::string, genquery::prepared_query> prepared_queries_;
+
+        std::size_t max_export_parallelism_;
+
+        // Declared last so that background work stops before the members it uses are destroyed.
+        prefetch_buffer<page_response> prefetch_;
     }; // class query
 } // namespace irods::rest
 
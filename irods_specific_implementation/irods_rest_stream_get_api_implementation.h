@@ -13,6 +13,11 @@
 #include <pistache/optional.h>
 #include <pistache/router.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
 #include <vector>
 #include <iterator>
 
@@ -25,12 +30,38 @@ namespace irods::rest
     namespace fs = ix::filesystem;
     namespace io = ix::io;
 
+    namespace
+    {
+        namespace configuration_keywords
+        {
+            const std::string anonymous_ticket_access{"anonymous_ticket_access"};
+            const std::string enabled{"enabled"};
+            const std::string user_name{"user_name"};
+            const std::string connections{"maximum_number_of_connections"};
+            const std::string wait_time{"maximum_wait_time_in_milliseconds"};
+        } // namespace configuration_keywords
+    } // namespace
+
     class stream : public api_base
     {
     public:
         stream()
             : api_base{service_name}
         {
+            namespace keywords = configuration_keywords;
+
+            const auto cfg = get_configuration_option<nlohmann::json>(keywords::anonymous_ticket_access, nlohmann::json::object());
+
+            if (cfg.value(keywords::enabled, false)) {
+                anonymous_access_ = anonymous_access{
+                    cfg.value(keywords::user_name, std::string{"anonymous"}),
+                    std::max<std::size_t>(1, cfg.value(keywords::connections, std::size_t{4})),
+                    std::chrono::milliseconds{cfg.value(keywords::wait_time, std::uint32_t{1000})}};
+
+                info("Anonymous ticket access enabled [user_name={}, maximum_number_of_connections={}].",
+                     anonymous_access_->user_name, anonymous_access_->connections);
+            }
+
             info("Endpoint initialized.");
         }
 
@@ -44,7 +75,7 @@ namespace irods::rest
                 auto _offset = _request.query().get("offset");
 
                 const auto& headers = _request.headers();
-                auto conn = get_connection(headers.getRaw("authorization").value());
+                auto conn = get_connection_for_request(headers);
 
                 if (const auto ec = set_session_ticket_if_available(headers, conn); ec != 0) {
                     error("Encountered error [{}] while handling session ticket.", ec);
@@ -88,7 +119,10 @@ namespace irods::rest
                 std::vector<char> buffer(bytes_to_read);
 
                 trace("Reading data into buffer ...");
-                ds.read(buffer.data(), buffer.size());
+                {
+                    const tracing::span span{"dstream.read"};
+                    ds.read(buffer.data(), buffer.size());
+                }
 
                 trace("Read completed! Returning ...");
                 return std::make_tuple(Pistache::Http::Code::Ok, std::string(buffer.data(), ds.gcount()));
@@ -104,6 +138,24 @@ namespace irods::rest
         } // operator()
 
     private:
+        // Requests without an authorization header are served as the anonymous user if they
+        // carry a ticket and anonymous ticket access is enabled.
+        auto get_connection_for_request(const Pistache::Http::Header::Collection& _headers) -> connection_proxy
+        {
+            if (!_headers.tryGetRaw("authorization").isEmpty()) {
+                return get_connection_for_session_ticket(_headers);
+            }
+
+            const auto ticket = _headers.tryGetRaw("irods-ticket");
+
+            if (!anonymous_access_ || ticket.isEmpty()) {
+                THROW(CAT_INVALID_AUTHENTICATION, "Authorization header required");
+            }
+
+            return get_connection_for_anonymous_ticket(
+                anonymous_access_->user_name, anonymous_access_->connections, anonymous_access_->wait_time);
+        } // get_connection_for_request
+
         std::int32_t get_number_of_bytes_to_read(const std::string& _count) const
         {
             trace("Getting number of bytes to read ...");
@@ -123,6 +175,16 @@ namespace irods::rest
                 THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Invalid byte count [{}]", _count));
             }
         } // get_number_of_bytes_to_read
+
+        struct anonymous_access
+        {
+            std::string user_name;
+            std::size_t connections;
+            std::chrono::milliseconds wait_time;
+        }; // struct anonymous_access
+
+        // Set if requests carrying only a ticket are allowed.
+        std::optional<anonymous_access> anonymous_access_;
     }; // class stream
 } // namespace irods::rest
 
@@ -15,6 +15,8 @@
 #include <pistache/router.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 
 namespace irods::rest
 {
@@ -46,7 +48,7 @@ namespace irods::rest
                 auto _truncate = _request.query().get("truncate");
 
                 const auto& headers = _request.headers();
-                auto conn = get_connection(headers.getRaw("authorization").value());
+                auto conn = get_connection_for_session_ticket(headers);
 
                 if (const auto ec = set_session_ticket_if_available(headers, conn); ec != 0) {
                     error("Encountered error [{}] while handling session ticket.", ec);
@@ -65,7 +67,12 @@ namespace irods::rest
 
                 apply_offset(_offset, ds);
 
-                if (const auto count = calculate_bytes_to_write(_body.size(), _count); count > 0) {
+                const tracing::span span{"dstream.write"};
+
+                if (const auto coding = get_content_coding(headers, _body); compression::content_coding::identity != coding) {
+                    write_decompressed(_body, coding, _count, ds);
+                }
+                else if (const auto count = calculate_bytes_to_write(_body.size(), _count); count > 0) {
                     trace("Writing [{}] bytes to replica.", count);
                     ds.write(_body.c_str(), count);
                 }
@@ -122,6 +129,66 @@ namespace irods::rest
             }
         } // apply_offset
 
+        // Pistache does not recognize zstd as a content coding, so a body declared with an
+        // unrecognized coding is identified by its magic number.
+        compression::content_coding get_content_coding(const Pistache::Http::Header::Collection& _headers,
+                                                       const std::string& _body) const
+        {
+            using Pistache::Http::Header::Encoding;
+
+            const auto header = _headers.tryGet<Pistache::Http::Header::ContentEncoding>();
+
+            if (!header) {
+                return compression::content_coding::identity;
+            }
+
+            switch (header->encoding()) {
+                case Encoding::Identity:
+                case Encoding::Chunked:
+                    return compression::content_coding::identity;
+
+                case Encoding::Gzip:
+                case Encoding::Deflate:
+                    return compression::content_coding::gzip;
+
+                default:
+                    if (const auto coding = compression::detect(_body); compression::content_coding::zstd == coding) {
+                        return coding;
+                    }
+
+                    THROW(SYS_INVALID_INPUT_PARAM, "Unsupported Content-Encoding");
+            }
+        } // get_content_coding
+
+        // Decompresses _body directly into the replica. The byte count applies to the
+        // decompressed data.
+        void write_decompressed(const std::string& _body,
+                                compression::content_coding _coding,
+                                const Pistache::Optional<std::string>& _count,
+                                io::odstream& _stream) const
+        {
+            auto remaining = calculate_bytes_to_write(std::numeric_limits<std::int64_t>::max(), _count);
+            std::int64_t total = 0;
+
+            compression::decoder decoder{_coding};
+
+            decoder.update(_body, [&](const char* _data, std::size_t _size) {
+                const auto n = std::min<std::int64_t>(remaining, _size);
+
+                if (n > 0) {
+                    _stream.write(_data, n);
+                    remaining -= n;
+                    total += n;
+                }
+            });
+
+            if (!decoder.done()) {
+                THROW(SYS_INVALID_INPUT_PARAM, "Compressed body is incomplete");
+            }
+
+            debug("Wrote [{}] decompressed bytes to replica.", total);
+        } // write_decompressed
+
         std::int64_t calculate_bytes_to_write(std::int64_t _buffer_size,
                                               const Pistache::Optional<std::string>& _count) const
         {
@@ -1,6 +1,7 @@
 #include "irods_rest_api_base.h"
 
 #include "constants.hpp"
+#include "parallel.hpp"
 #include <irods/filesystem.hpp>
 #include <irods/rodsClient.h>
 #include <irods/irods_random.hpp>
@@ -16,10 +17,14 @@
 #include <fmt/format.h>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <iterator>
 #include <string_view>
 #include <iomanip>
 #include <sstream>
+#include <vector>
 
 using json = nlohmann::json;
 
@@ -28,12 +33,26 @@ namespace irods::rest
     // this is contractually tied directly to the api implementation
     const std::string service_name{"irods_rest_cpp_ticket_server"};
 
+    namespace
+    {
+        namespace configuration_keywords
+        {
+            const std::string batch_max_tickets{"batch_maximum_number_of_tickets"};
+            const std::string batch_parallelism{"batch_parallelism"};
+        } // namespace configuration_keywords
+    } // namespace
+
     class ticket : public api_base
     {
     public:
         ticket()
             : api_base{service_name}
         {
+            namespace keywords = configuration_keywords;
+
+            max_batch_size_ = get_configuration_option<std::size_t>(keywords::batch_max_tickets, 1024);
+            batch_parallelism_ = std::max<std::size_t>(1, get_configuration_option<std::size_t>(keywords::batch_parallelism, 4));
+
             info("Endpoint initialized.");
         }
 
@@ -43,18 +62,12 @@ namespace irods::rest
         {
             namespace fs = irods::experimental::filesystem;
 
-            std::string ticket_id;
-
             try {
                 auto _logical_path = _request.query().get("logical-path").get();
                 auto _type = _request.query().get("type");
-                auto _use_count = _request.query().get("use-count");
-                auto _write_file_count = _request.query().get("write-file-count");
-                auto _write_byte_count = _request.query().get("write-byte-count");
-                auto _seconds_until_expiration = _request.query().get("seconds-until-expiration");
-                auto _users = _request.query().get("users");
-                auto _groups = _request.query().get("groups");
-                auto _hosts = _request.query().get("hosts");
+
+                // Invalid input is rejected before the ticket is created.
+                const auto modifications = make_ticket_modifications(_request.query());
 
                 auto conn = get_connection(_request.headers().getRaw("authorization").value());
 
@@ -62,18 +75,7 @@ namespace irods::rest
                 debug("Logical path = [{}]", logical_path.c_str());
 
                 const auto size = fs::client::data_object_size(*conn(), logical_path);
-                ticket_id = make_ticket_id();
-
-                // TODO These calls could benefit from an atomic_apply_ticket_operations API plugin.
-                // Each one of these calls results in at least one network call.
-                create_ticket(conn, ticket_id, _type, logical_path.c_str());
-                set_ticket_use_count(conn, ticket_id, _use_count);
-                set_ticket_write_file_count(conn, ticket_id, _write_file_count);
-                set_ticket_write_byte_count(conn, ticket_id, _write_byte_count);
-                set_ticket_expiration_timestamp(conn, ticket_id, _seconds_until_expiration);
-                set_ticket_allowed_users(conn, ticket_id, _users);
-                set_ticket_allowed_groups(conn, ticket_id, _groups);
-                set_ticket_allowed_hosts(conn, ticket_id, _hosts);
+                const auto ticket_id = issue_ticket(conn, logical_path.string(), _type.getOrElse("read"), modifications);
 
                 using json = nlohmann::json;
 
@@ -81,29 +83,135 @@ namespace irods::rest
                     {"headers", json::object({
                         {"irods-ticket", json::array({ticket_id})}
                     })},
-                    {"url", fmt::format("{}/stream?logical-path={}&offset=0&count={}", base_url, logical_path.c_str(), size)}
+                    {"url", make_stream_url(logical_path.string(), size)}
                 });
 
                 return std::make_tuple(Pistache::Http::Code::Ok, results.dump());
             }
             catch (const fs::filesystem_error& e) {
                 error("Caught exception - [error_code={}] {}", e.code().value(), e.what());
-                delete_ticket(_request, ticket_id);
                 return make_error_response(e.code().value(), e.what());
             }
             catch (const irods::exception& e) {
                 error("Caught exception - [error_code={}] {}", e.code(), e.what());
-                delete_ticket(_request, ticket_id);
                 return make_error_response(e.code(), e.what());
             }
             catch (const std::exception& e) {
                 error("Caught exception - {}", e.what());
-                delete_ticket(_request, ticket_id);
                 return make_error_response(SYS_INTERNAL_ERR, e.what());
             }
         } // operator()
 
+        // Issues a ticket with the settings of the query parameters for each logical path in a
+        // JSON array. Tickets are created concurrently and returned in input order.
+        std::tuple<Pistache::Http::Code, std::string>
+        batch(const Pistache::Rest::Request& _request,
+              Pistache::Http::ResponseWriter& _response)
+        {
+            try {
+                const auto auth_header = _request.headers().getRaw("authorization").value();
+                const auto type = _request.query().get("type").getOrElse("read");
+                const auto recursive = is_set(_request.query().get("recursive").getOrElse("0"));
+
+                // Invalid input is rejected before any ticket is created.
+                const auto modifications = make_ticket_modifications(_request.query());
+
+                const auto paths = nlohmann::json::parse(_request.body());
+
+                if (!paths.is_array() || paths.empty()) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Request body must be a non-empty JSON array of logical paths.");
+                }
+
+                if (paths.size() > max_batch_size_) {
+                    THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Too many tickets in batch: limit is {}.", max_batch_size_));
+                }
+
+                // Collections are expanded first so that the tickets can be spread evenly
+                // across the workers.
+                std::vector<std::vector<batch_entry>> resolved(paths.size());
+
+                for_each_index_in_parallel(paths.size(), batch_parallelism_, [&](std::size_t _i) {
+                    resolved[_i] = resolve_batch_path(auth_header, paths[_i], recursive);
+                });
+
+                std::vector<batch_entry> entries;
+
+                for (auto&& r : resolved) {
+                    entries.insert(entries.end(), std::make_move_iterator(r.begin()), std::make_move_iterator(r.end()));
+                }
+
+                if (entries.size() > max_batch_size_) {
+                    THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Too many tickets in batch: limit is {}.", max_batch_size_));
+                }
+
+                for_each_index_in_parallel(entries.size(), batch_parallelism_, [&](std::size_t _i) {
+                    auto& entry = entries[_i];
+
+                    if (entry.result.contains("error_code")) {
+                        return;
+                    }
+
+                    try {
+                        auto conn = get_any_connection(auth_header, batch_connection_hint, batch_parallelism_);
+                        entry.result["ticket"] = issue_ticket(conn, entry.logical_path, type, modifications);
+                        entry.result["url"] = make_stream_url(entry.logical_path, entry.size);
+                    }
+                    catch (const irods::exception& e) {
+                        error("Caught exception in batch entry [{}] - [error_code={}] {}", _i, e.code(), e.what());
+                        entry.result["error_code"] = e.code();
+                        entry.result["error_message"] = e.client_display_what();
+                    }
+                    catch (const std::exception& e) {
+                        error("Caught exception in batch entry [{}] - {}", _i, e.what());
+                        entry.result["error_code"] = SYS_INTERNAL_ERR;
+                        entry.result["error_message"] = e.what();
+                    }
+                });
+
+                auto results = nlohmann::json::array();
+
+                for (auto&& entry : entries) {
+                    results.push_back(std::move(entry.result));
+                }
+
+                return std::make_tuple(Pistache::Http::Code::Ok, results.dump());
+            }
+            catch (const irods::exception& e) {
+                error("Caught exception - [error_code={}] {}", e.code(), e.what());
+                return make_error_response(e.code(), e.client_display_what());
+            }
+            catch (const std::exception& e) {
+                error("Caught exception - {}", e.what());
+                return make_error_response(SYS_INVALID_INPUT_PARAM, e.what());
+            }
+        } // batch
+
     private:
+        // Prefix of the pooled connections used by the workers of batches.
+        inline static const std::string batch_connection_hint{"ticket_batch_"};
+
+        // A data object to issue a ticket for and the JSON result reported for it.
+        struct batch_entry
+        {
+            std::string logical_path;
+            std::uintmax_t size;
+            nlohmann::json result;
+        };
+
+        // The arguments of a "mod" call to rcTicketAdmin.
+        struct ticket_modification
+        {
+            std::string property;
+            std::string arg0;
+            std::string arg1;
+        };
+
+        // Values the catalog assigns to a new ticket. Requests for these values need no
+        // modification.
+        static constexpr std::int64_t default_use_count = 0;
+        static constexpr std::int64_t default_write_file_count = 10;
+        static constexpr std::int64_t default_write_byte_count = 0;
+
         std::string make_ticket_id() const
         {
             trace("Generating ticket identifier ...");
@@ -137,152 +245,176 @@ namespace irods::rest
             return new_ticket;
         } // make_ticket_id
 
-        void delete_ticket(const Pistache::Rest::Request& _request, const std::string_view _ticket_id) noexcept
+        // Creates a ticket for _logical_path and applies _modifications to it. The ticket is
+        // deleted if any of the modifications fail.
+        std::string issue_ticket(connection_proxy& _conn,
+                                 const std::string& _logical_path,
+                                 const std::string& _type,
+                                 const std::vector<ticket_modification>& _modifications)
         {
-            try {
-                auto conn = get_connection(_request.headers().getRaw("authorization").value());
+            const auto ticket_id = make_ticket_id();
 
-                const auto gql = fmt::format("select TICKET_ID where ticket_string = '{}'", _ticket_id);
+            trace("Creating ticket [{}] ...", ticket_id);
+            rx_ticket(*_conn(), "create", ticket_id, _type, _logical_path);
 
-                if (irods::query q{conn(), gql}; q.size() == 0) {
-                    return;
+            // Each modification is a round trip to the catalog provider, so they are issued
+            // back to back on the connection which created the ticket.
+            try {
+                for (const auto& m : _modifications) {
+                    trace("Setting [{}] on ticket [{}] ...", m.property, ticket_id);
+                    rx_ticket(*_conn(), "mod", ticket_id, m.property, m.arg0, m.arg1);
                 }
+            }
+            catch (...) {
+                delete_ticket(_conn, ticket_id);
+                throw;
+            }
 
-                rx_ticket(*conn(), "create", _ticket_id);
-            } catch (...) {}
-        } // delete_ticket
+            return ticket_id;
+        } // issue_ticket
 
-        void create_ticket(connection_proxy& _conn,
-                           const std::string_view _ticket_id,
-                           const Pistache::Optional<std::string>& _ticket_type,
-                           const std::string_view _logical_path) const
+        std::string make_stream_url(const std::string& _logical_path, std::uintmax_t _size) const
         {
-            trace("Creating ticket [{}] ...", _ticket_id);
-            rx_ticket(*_conn(), "create", _ticket_id, _ticket_type.getOrElse("read"), _logical_path);
-        } // create_ticket
-
-        void set_ticket_use_count(connection_proxy& _conn,
-                                  const std::string_view& _ticket_id,
-                                  const Pistache::Optional<std::string>& _use_count) const
+            return fmt::format("{}/stream?logical-path={}&offset=0&count={}", base_url, _logical_path, _size);
+        } // make_stream_url
+
+        // Returns the data objects named by an entry of a batch request. With _recursive, a
+        // collection is replaced by every data object under it. An entry which cannot be
+        // resolved becomes a single error result.
+        std::vector<batch_entry> resolve_batch_path(const std::string& _auth_header,
+                                                    const nlohmann::json& _path,
+                                                    bool _recursive)
         {
-            trace("Setting use-count on ticket [{}] ...", _ticket_id);
-
-            const auto count = _use_count.getOrElse("0");
-            debug("use_count = [{}]", count);
-            rx_ticket(*_conn(), "mod", _ticket_id, "uses", count);
-        } // set_ticket_use_count
+            namespace fs = irods::experimental::filesystem;
 
-        void set_ticket_write_file_count(connection_proxy& _conn,
-                                         const std::string_view _ticket_id,
-                                         const Pistache::Optional<std::string>& _file_count)
-        {
-            trace("Setting write-file count on ticket [{}] ...", _ticket_id);
+            const auto logical_path = _path.is_string() ? _path.get<std::string>() : _path.dump();
 
-            const auto count = _file_count.getOrElse("0");
-            debug("write_file_count = [{}]", count);
-            rx_ticket(*_conn(), "mod", _ticket_id, "write-file", count);
-        } // set_ticket_write_file_count
+            try {
+                if (!_path.is_string() || logical_path.empty()) {
+                    THROW(SYS_INVALID_INPUT_PARAM, "Batch entry must be a logical path.");
+                }
 
-        void set_ticket_write_byte_count(connection_proxy& _conn,
-                                         const std::string_view _ticket_id,
-                                         const Pistache::Optional<std::string>& _byte_count)
-        {
-            trace("Setting write-byte count on ticket [{}] ...", _ticket_id);
+                auto conn = get_any_connection(_auth_header, batch_connection_hint, batch_parallelism_);
 
-            const auto count = _byte_count.getOrElse("0");
-            debug("write_byte_count = [{}]", count);
-            rx_ticket(*_conn(), "mod", _ticket_id, "write-bytes", count);
-        } // set_ticket_write_byte_count
+                if (const auto s = fs::client::status(*conn(), logical_path); fs::client::is_data_object(s)) {
+                    return {{logical_path, fs::client::data_object_size(*conn(), logical_path), {{"logical_path", logical_path}}}};
+                }
+                else if (!fs::client::is_collection(s)) {
+                    THROW(OBJ_PATH_DOES_NOT_EXIST, fmt::format("Logical path [{}] does not exist.", logical_path));
+                }
 
-        void set_ticket_expiration_timestamp(connection_proxy& _conn,
-                                             const std::string_view& _ticket_id,
-                                             const Pistache::Optional<std::string>& _seconds_until_expiration) const
-        {
-            if (_seconds_until_expiration.isEmpty()) {
-                return;
-            }
+                if (!_recursive) {
+                    THROW(USER_INCOMPATIBLE_PARAMS, "'recursive=1' required to issue tickets for the data objects of a collection.");
+                }
 
-            const auto secs_until_exp_string = _seconds_until_expiration.getOrElse("0");
-            debug("seconds until expiration = [{}]", secs_until_exp_string);
+                std::vector<batch_entry> entries;
 
-            if ("0" == secs_until_exp_string) {
-                return;
-            }
+                for (const auto& e : fs::client::recursive_collection_iterator(*conn(), logical_path)) {
+                    if (!e.is_data_object()) {
+                        continue;
+                    }
 
-            trace("Setting expiration on ticket [{}] ...", _ticket_id);
+                    if (entries.size() == max_batch_size_) {
+                        THROW(SYS_INVALID_INPUT_PARAM, fmt::format("Too many tickets in batch: limit is {}.", max_batch_size_));
+                    }
 
-            const auto secs = std::stoll(secs_until_exp_string);
+                    auto path = e.path().string();
+                    entries.push_back({path, e.data_size(), {{"logical_path", path}}});
+                }
 
-            if (secs < 0) {
-                constexpr std::string_view msg_fmt = "seconds_until_expiration [{}] must be greater than or equal to zero.";
-                THROW(SYS_INVALID_INPUT_PARAM, fmt::format(msg_fmt, secs));
+                return entries;
             }
+            catch (const fs::filesystem_error& e) {
+                return {{logical_path, 0, {{"logical_path", logical_path}, {"error_code", e.code().value()}, {"error_message", e.what()}}}};
+            }
+            catch (const irods::exception& e) {
+                return {{logical_path, 0, {{"logical_path", logical_path}, {"error_code", e.code()}, {"error_message", e.client_display_what()}}}};
+            }
+        } // resolve_batch_path
 
-            using std::chrono::seconds;
-            using std::chrono::system_clock;
+        // Removes a ticket which could not be fully configured. Failures are ignored because the
+        // original error is the one reported to the client.
+        void delete_ticket(connection_proxy& _conn, const std::string_view _ticket_id) noexcept
+        {
+            try {
+                rx_ticket(*_conn(), "delete", _ticket_id);
+            }
+            catch (...) {}
+        } // delete_ticket
 
-            const auto expiration_timestamp = system_clock::now() + seconds{secs};
-            const auto seconds_since_epoch = system_clock::to_time_t(expiration_timestamp);
+        // Returns the modifications needed to apply the query parameters to a new ticket.
+        // Values matching the defaults of the catalog are skipped.
+        std::vector<ticket_modification> make_ticket_modifications(const Pistache::Http::Uri::Query& _query) const
+        {
+            std::vector<ticket_modification> modifications;
 
-            rx_ticket(*_conn(), "mod", _ticket_id, "expire", std::to_string(seconds_since_epoch));
-        } // set_ticket_expiration_timestamp
+            const auto add_count = [&](const std::string& _parameter, const std::string& _property, std::int64_t _default) {
+                // Omitted counts mean "unlimited", which the catalog stores as zero.
+                const auto count = parse_count(_parameter, _query.get(_parameter).getOrElse("0"));
+                debug("{} = [{}]", _parameter, count);
 
-        void set_ticket_allowed_users(connection_proxy& _conn,
-                                      const std::string_view& _ticket_id,
-                                      const Pistache::Optional<std::string>& _users) const
-        {
-            if (_users.isEmpty()) {
-                return;
-            }
+                if (count != _default) {
+                    modifications.push_back({_property, std::to_string(count), ""});
+                }
+            };
 
-            trace("Adding allowed users to ticket [{}] ...", _ticket_id);
+            add_count("use-count", "uses", default_use_count);
+            add_count("write-file-count", "write-file", default_write_file_count);
+            add_count("write-byte-count", "write-bytes", default_write_byte_count);
 
-            std::vector<std::string> list;
-            boost::algorithm::split(list, _users.get(), boost::is_any_of(","));
+            if (const auto secs = parse_count("seconds-until-expiration", _query.get("seconds-until-expiration").getOrElse("0")); secs > 0) {
+                using std::chrono::seconds;
+                using std::chrono::system_clock;
 
-            for (auto&& user : list) {
-                debug("allowed user = [{}]", user);
-                rx_ticket(*_conn(), "mod", _ticket_id, "add", "user", user.data());
-            }
-        } // set_ticket_allowed_users
+                const auto expiration_timestamp = system_clock::now() + seconds{secs};
+                const auto seconds_since_epoch = system_clock::to_time_t(expiration_timestamp);
 
-        void set_ticket_allowed_groups(connection_proxy& _conn,
-                                       const std::string_view& _ticket_id,
-                                       const Pistache::Optional<std::string>& _groups) const
-        {
-            if (_groups.isEmpty()) {
-                return;
+                modifications.push_back({"expire", std::to_string(seconds_since_epoch), ""});
             }
 
-            trace("Adding allowed groups to ticket [{}] ...", _ticket_id);
+            for (const auto* type : {"user", "group", "host"}) {
+                const auto parameter = fmt::format("{}s", type);
 
-            std::vector<std::string> list;
-            boost::algorithm::split(list, _groups.get(), boost::is_any_of(","));
-
-            for (auto&& group : list) {
-                debug("allowed group = [{}]", group);
-                rx_ticket(*_conn(), "mod", _ticket_id, "add", "group", group.data());
+                for (auto&& entry : split_unique(_query.get(parameter).getOrElse(""))) {
+                    debug("allowed {} = [{}]", type, entry);
+                    modifications.push_back({"add", type, std::move(entry)});
+                }
             }
-        } // set_ticket_allowed_groups
 
-        void set_ticket_allowed_hosts(connection_proxy& _conn,
-                                      const std::string_view& _ticket_id,
-                                      const Pistache::Optional<std::string>& _hosts) const
+            return modifications;
+        } // make_ticket_modifications
+
+        // Parses a non-negative integer query parameter.
+        static std::int64_t parse_count(const std::string& _parameter, const std::string& _value)
         {
-            if (_hosts.isEmpty()) {
-                return;
+            try {
+                if (const auto count = std::stoll(_value); count >= 0) {
+                    return count;
+                }
+            }
+            catch (const std::exception&) {
             }
 
-            trace("Adding allowed hosts to ticket [{}] ...", _ticket_id);
+            constexpr std::string_view msg_fmt = "{} [{}] must be an integer greater than or equal to zero.";
+            THROW(SYS_INVALID_INPUT_PARAM, fmt::format(msg_fmt, _parameter, _value));
+        } // parse_count
 
+        // Splits a comma-separated list, dropping empty and repeated entries.
+        static std::vector<std::string> split_unique(const std::string& _list)
+        {
             std::vector<std::string> list;
-            boost::algorithm::split(list, _hosts.get(), boost::is_any_of(","));
+            boost::algorithm::split(list, _list, boost::is_any_of(","));
+
+            std::vector<std::string> entries;
 
-            for (auto&& host : list) {
-                debug("allowed host = [{}]", host);
-                rx_ticket(*_conn(), "mod", _ticket_id, "add", "host", host.data());
+            for (auto&& entry : list) {
+                if (!entry.empty() && std::find(entries.begin(), entries.end(), entry) == entries.end()) {
+                    entries.push_back(std::move(entry));
+                }
             }
-        } // set_ticket_allowed_hosts
+
+            return entries;
+        } // split_unique
 
         void rx_ticket(RcComm& _conn,
                        const std::string_view _operation,
@@ -300,10 +432,13 @@ namespace irods::rest
             ticket_inp.arg4 = const_cast<char*>(_arg1.data());
             ticket_inp.arg5 = const_cast<char*>(_arg2.data());
 
-            if (const auto ec = rcTicketAdmin(&_conn, &ticket_inp); ec < 0) {
+            if (const auto ec = metrics::invoke("rcTicketAdmin", rcTicketAdmin, &_conn, &ticket_inp); ec < 0) {
                 THROW(ec, fmt::format("Received error from rcTicketAdmin for ticket [{}]", _ticket_id));
             }
         } // rx_ticket
+
+        std::size_t max_batch_size_;
+        std::size_t batch_parallelism_;
     }; // class ticket
 } // namespace irods::rest
 
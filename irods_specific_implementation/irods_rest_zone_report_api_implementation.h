@@ -34,7 +34,7 @@ namespace irods::rest
 
                 trace("Invoking rcZoneReport() ...");
 
-                if (const auto ec = rcZoneReport(conn(), &bbuf); ec < 0) {
+                if (const auto ec = metrics::invoke("rcZoneReport", rcZoneReport, conn(), &bbuf); ec < 0) {
                     error("Received error [{}] from rcZoneReport.", ec);
                     return make_error_response(ec, rodsErrorName(ec, nullptr));
                 }
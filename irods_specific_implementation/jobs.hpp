@@ -0,0 +1,684 @@
+#ifndef IRODS_REST_CPP_JOBS_HPP
+#define IRODS_REST_CPP_JOBS_HPP
+
+#include <irods/irods_exception.hpp>
+#include <irods/rodsErrorTable.h>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Long-running operations executed in the background and polled by clients.
+namespace irods::rest::jobs
+{
+    enum class job_state
+    {
+        queued,
+        running,
+        succeeded,
+        failed,
+        cancelled,
+
+        // The service stopped before the job finished.
+        interrupted
+    }; // enum class job_state
+
+    inline auto to_string(job_state _state) -> std::string_view
+    {
+        switch (_state) {
+            case job_state::queued:      return "queued";
+            case job_state::running:     return "running";
+            case job_state::succeeded:   return "succeeded";
+            case job_state::failed:      return "failed";
+            case job_state::cancelled:   return "cancelled";
+            case job_state::interrupted: return "interrupted";
+        }
+
+        return "unknown";
+    } // to_string
+
+    inline auto to_job_state(std::string_view _state) -> job_state
+    {
+        for (auto s : {job_state::queued, job_state::running, job_state::succeeded, job_state::failed, job_state::cancelled}) {
+            if (to_string(s) == _state) {
+                return s;
+            }
+        }
+
+        return job_state::interrupted;
+    } // to_job_state
+
+    inline auto is_finished(job_state _state) noexcept -> bool
+    {
+        return job_state::queued != _state && job_state::running != _state;
+    } // is_finished
+
+    // Counts the data objects processed by an operation and remembers the ones that failed. The
+    // operation stops early once cancellation is requested.
+    class progress
+    {
+    public:
+        struct failure
+        {
+            std::string logical_path;
+            int error_code;
+        };
+
+        progress() = default;
+
+        progress(const progress&) = delete;
+        auto operator=(const progress&) -> progress& = delete;
+
+        auto add_success(std::uint64_t _bytes) noexcept -> void
+        {
+            data_objects_.fetch_add(1, std::memory_order_relaxed);
+            bytes_.fetch_add(_bytes, std::memory_order_relaxed);
+        }
+
+        auto add_failure(std::string _logical_path, int _error_code) -> void
+        {
+            data_objects_.fetch_add(1, std::memory_order_relaxed);
+
+            std::scoped_lock lk{mtx_};
+            failures_.push_back({std::move(_logical_path), _error_code});
+        }
+
+        auto data_objects() const noexcept -> std::uint64_t
+        {
+            return data_objects_.load(std::memory_order_relaxed);
+        }
+
+        auto bytes() const noexcept -> std::uint64_t
+        {
+            return bytes_.load(std::memory_order_relaxed);
+        }
+
+        auto failures() const -> std::vector<failure>
+        {
+            std::scoped_lock lk{mtx_};
+            return failures_;
+        }
+
+        auto request_cancellation() noexcept -> void
+        {
+            cancelled_.store(true, std::memory_order_relaxed);
+        }
+
+        auto cancellation_requested() const noexcept -> bool
+        {
+            return cancelled_.load(std::memory_order_relaxed);
+        }
+
+        auto restore(std::uint64_t _data_objects, std::uint64_t _bytes, std::vector<failure> _failures) -> void
+        {
+            data_objects_.store(_data_objects, std::memory_order_relaxed);
+            bytes_.store(_bytes, std::memory_order_relaxed);
+
+            std::scoped_lock lk{mtx_};
+            failures_ = std::move(_failures);
+        }
+
+    private:
+        std::atomic<std::uint64_t> data_objects_{0};
+        std::atomic<std::uint64_t> bytes_{0};
+        std::atomic<bool> cancelled_{false};
+        mutable std::mutex mtx_;
+        std::vector<failure> failures_;
+    }; // class progress
+
+    class job
+    {
+    public:
+        job(std::string _id, std::string _user_name, std::string _operation, std::string _logical_path)
+            : id_{std::move(_id)}
+            , user_name_{std::move(_user_name)}
+            , operation_{std::move(_operation)}
+            , logical_path_{std::move(_logical_path)}
+            , submitted_at_{now()}
+        {
+        }
+
+        job(const job&) = delete;
+        auto operator=(const job&) -> job& = delete;
+
+        auto id() const noexcept -> const std::string& { return id_; }
+        auto user_name() const noexcept -> const std::string& { return user_name_; }
+        auto get_progress() noexcept -> progress& { return progress_; }
+
+        auto state() const -> job_state
+        {
+            std::scoped_lock lk{mtx_};
+            return state_;
+        }
+
+        auto finished_at() const -> std::int64_t
+        {
+            std::scoped_lock lk{mtx_};
+            return finished_at_;
+        }
+
+        // Returns false if the job was cancelled while queued.
+        auto start() -> bool
+        {
+            std::scoped_lock lk{mtx_};
+
+            if (job_state::queued != state_) {
+                return false;
+            }
+
+            state_ = job_state::running;
+            started_at_ = now();
+
+            return true;
+        }
+
+        // Records the outcome of a job that ran to completion or was stopped. _error_code is
+        // non-zero if the operation as a whole failed.
+        auto finish(int _error_code = 0, std::string _error_message = {}) -> void
+        {
+            std::scoped_lock lk{mtx_};
+
+            if (0 != _error_code) {
+                state_ = job_state::failed;
+            }
+            else if (progress_.cancellation_requested()) {
+                state_ = job_state::cancelled;
+            }
+            else {
+                state_ = progress_.failures().empty() ? job_state::succeeded : job_state::failed;
+            }
+
+            error_code_ = _error_code;
+            error_message_ = std::move(_error_message);
+            finished_at_ = now();
+        }
+
+        // Returns true if the job had not finished. A queued job is cancelled right away. A
+        // running job stops after the data objects being processed.
+        auto cancel() -> bool
+        {
+            std::scoped_lock lk{mtx_};
+
+            if (is_finished(state_)) {
+                return false;
+            }
+
+            progress_.request_cancellation();
+
+            if (job_state::queued == state_) {
+                state_ = job_state::cancelled;
+                finished_at_ = now();
+            }
+
+            return true;
+        }
+
+        auto interrupt() -> void
+        {
+            std::scoped_lock lk{mtx_};
+            state_ = job_state::interrupted;
+            finished_at_ = now();
+        }
+
+        auto to_json() const -> nlohmann::json
+        {
+            auto failures = nlohmann::json::array();
+
+            for (auto&& f : progress_.failures()) {
+                failures.push_back({{"logical_path", f.logical_path}, {"error_code", f.error_code}});
+            }
+
+            std::scoped_lock lk{mtx_};
+
+            nlohmann::json j{{"job_id", id_},
+                             {"user", user_name_},
+                             {"operation", operation_},
+                             {"logical_path", logical_path_},
+                             {"state", to_string(state_)},
+                             {"submitted_at", submitted_at_},
+                             {"started_at", started_at_},
+                             {"finished_at", finished_at_},
+                             {"cancellation_requested", progress_.cancellation_requested()},
+                             {"progress", {{"data_objects", progress_.data_objects()},
+                                           {"bytes", progress_.bytes()},
+                                           {"errors", failures.size()}}},
+                             {"failures", std::move(failures)}};
+
+            if (0 != error_code_) {
+                j["error_code"] = error_code_;
+                j["error_message"] = error_message_;
+            }
+
+            return j;
+        }
+
+        static auto from_json(const nlohmann::json& _j) -> std::shared_ptr<job>
+        {
+            auto j = std::make_shared<job>(_j.at("job_id").get<std::string>(),
+                                           _j.at("user").get<std::string>(),
+                                           _j.at("operation").get<std::string>(),
+                                           _j.at("logical_path").get<std::string>());
+
+            std::vector<progress::failure> failures;
+
+            for (auto&& f : _j.at("failures")) {
+                failures.push_back({f.at("logical_path").get<std::string>(), f.at("error_code").get<int>()});
+            }
+
+            const auto& p = _j.at("progress");
+            j->progress_.restore(p.at("data_objects").get<std::uint64_t>(), p.at("bytes").get<std::uint64_t>(), std::move(failures));
+
+            j->state_ = to_job_state(_j.at("state").get<std::string>());
+            j->submitted_at_ = _j.at("submitted_at").get<std::int64_t>();
+            j->started_at_ = _j.at("started_at").get<std::int64_t>();
+            j->finished_at_ = _j.at("finished_at").get<std::int64_t>();
+            j->error_code_ = _j.value("error_code", 0);
+            j->error_message_ = _j.value("error_message", "");
+
+            return j;
+        }
+
+    private:
+        static auto now() -> std::int64_t
+        {
+            using namespace std::chrono;
+            return duration_cast<seconds>(system_clock::now().time_since_epoch()).count();
+        }
+
+        const std::string id_;
+        const std::string user_name_;
+        const std::string operation_;
+        const std::string logical_path_;
+        progress progress_;
+
+        mutable std::mutex mtx_;
+        job_state state_ = job_state::queued;
+        std::int64_t submitted_at_;
+        std::int64_t started_at_ = 0;
+        std::int64_t finished_at_ = 0;
+        int error_code_ = 0;
+        std::string error_message_;
+    }; // class job
+
+    struct settings
+    {
+        // Every change of a job's state is appended to this file. Jobs are only kept in memory
+        // if it is empty. The file and its directory are only accessible by the service's user.
+        std::string journal_file;
+        std::size_t maximum_number_of_running_jobs = 2;
+        std::size_t maximum_number_of_queued_jobs = 64;
+        std::chrono::seconds time_to_live{86400};
+    }; // struct settings
+
+    // Runs jobs on a fixed number of threads. Each change of a job's state is appended to a
+    // journal, which is replayed on start-up so that results survive a restart. Jobs which had
+    // not finished when the service stopped are reported as interrupted. The journal is rewritten
+    // with the latest record of each retained job on start-up and whenever enough records have
+    // been appended since.
+    class job_manager
+    {
+    public:
+        using operation_type = std::function<void(job&)>;
+
+        job_manager() = default;
+
+        job_manager(const job_manager&) = delete;
+        auto operator=(const job_manager&) -> job_manager& = delete;
+
+        ~job_manager()
+        {
+            {
+                std::scoped_lock lk{mtx_};
+                exit_flag_ = true;
+
+                for (auto& [id, j] : jobs_) {
+                    j->cancel();
+                }
+            }
+
+            cv_.notify_all();
+
+            for (auto& t : workers_) {
+                t.join();
+            }
+
+            if (journal_fd_ >= 0) {
+                ::close(journal_fd_);
+            }
+        }
+
+        // Replays and compacts the journal, then starts the worker threads.
+        auto start(settings _settings) -> void
+        {
+            settings_ = std::move(_settings);
+
+            if (!settings_.journal_file.empty()) {
+                std::scoped_lock lk{mtx_};
+
+                create_journal_directory();
+                replay_journal();
+                open_journal();
+
+                if (journal_fd_ >= 0) {
+                    compact_journal();
+                }
+            }
+
+            for (std::size_t i = 0; i < std::max<std::size_t>(settings_.maximum_number_of_running_jobs, 1); ++i) {
+                workers_.emplace_back(&job_manager::run_jobs, this);
+            }
+        }
+
+        // Queues _operation and returns its job, or nullptr if too many jobs are queued.
+        auto submit(std::string _user_name, std::string _operation_name, std::string _logical_path, operation_type _operation)
+            -> std::shared_ptr<job>
+        {
+            auto j = std::make_shared<job>(make_job_id(), std::move(_user_name), std::move(_operation_name), std::move(_logical_path));
+
+            {
+                std::scoped_lock lk{mtx_};
+
+                if (queue_.size() >= settings_.maximum_number_of_queued_jobs) {
+                    return nullptr;
+                }
+
+                remove_expired_jobs();
+
+                jobs_.emplace(j->id(), j);
+                queue_.emplace_back(j, std::move(_operation));
+                append_to_journal(*j);
+            }
+
+            cv_.notify_one();
+
+            return j;
+        }
+
+        // Returns the job identified by _id if it belongs to _user_name.
+        auto find(const std::string& _id, const std::string& _user_name) const -> std::shared_ptr<job>
+        {
+            std::scoped_lock lk{mtx_};
+
+            if (const auto iter = jobs_.find(_id); iter != jobs_.end() && iter->second->user_name() == _user_name) {
+                return iter->second;
+            }
+
+            return nullptr;
+        }
+
+        auto cancel(job& _job) -> void
+        {
+            if (_job.cancel() && is_finished(_job.state())) {
+                std::scoped_lock lk{mtx_};
+                append_to_journal(_job);
+            }
+        }
+
+    private:
+        static auto make_job_id() -> std::string
+        {
+            thread_local std::mt19937_64 engine{std::random_device{}()};
+            return fmt::format("{:016x}{:016x}", engine(), engine());
+        }
+
+        static auto log_error(std::string_view _msg, const std::string& _file) -> void
+        {
+            spdlog::error(nlohmann::json{{"message", _msg}, {"file", _file}}.dump());
+        }
+
+        auto run_jobs() -> void
+        {
+            while (true) {
+                std::pair<std::shared_ptr<job>, operation_type> next;
+
+                {
+                    std::unique_lock lk{mtx_};
+                    cv_.wait(lk, [this] { return exit_flag_ || !queue_.empty(); });
+
+                    if (exit_flag_) {
+                        return;
+                    }
+
+                    next = std::move(queue_.front());
+                    queue_.pop_front();
+
+                    if (!next.first->start()) {
+                        continue;
+                    }
+
+                    append_to_journal(*next.first);
+                }
+
+                auto& [j, operation] = next;
+
+                try {
+                    operation(*j);
+                    j->finish();
+                }
+                catch (const irods::exception& e) {
+                    j->finish(e.code(), e.client_display_what());
+                }
+                catch (const std::system_error& e) {
+                    j->finish(e.code().value(), e.what());
+                }
+                catch (const std::exception& e) {
+                    j->finish(SYS_INTERNAL_ERR, e.what());
+                }
+
+                std::scoped_lock lk{mtx_};
+
+                // Jobs stopped by a shutdown are replayed as interrupted.
+                if (!exit_flag_) {
+                    append_to_journal(*j);
+                }
+            }
+        }
+
+        // Requires mtx_ to be held.
+        auto append_to_journal(const job& _job) -> void
+        {
+            if (journal_fd_ < 0) {
+                return;
+            }
+
+            auto record = _job.to_json().dump();
+            record += '\n';
+
+            if (!write_all(journal_fd_, record)) {
+                log_error("Could not write to job journal.", settings_.journal_file);
+                return;
+            }
+
+            // Every change of state appends a record, so the journal grows much faster than the
+            // number of jobs it describes.
+            if (++records_since_compaction_ >= std::max(minimum_records_between_compactions, 2 * jobs_.size())) {
+                remove_expired_jobs();
+                compact_journal();
+            }
+        }
+
+        // Requires mtx_ to be held.
+        auto remove_expired_jobs() -> void
+        {
+            const auto expired_before = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch() - settings_.time_to_live).count();
+
+            for (auto iter = jobs_.begin(); iter != jobs_.end();) {
+                const auto state = iter->second->state();
+
+                if (is_finished(state) && iter->second->finished_at() < expired_before) {
+                    iter = jobs_.erase(iter);
+                }
+                else {
+                    ++iter;
+                }
+            }
+        }
+
+        // The directory is created with permissions for the service's user only. An existing
+        // directory is left as the administrator configured it.
+        auto create_journal_directory() -> void
+        {
+            const auto dir = std::filesystem::path{settings_.journal_file}.parent_path();
+
+            if (dir.empty()) {
+                return;
+            }
+
+            std::error_code ec;
+            std::filesystem::create_directories(dir.parent_path(), ec);
+
+            if (0 != ::mkdir(dir.c_str(), S_IRWXU) && EEXIST != errno) {
+                log_error("Could not create job journal directory.", dir.string());
+            }
+        }
+
+        // Requires mtx_ to be held.
+        auto replay_journal() -> void
+        {
+            std::ifstream in{settings_.journal_file};
+            std::string line;
+
+            // Later records of a job replace earlier ones.
+            while (std::getline(in, line)) {
+                try {
+                    auto j = job::from_json(nlohmann::json::parse(line));
+                    jobs_.insert_or_assign(j->id(), std::move(j));
+                }
+                catch (const std::exception&) {
+                    // A partial record is left behind if the service stopped while appending it.
+                }
+            }
+
+            for (auto& [id, j] : jobs_) {
+                if (!is_finished(j->state())) {
+                    j->interrupt();
+                }
+            }
+
+            remove_expired_jobs();
+        }
+
+        // Requires mtx_ to be held. Opens the journal for appending, replacing the descriptor in
+        // use. Symbolic links are not followed.
+        auto open_journal() -> void
+        {
+            const auto fd = ::open(settings_.journal_file.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC | O_NOFOLLOW, S_IRUSR | S_IWUSR);
+
+            if (fd < 0) {
+                log_error("Could not open job journal. Jobs will only be kept in memory.", settings_.journal_file);
+            }
+            else {
+                // Journals written by earlier versions may be readable by other users.
+                ::fchmod(fd, S_IRUSR | S_IWUSR);
+            }
+
+            if (journal_fd_ >= 0) {
+                ::close(journal_fd_);
+            }
+
+            journal_fd_ = fd;
+        }
+
+        // Requires mtx_ to be held. Rewrites the journal with the latest record of each retained
+        // job. The records are written to a new file with a unique name, which then replaces the
+        // journal. If that fails, records keep being appended to the existing journal.
+        auto compact_journal() -> void
+        {
+            records_since_compaction_ = 0;
+
+            // mkstemp creates the file exclusively and readable by the service's user only.
+            std::string tmp = settings_.journal_file + ".XXXXXX";
+            const auto fd = ::mkstemp(tmp.data());
+
+            if (fd < 0) {
+                log_error("Could not compact job journal.", settings_.journal_file);
+                return;
+            }
+
+            bool written = true;
+
+            for (auto& [id, j] : jobs_) {
+                auto record = j->to_json().dump();
+                record += '\n';
+
+                if (!write_all(fd, record)) {
+                    written = false;
+                    break;
+                }
+            }
+
+            written = written && 0 == ::fsync(fd);
+            ::close(fd);
+
+            if (!written || 0 != std::rename(tmp.c_str(), settings_.journal_file.c_str())) {
+                log_error("Could not compact job journal.", tmp);
+                ::unlink(tmp.c_str());
+                return;
+            }
+
+            // The current descriptor refers to the file which was just replaced.
+            open_journal();
+        }
+
+        static auto write_all(int _fd, std::string_view _data) -> bool
+        {
+            while (!_data.empty()) {
+                const auto n = ::write(_fd, _data.data(), _data.size());
+
+                if (n < 0) {
+                    if (EINTR == errno) {
+                        continue;
+                    }
+
+                    return false;
+                }
+
+                _data.remove_prefix(static_cast<std::size_t>(n));
+            }
+
+            return true;
+        }
+
+        static constexpr std::size_t minimum_records_between_compactions = 1024;
+
+        settings settings_;
+        mutable std::mutex mtx_;
+        std::condition_variable cv_;
+        std::map<std::string, std::shared_ptr<job>> jobs_;
+        std::deque<std::pair<std::shared_ptr<job>, operation_type>> queue_;
+        int journal_fd_ = -1;
+        std::size_t records_since_compaction_ = 0;
+        std::vector<std::thread> workers_;
+        bool exit_flag_ = false;
+    }; // class job_manager
+} // namespace irods::rest::jobs
+
+#endif // IRODS_REST_CPP_JOBS_HPP
@@ -0,0 +1,412 @@
+#ifndef IRODS_REST_CPP_JSON_WRITER_HPP
+#define IRODS_REST_CPP_JSON_WRITER_HPP
+
+#include <nlohmann/json.hpp>
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace irods::rest
+{
+    /// \brief Writes JSON text directly into a string without building a document first.
+    ///
+    /// The caller is responsible for emitting well-formed structure (e.g. a key before every
+    /// value inside an object). Strings are escaped the same way nlohmann::json::dump() escapes
+    /// them, and invalid UTF-8 is rejected. Keys are written in the order given, so callers that
+    /// want output identical to nlohmann::json must emit keys in sorted order.
+    class json_writer
+    {
+    public:
+        static constexpr int max_depth = 64;
+
+        explicit json_writer(std::string& _out) noexcept
+            : out_{_out}
+            , has_elements_{}
+            , depth_{}
+            , after_key_{}
+        {
+        }
+
+        json_writer(const json_writer&) = delete;
+        auto operator=(const json_writer&) -> json_writer& = delete;
+
+        auto begin_object() -> json_writer&
+        {
+            return open('{');
+        }
+
+        auto end_object() -> json_writer&
+        {
+            return close('}');
+        }
+
+        auto begin_array() -> json_writer&
+        {
+            return open('[');
+        }
+
+        auto end_array() -> json_writer&
+        {
+            return close(']');
+        }
+
+        auto key(std::string_view _key) -> json_writer&
+        {
+            separate();
+            append_string(_key);
+            out_ += ':';
+            after_key_ = true;
+            return *this;
+        }
+
+        auto value(std::string_view _value) -> json_writer&
+        {
+            separate();
+            append_string(_value);
+            return *this;
+        }
+
+        auto value(const char* _value) -> json_writer&
+        {
+            return value(std::string_view{_value});
+        }
+
+        auto value(bool _value) -> json_writer&
+        {
+            separate();
+            out_ += _value ? "true" : "false";
+            return *this;
+        }
+
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+        auto value(T _value) -> json_writer&
+        {
+            separate();
+
+            char buffer[24];
+            const auto result = std::to_chars(buffer, buffer + sizeof(buffer), _value);
+            out_.append(buffer, result.ptr);
+
+            return *this;
+        }
+
+        auto null() -> json_writer&
+        {
+            separate();
+            out_ += "null";
+            return *this;
+        }
+
+        template <typename T>
+        auto member(std::string_view _key, T&& _value) -> json_writer&
+        {
+            return key(_key).value(std::forward<T>(_value));
+        }
+
+        // Writes a sequence of strings as an array.
+        template <typename Range>
+        auto string_array(const Range& _values) -> json_writer&
+        {
+            begin_array();
+
+            for (const auto& v : _values) {
+                value(std::string_view{v});
+            }
+
+            return end_array();
+        }
+
+        /// \brief Appends \p _s to \p _out as a quoted, escaped JSON string.
+        ///
+        /// \throws std::invalid_argument If \p _s is not valid UTF-8.
+        static auto append_string(std::string& _out, std::string_view _s) -> void
+        {
+            constexpr std::string_view hex = "0123456789abcdef";
+
+            _out += '"';
+
+            std::size_t run_start = 0;
+            std::size_t i = 0;
+
+            const auto flush = [&] {
+                _out.append(_s.data() + run_start, i - run_start);
+            };
+
+            while (i < _s.size()) {
+                const auto c = static_cast<unsigned char>(_s[i]);
+
+                if (c >= 0x80) {
+                    i += validate_utf8_sequence(_s, i);
+                    continue;
+                }
+
+                if (c >= 0x20 && '"' != c && '\\' != c) {
+                    ++i;
+                    continue;
+                }
+
+                flush();
+
+                switch (c) {
+                    case '"':  _out += "\\\""; break;
+                    case '\\': _out += "\\\\"; break;
+                    case '\b': _out += "\\b"; break;
+                    case '\f': _out += "\\f"; break;
+                    case '\n': _out += "\\n"; break;
+                    case '\r': _out += "\\r"; break;
+                    case '\t': _out += "\\t"; break;
+                    default:
+                        _out += "\\u00";
+                        _out += hex[c >> 4];
+                        _out += hex[c & 0x0f];
+                        break;
+                }
+
+                run_start = ++i;
+            }
+
+            flush();
+
+            _out += '"';
+        } // append_string
+
+        /// \throws std::invalid_argument If \p _s is not valid UTF-8.
+        static auto validate_utf8(std::string_view _s) -> void
+        {
+            for (std::size_t i = 0; i < _s.size();) {
+                i += (static_cast<unsigned char>(_s[i]) < 0x80) ? 1 : validate_utf8_sequence(_s, i);
+            }
+        } // validate_utf8
+
+    private:
+        auto open(char _c) -> json_writer&
+        {
+            if (depth_ + 1 >= max_depth) {
+                throw std::length_error{"json_writer: maximum nesting depth exceeded"};
+            }
+
+            separate();
+            out_ += _c;
+            has_elements_ &= ~(std::uint64_t{1} << ++depth_);
+
+            return *this;
+        }
+
+        auto close(char _c) -> json_writer&
+        {
+            out_ += _c;
+            --depth_;
+
+            return *this;
+        }
+
+        // Emits a comma unless this is the first element of the current container or the value
+        // of a key.
+        auto separate() -> void
+        {
+            if (after_key_) {
+                after_key_ = false;
+                return;
+            }
+
+            const auto bit = std::uint64_t{1} << depth_;
+
+            if (has_elements_ & bit) {
+                out_ += ',';
+            }
+
+            has_elements_ |= bit;
+        }
+
+        auto append_string(std::string_view _s) -> void
+        {
+            append_string(out_, _s);
+        }
+
+        // Returns the length of the UTF-8 sequence starting at _pos.
+        static auto validate_utf8_sequence(std::string_view _s, std::size_t _pos) -> std::size_t
+        {
+            const auto byte = [&_s](std::size_t _i) -> unsigned {
+                return _i < _s.size() ? static_cast<unsigned char>(_s[_i]) : 0;
+            };
+
+            const auto lead = byte(_pos);
+            unsigned lo = 0x80;
+            unsigned hi = 0xbf;
+            std::size_t length = 0;
+
+            if (lead >= 0xc2 && lead <= 0xdf) {
+                length = 2;
+            }
+            else if (lead >= 0xe0 && lead <= 0xef) {
+                length = 3;
+                if (0xe0 == lead) { lo = 0xa0; }
+                if (0xed == lead) { hi = 0x9f; }
+            }
+            else if (lead >= 0xf0 && lead <= 0xf4) {
+                length = 4;
+                if (0xf0 == lead) { lo = 0x90; }
+                if (0xf4 == lead) { hi = 0x8f; }
+            }
+
+            bool valid = length > 0;
+
+            for (std::size_t i = 1; valid && i < length; ++i) {
+                const auto b = byte(_pos + i);
+                valid = (1 == i) ? (b >= lo && b <= hi) : (b >= 0x80 && b <= 0xbf);
+            }
+
+            if (!valid) {
+                throw std::invalid_argument{"json_writer: string is not valid UTF-8"};
+            }
+
+            return length;
+        } // validate_utf8_sequence
+
+        std::string& out_;
+        std::uint64_t has_elements_; // One bit per nesting level.
+        int depth_;
+        bool after_key_;
+    }; // class json_writer
+
+    /// \brief Builds an nlohmann::json document through the same interface as json_writer.
+    ///
+    /// Lets a response be written once and then encoded as JSON text, CBOR or MessagePack
+    /// without producing and parsing JSON text in between.
+    class json_document_writer
+    {
+    public:
+        explicit json_document_writer(nlohmann::json& _doc) noexcept
+            : doc_{_doc}
+            , stack_{}
+            , key_{}
+        {
+        }
+
+        json_document_writer(const json_document_writer&) = delete;
+        auto operator=(const json_document_writer&) -> json_document_writer& = delete;
+
+        auto begin_object() -> json_document_writer&
+        {
+            return open(nlohmann::json::object());
+        }
+
+        auto end_object() -> json_document_writer&
+        {
+            stack_.pop_back();
+            return *this;
+        }
+
+        auto begin_array() -> json_document_writer&
+        {
+            return open(nlohmann::json::array());
+        }
+
+        auto end_array() -> json_document_writer&
+        {
+            stack_.pop_back();
+            return *this;
+        }
+
+        auto key(std::string_view _key) -> json_document_writer&
+        {
+            json_writer::validate_utf8(_key);
+            key_.assign(_key.data(), _key.size());
+            return *this;
+        }
+
+        auto value(std::string_view _value) -> json_document_writer&
+        {
+            json_writer::validate_utf8(_value);
+            emplace(std::string{_value});
+            return *this;
+        }
+
+        auto value(const char* _value) -> json_document_writer&
+        {
+            return value(std::string_view{_value});
+        }
+
+        auto value(bool _value) -> json_document_writer&
+        {
+            emplace(_value);
+            return *this;
+        }
+
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+        auto value(T _value) -> json_document_writer&
+        {
+            emplace(_value);
+            return *this;
+        }
+
+        auto null() -> json_document_writer&
+        {
+            emplace(nullptr);
+            return *this;
+        }
+
+        template <typename T>
+        auto member(std::string_view _key, T&& _value) -> json_document_writer&
+        {
+            return key(_key).value(std::forward<T>(_value));
+        }
+
+        // Writes a sequence of strings as an array.
+        template <typename Range>
+        auto string_array(const Range& _values) -> json_document_writer&
+        {
+            begin_array();
+
+            for (const auto& v : _values) {
+                value(std::string_view{v});
+            }
+
+            return end_array();
+        }
+
+    private:
+        auto open(nlohmann::json&& _container) -> json_document_writer&
+        {
+            if (stack_.size() + 1 >= json_writer::max_depth) {
+                throw std::length_error{"json_document_writer: maximum nesting depth exceeded"};
+            }
+
+            stack_.push_back(&emplace(std::move(_container)));
+
+            return *this;
+        }
+
+        // Only the containers on the stack are referenced, and elements are only ever added to
+        // the innermost one, so the pointers remain valid.
+        auto emplace(nlohmann::json&& _value) -> nlohmann::json&
+        {
+            if (stack_.empty()) {
+                doc_ = std::move(_value);
+                return doc_;
+            }
+
+            auto& parent = *stack_.back();
+
+            if (parent.is_array()) {
+                parent.push_back(std::move(_value));
+                return parent.back();
+            }
+
+            return parent[key_] = std::move(_value);
+        }
+
+        nlohmann::json& doc_;
+        std::vector<nlohmann::json*> stack_;
+        std::string key_;
+    }; // class json_document_writer
+} // namespace irods::rest
+
+#endif // IRODS_REST_CPP_JSON_WRITER_HPP
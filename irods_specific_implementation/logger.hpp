@@ -5,24 +5,141 @@
 
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/syslog_sink.h>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string_view>
+#include <thread>
 
 namespace irods::rest
 {
+    namespace detail
+    {
+        /// \brief Periodically reports log messages dropped because the queue of the
+        /// asynchronous logger was full.
+        ///
+        /// Nothing is reported while no messages are dropped.
+        class log_overflow_monitor
+        {
+        public:
+            log_overflow_monitor() = default;
+
+            log_overflow_monitor(const log_overflow_monitor&) = delete;
+            auto operator=(const log_overflow_monitor&) -> log_overflow_monitor& = delete;
+
+            ~log_overflow_monitor()
+            {
+                {
+                    std::lock_guard lk{mtx_};
+                    exit_flag_ = true;
+                }
+
+                cv_.notify_one();
+
+                if (worker_.joinable()) {
+                    worker_.join();
+                }
+            }
+
+            auto start(std::shared_ptr<spdlog::logger> _logger,
+                       std::shared_ptr<spdlog::details::thread_pool> _thread_pool,
+                       std::chrono::seconds _interval) -> void
+            {
+                logger_ = std::move(_logger);
+                thread_pool_ = std::move(_thread_pool);
+                interval_ = std::max(_interval, std::chrono::seconds{1});
+                worker_ = std::thread{&log_overflow_monitor::run, this};
+            }
+
+        private:
+            auto run() -> void
+            {
+                std::size_t reported = 0;
+
+                while (true) {
+                    {
+                        std::unique_lock lk{mtx_};
+
+                        if (cv_.wait_for(lk, interval_, [this] { return exit_flag_; })) {
+                            return;
+                        }
+                    }
+
+                    const auto dropped = thread_pool_->overrun_counter();
+
+                    if (dropped > reported) {
+                        logger_->warn(json{{"message", "Log queue overflowed. Oldest messages were dropped."},
+                                           {"dropped_since_last_report", dropped - reported},
+                                           {"dropped_total", dropped}}.dump());
+                        reported = dropped;
+                    }
+                }
+            }
+
+            std::mutex mtx_;
+            std::condition_variable cv_;
+            bool exit_flag_{};
+            std::thread worker_;
+            std::chrono::seconds interval_{60};
+            std::shared_ptr<spdlog::logger> logger_;
+            std::shared_ptr<spdlog::details::thread_pool> thread_pool_;
+        }; // class log_overflow_monitor
+
+        // Destroyed before the spdlog registry, which is created first.
+        inline auto overflow_monitor() -> log_overflow_monitor&
+        {
+            static log_overflow_monitor monitor;
+            return monitor;
+        } // overflow_monitor
+    } // namespace detail
+
     /// \brief Initialize logging for the REST service specified by \p _service_name.
     ///
     /// The logging module is initialized based on the level set in the JSON configuration
     /// for the specified \p _service_name. If none is specified, the log level is set to "info".
     ///
+    /// Messages are handed to a bounded queue and written to syslog by a background thread so
+    /// that request threads never wait on syslog. When the queue is full, the oldest message is
+    /// dropped. Setting "log_queue_size" to 0 restores synchronous logging.
+    ///
     /// \param[in] _service_name Key for JSON configuration for the target REST service
     auto init_logger(const std::string_view _service_name) -> std::shared_ptr<spdlog::logger>
     {
         constexpr auto enable_formatting = true;
 
-        auto logger = spdlog::syslog_logger_mt(_service_name.data(), "", LOG_PID, LOG_LOCAL0, enable_formatting);
+        std::size_t queue_size = 8192;
+        std::chrono::seconds report_interval{60};
+
+        try {
+            const auto& cfg = configuration::rest_service(_service_name);
+            queue_size = cfg.value(configuration_keywords::log_queue_size, queue_size);
+            report_interval = std::chrono::seconds{cfg.value(configuration_keywords::log_overflow_report_interval, 60)};
+        }
+        catch (...) {
+        }
+
+        std::shared_ptr<spdlog::logger> logger;
+
+        if (queue_size > 0) {
+            constexpr std::size_t writer_threads = 1;
+            spdlog::init_thread_pool(queue_size, writer_threads);
+
+            auto sink = std::make_shared<spdlog::sinks::syslog_sink_mt>("", LOG_PID, LOG_LOCAL0, enable_formatting);
+            logger = std::make_shared<spdlog::async_logger>(std::string{_service_name},
+                                                            std::move(sink),
+                                                            spdlog::thread_pool(),
+                                                            spdlog::async_overflow_policy::overrun_oldest);
+            spdlog::register_logger(logger);
+        }
+        else {
+            logger = spdlog::syslog_logger_mt(_service_name.data(), "", LOG_PID, LOG_LOCAL0, enable_formatting);
+        }
 
         try {
             // The log message format does not include whitespace because that is how
@@ -63,9 +180,12 @@ namespace irods::rest
         // This is required so that the API interfaces have a logger.
         spdlog::set_default_logger(logger);
 
+        if (queue_size > 0) {
+            detail::overflow_monitor().start(logger, spdlog::thread_pool(), report_interval);
+        }
+
         return logger;
     } // init_logger
 } // namespace irods::rest
 
 #endif // IRODS_REST_CPP_LOGGER_HPP
-
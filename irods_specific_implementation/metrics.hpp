@@ -0,0 +1,711 @@
+#ifndef IRODS_REST_CPP_METRICS_HPP
+#define IRODS_REST_CPP_METRICS_HPP
+
+#include "tracing.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Counters, gauges and latency histograms exposed in the Prometheus text format.
+namespace irods::rest::metrics
+{
+    namespace detail
+    {
+        inline constexpr std::size_t shard_count = 16;
+
+        // Threads are assigned shards round-robin, so concurrent updates rarely touch the same
+        // cache line and never take a lock.
+        inline auto shard_index() noexcept -> std::size_t
+        {
+            static std::atomic<std::size_t> next{0};
+            thread_local const std::size_t index = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+            return index;
+        } // shard_index
+
+        template <typename T>
+        struct alignas(64) padded_atomic
+        {
+            std::atomic<T> value{0};
+        }; // struct padded_atomic
+
+        inline auto append_escaped_label_value(std::string& _out, std::string_view _value) -> void
+        {
+            for (const auto c : _value) {
+                switch (c) {
+                    case '\\': _out += "\\\\"; break;
+                    case '"':  _out += "\\\""; break;
+                    case '\n': _out += "\\n"; break;
+                    default:   _out += c; break;
+                }
+            }
+        } // append_escaped_label_value
+
+        // The function behind a callback series. Scrapes invoke it without holding the registry
+        // lock, because callbacks take locks of their own (e.g. the connection pool's) and the
+        // holders of those locks may register metrics.
+        class callback_state
+        {
+        public:
+            explicit callback_state(std::function<double()> _fn)
+                : fn_{std::move(_fn)}
+            {
+            }
+
+            // Returns nothing once the callback has been removed.
+            auto sample() -> std::optional<double>
+            {
+                std::scoped_lock lk{mtx_};
+
+                if (!fn_) {
+                    return std::nullopt;
+                }
+
+                return fn_();
+            }
+
+            // Waits for a sample in progress, so that the state the function reads may be
+            // destroyed as soon as this returns.
+            auto deactivate() -> void
+            {
+                std::scoped_lock lk{mtx_};
+                fn_ = nullptr;
+            }
+
+        private:
+            std::mutex mtx_;
+            std::function<double()> fn_;
+        }; // class callback_state
+    } // namespace detail
+
+    using label_list = std::initializer_list<std::pair<std::string_view, std::string_view>>;
+
+    class counter
+    {
+    public:
+        auto increment(std::uint64_t _n = 1) noexcept -> void
+        {
+            shards_[detail::shard_index()].value.fetch_add(_n, std::memory_order_relaxed);
+        }
+
+        auto value() const noexcept -> std::uint64_t
+        {
+            std::uint64_t sum = 0;
+
+            for (const auto& s : shards_) {
+                sum += s.value.load(std::memory_order_relaxed);
+            }
+
+            return sum;
+        }
+
+    private:
+        std::array<detail::padded_atomic<std::uint64_t>, detail::shard_count> shards_{};
+    }; // class counter
+
+    // A gauge which is adjusted by the threads that change what it measures (e.g. requests in
+    // flight). Gauges which are sampled from elsewhere are registered as callbacks instead.
+    class gauge
+    {
+    public:
+        // Adds one to the gauge for the lifetime of the object.
+        class scoped_increment
+        {
+        public:
+            explicit scoped_increment(gauge& _gauge) noexcept
+                : gauge_{&_gauge}
+            {
+                gauge_->add(1);
+            }
+
+            scoped_increment(const scoped_increment&) = delete;
+            auto operator=(const scoped_increment&) -> scoped_increment& = delete;
+
+            ~scoped_increment()
+            {
+                gauge_->add(-1);
+            }
+
+        private:
+            gauge* gauge_;
+        }; // class scoped_increment
+
+        auto add(std::int64_t _n) noexcept -> void
+        {
+            shards_[detail::shard_index()].value.fetch_add(_n, std::memory_order_relaxed);
+        }
+
+        auto value() const noexcept -> std::int64_t
+        {
+            std::int64_t sum = 0;
+
+            for (const auto& s : shards_) {
+                sum += s.value.load(std::memory_order_relaxed);
+            }
+
+            return sum;
+        }
+
+    private:
+        std::array<detail::padded_atomic<std::int64_t>, detail::shard_count> shards_{};
+    }; // class gauge
+
+    /// \brief A latency histogram with HDR-style log-linear buckets.
+    ///
+    /// Durations are recorded in microseconds. Every power of two between 2^6 us (64 us) and
+    /// 2^26 us (about 67 s) is split into four equally sized buckets, so a bucket's upper bound
+    /// is at most 25% larger than the values it holds. Longer durations are counted in the
+    /// +Inf bucket.
+    class histogram
+    {
+    public:
+        static constexpr int sub_bucket_bits = 2;
+        static constexpr int min_exponent = 6;
+        static constexpr int max_exponent = 26;
+        static constexpr std::size_t sub_bucket_count = std::size_t{1} << sub_bucket_bits;
+
+        // One bucket for [0, 2^min_exponent], the log-linear buckets and +Inf.
+        static constexpr std::size_t bucket_count = 1 + (max_exponent - min_exponent) * sub_bucket_count + 1;
+
+        struct snapshot
+        {
+            std::array<std::uint64_t, bucket_count> buckets; // Not cumulative.
+            std::uint64_t count;
+            std::uint64_t sum_in_microseconds;
+        }; // struct snapshot
+
+        static constexpr auto bucket_index(std::uint64_t _microseconds) noexcept -> std::size_t
+        {
+            if (_microseconds <= (std::uint64_t{1} << min_exponent)) {
+                return 0;
+            }
+
+            // Bounds are inclusive, so a value equal to a bound belongs to the bucket below it.
+            const auto v = _microseconds - 1;
+            const auto exponent = 63 - __builtin_clzll(v);
+
+            if (exponent >= max_exponent) {
+                return bucket_count - 1;
+            }
+
+            const auto sub_bucket = (v >> (exponent - sub_bucket_bits)) & (sub_bucket_count - 1);
+
+            return 1 + (exponent - min_exponent) * sub_bucket_count + sub_bucket;
+        } // bucket_index
+
+        // Returns the inclusive upper bound of the finite bucket _index in microseconds.
+        static constexpr auto upper_bound(std::size_t _index) noexcept -> std::uint64_t
+        {
+            if (0 == _index) {
+                return std::uint64_t{1} << min_exponent;
+            }
+
+            const auto exponent = min_exponent + static_cast<int>((_index - 1) / sub_bucket_count);
+            const auto sub_bucket = (_index - 1) % sub_bucket_count;
+
+            return (std::uint64_t{1} << exponent) + (sub_bucket + 1) * (std::uint64_t{1} << (exponent - sub_bucket_bits));
+        } // upper_bound
+
+        template <typename Rep, typename Period>
+        auto observe(std::chrono::duration<Rep, Period> _duration) noexcept -> void
+        {
+            const auto us = std::chrono::duration_cast<std::chrono::microseconds>(_duration).count();
+            const auto value = static_cast<std::uint64_t>(std::max<decltype(us)>(us, 0));
+
+            auto& shard = shards_[detail::shard_index()];
+            shard.buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+            shard.sum_in_microseconds.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        auto get_snapshot() const noexcept -> snapshot
+        {
+            snapshot s{};
+
+            for (const auto& shard : shards_) {
+                for (std::size_t i = 0; i < bucket_count; ++i) {
+                    const auto n = shard.buckets[i].load(std::memory_order_relaxed);
+                    s.buckets[i] += n;
+                    s.count += n;
+                }
+
+                s.sum_in_microseconds += shard.sum_in_microseconds.load(std::memory_order_relaxed);
+            }
+
+            return s;
+        }
+
+    private:
+        struct alignas(64) shard_type
+        {
+            std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
+            std::atomic<std::uint64_t> sum_in_microseconds{0};
+        }; // struct shard_type
+
+        std::array<shard_type, detail::shard_count> shards_{};
+    }; // class histogram
+
+    enum class metric_type
+    {
+        counter,
+        gauge,
+        histogram
+    }; // enum class metric_type
+
+    class registry;
+
+    // Removes a callback from the registry when destroyed. Owners of the state a callback reads
+    // must outlive the registration.
+    class callback_registration
+    {
+    public:
+        callback_registration() = default;
+
+        callback_registration(registry& _registry,
+                              std::string _name,
+                              std::string _labels,
+                              std::uint64_t _id,
+                              std::shared_ptr<detail::callback_state> _state)
+            : registry_{&_registry}
+            , name_{std::move(_name)}
+            , labels_{std::move(_labels)}
+            , id_{_id}
+            , state_{std::move(_state)}
+        {
+        }
+
+        callback_registration(callback_registration&& _other) noexcept
+            : registry_{std::exchange(_other.registry_, nullptr)}
+            , name_{std::move(_other.name_)}
+            , labels_{std::move(_other.labels_)}
+            , id_{_other.id_}
+            , state_{std::move(_other.state_)}
+        {
+        }
+
+        callback_registration(const callback_registration&) = delete;
+        auto operator=(const callback_registration&) -> callback_registration& = delete;
+        auto operator=(callback_registration&&) -> callback_registration& = delete;
+
+        inline ~callback_registration();
+
+    private:
+        registry* registry_{};
+        std::string name_;
+        std::string labels_;
+        std::uint64_t id_{};
+        std::shared_ptr<detail::callback_state> state_;
+    }; // class callback_registration
+
+    /// \brief Owns the metrics of the process and renders them in the Prometheus text format.
+    ///
+    /// Metrics are identified by name and labels and live as long as the process. Looking a
+    /// metric up takes a shared lock. Updating it does not take a lock at all.
+    class registry
+    {
+    public:
+        static auto instance() -> registry&
+        {
+            static registry r;
+            return r;
+        }
+
+        // Labels added to every series, e.g. the name of the service.
+        auto set_constant_labels(label_list _labels) -> void
+        {
+            std::unique_lock lk{mtx_};
+            constant_labels_ = render_labels(_labels);
+        }
+
+        // Metrics are not updated by the request path until the endpoint exposing them is running.
+        auto enable() noexcept -> void
+        {
+            enabled_.store(true, std::memory_order_relaxed);
+        }
+
+        auto enabled() const noexcept -> bool
+        {
+            return enabled_.load(std::memory_order_relaxed);
+        }
+
+        auto get_counter(std::string_view _name, std::string_view _help, label_list _labels = {}) -> counter&
+        {
+            return get<counter>(_name, _help, metric_type::counter, _labels);
+        }
+
+        auto get_gauge(std::string_view _name, std::string_view _help, label_list _labels = {}) -> gauge&
+        {
+            return get<gauge>(_name, _help, metric_type::gauge, _labels);
+        }
+
+        auto get_histogram(std::string_view _name, std::string_view _help, label_list _labels = {}) -> histogram&
+        {
+            return get<histogram>(_name, _help, metric_type::histogram, _labels);
+        }
+
+        /// \brief Registers a counter or gauge whose value is read from \p _fn on every scrape.
+        ///
+        /// A later registration for the same name and labels replaces an earlier one.
+        [[nodiscard]]
+        auto add_callback(std::string_view _name,
+                          std::string_view _help,
+                          metric_type _type,
+                          label_list _labels,
+                          std::function<double()> _fn) -> callback_registration
+        {
+            auto labels = render_labels(_labels);
+
+            std::unique_lock lk{mtx_};
+
+            auto& f = get_family(_name, _help, _type);
+            const auto id = ++next_callback_id_;
+            auto state = std::make_shared<detail::callback_state>(std::move(_fn));
+            f.series[labels] = callback{id, state};
+
+            return {*this, std::string{_name}, std::move(labels), id, std::move(state)};
+        }
+
+        auto remove_callback(const std::string& _name, const std::string& _labels, std::uint64_t _id) -> void
+        {
+            std::unique_lock lk{mtx_};
+
+            if (auto f = families_.find(_name); f != families_.end()) {
+                if (auto s = f->second.series.find(_labels); s != f->second.series.end()) {
+                    if (const auto* cb = std::get_if<callback>(&s->second); cb && cb->id == _id) {
+                        f->second.series.erase(s);
+                    }
+                }
+            }
+        }
+
+        // Renders all metrics in the Prometheus text exposition format (version 0.0.4).
+        auto serialize() const -> std::string
+        {
+            std::string out;
+            std::vector<deferred_sample> deferred;
+
+            {
+                std::shared_lock lk{mtx_};
+
+                auto it = std::back_inserter(out);
+
+                for (const auto& entry : families_) {
+                    const auto& name = entry.first;
+                    const auto& f = entry.second;
+
+                    if (f.series.empty()) {
+                        continue;
+                    }
+
+                    fmt::format_to(it, "# HELP {} {}\n# TYPE {} {}\n", name, f.help, name, to_string(f.type));
+
+                    for (const auto& series : f.series) {
+                        auto labels = join_labels(constant_labels_, series.first);
+
+                        // Callbacks are sampled once the lock is released.
+                        if (const auto* cb = std::get_if<callback>(&series.second); cb) {
+                            deferred.push_back({out.size(), name, std::move(labels), cb->state});
+                            continue;
+                        }
+
+                        std::visit([&out, &name, &labels](const auto& _s) { write_series(out, name, labels, _s); }, series.second);
+                    }
+                }
+            }
+
+            if (deferred.empty()) {
+                return out;
+            }
+
+            std::string result;
+            result.reserve(out.size() + deferred.size() * 64);
+
+            std::size_t pos = 0;
+
+            for (const auto& d : deferred) {
+                result.append(out, pos, d.offset - pos);
+                pos = d.offset;
+
+                if (const auto value = d.state->sample(); value) {
+                    write_sample(result, d.name, d.labels, *value);
+                }
+            }
+
+            result.append(out, pos);
+
+            return result;
+        }
+
+    private:
+        struct callback
+        {
+            std::uint64_t id;
+            std::shared_ptr<detail::callback_state> state;
+        }; // struct callback
+
+        struct deferred_sample
+        {
+            std::size_t offset; // Where the sample belongs in the output.
+            std::string name;
+            std::string labels;
+            std::shared_ptr<detail::callback_state> state;
+        }; // struct deferred_sample
+
+        using series_type = std::variant<std::unique_ptr<counter>, std::unique_ptr<gauge>, std::unique_ptr<histogram>, callback>;
+
+        struct family
+        {
+            std::string help;
+            metric_type type;
+            std::map<std::string, series_type, std::less<>> series;
+        }; // struct family
+
+        registry() = default;
+
+        static auto to_string(metric_type _type) -> std::string_view
+        {
+            switch (_type) {
+                case metric_type::counter:   return "counter";
+                case metric_type::gauge:     return "gauge";
+                case metric_type::histogram: return "histogram";
+            }
+
+            return "untyped";
+        }
+
+        static auto render_labels(label_list _labels) -> std::string
+        {
+            std::string out;
+
+            for (const auto& [k, v] : _labels) {
+                if (!out.empty()) {
+                    out += ',';
+                }
+
+                out.append(k);
+                out += "=\"";
+                detail::append_escaped_label_value(out, v);
+                out += '"';
+            }
+
+            return out;
+        }
+
+        static auto join_labels(std::string_view _a, std::string_view _b) -> std::string
+        {
+            std::string out{_a};
+
+            if (!out.empty() && !_b.empty()) {
+                out += ',';
+            }
+
+            out.append(_b);
+
+            return out;
+        }
+
+        static auto write_sample(std::string& _out, std::string_view _name, std::string_view _labels, double _value) -> void
+        {
+            if (_labels.empty()) {
+                fmt::format_to(std::back_inserter(_out), "{} {}\n", _name, _value);
+            }
+            else {
+                fmt::format_to(std::back_inserter(_out), "{}{{{}}} {}\n", _name, _labels, _value);
+            }
+        }
+
+        static auto write_series(std::string& _out, std::string_view _name, std::string_view _labels, const std::unique_ptr<counter>& _c) -> void
+        {
+            write_sample(_out, _name, _labels, static_cast<double>(_c->value()));
+        }
+
+        static auto write_series(std::string& _out, std::string_view _name, std::string_view _labels, const std::unique_ptr<gauge>& _g) -> void
+        {
+            write_sample(_out, _name, _labels, static_cast<double>(_g->value()));
+        }
+
+        // Callbacks are sampled by serialize after the lock is released.
+        static auto write_series(std::string&, std::string_view, std::string_view, const callback&) -> void
+        {
+        }
+
+        static auto write_series(std::string& _out, std::string_view _name, std::string_view _labels, const std::unique_ptr<histogram>& _h) -> void
+        {
+            const auto s = _h->get_snapshot();
+            const auto bucket_name = fmt::format("{}_bucket", _name);
+            const auto separator = _labels.empty() ? "" : ",";
+
+            std::uint64_t cumulative = 0;
+
+            for (std::size_t i = 0; i + 1 < histogram::bucket_count; ++i) {
+                cumulative += s.buckets[i];
+                const auto le = fmt::format("{}le=\"{}\"", separator, histogram::upper_bound(i) / 1e6);
+                write_sample(_out, bucket_name, fmt::format("{}{}", _labels, le), static_cast<double>(cumulative));
+            }
+
+            write_sample(_out, bucket_name, fmt::format("{}{}le=\"+Inf\"", _labels, separator), static_cast<double>(s.count));
+            write_sample(_out, fmt::format("{}_sum", _name), _labels, s.sum_in_microseconds / 1e6);
+            write_sample(_out, fmt::format("{}_count", _name), _labels, static_cast<double>(s.count));
+        }
+
+        // Requires mtx_ to be held exclusively.
+        auto get_family(std::string_view _name, std::string_view _help, metric_type _type) -> family&
+        {
+            auto f = families_.find(_name);
+
+            if (f == families_.end()) {
+                f = families_.emplace(std::string{_name}, family{std::string{_help}, _type, {}}).first;
+            }
+            else if (f->second.type != _type) {
+                throw std::logic_error{fmt::format("metrics: [{}] is already registered with a different type", _name)};
+            }
+
+            return f->second;
+        }
+
+        template <typename Metric>
+        auto get(std::string_view _name, std::string_view _help, metric_type _type, label_list _labels) -> Metric&
+        {
+            const auto labels = render_labels(_labels);
+
+            {
+                std::shared_lock lk{mtx_};
+
+                if (auto* m = find<Metric>(_name, labels); m) {
+                    return *m;
+                }
+            }
+
+            std::unique_lock lk{mtx_};
+
+            if (auto* m = find<Metric>(_name, labels); m) {
+                return *m;
+            }
+
+            auto& f = get_family(_name, _help, _type);
+            auto& series = f.series[labels];
+            series = std::make_unique<Metric>();
+
+            return *std::get<std::unique_ptr<Metric>>(series);
+        }
+
+        // Requires mtx_ to be held.
+        template <typename Metric>
+        auto find(std::string_view _name, std::string_view _labels) const -> Metric*
+        {
+            if (auto f = families_.find(_name); f != families_.end()) {
+                if (auto s = f->second.series.find(_labels); s != f->second.series.end()) {
+                    if (const auto* p = std::get_if<std::unique_ptr<Metric>>(&s->second); p) {
+                        return p->get();
+                    }
+                }
+            }
+
+            return nullptr;
+        }
+
+        mutable std::shared_mutex mtx_;
+        std::map<std::string, family, std::less<>> families_;
+        std::string constant_labels_;
+        std::uint64_t next_callback_id_{};
+        std::atomic<bool> enabled_{false};
+    }; // class registry
+
+    callback_registration::~callback_registration()
+    {
+        if (registry_) {
+            registry_->remove_callback(name_, labels_, id_);
+        }
+
+        // A later registration may have replaced this one in the registry, so the function is
+        // deactivated here rather than by remove_callback.
+        if (state_) {
+            state_->deactivate();
+        }
+    }
+
+    /// \brief Invokes \p _fn, an iRODS API call such as rcDataObjRepl, and records the call,
+    /// its latency and whether it failed under the label api=\p _api. If the request is being
+    /// traced, the call is also recorded as a span named \p _api.
+    ///
+    /// A call fails if it throws, returns a negative integer or returns a null pointer.
+    /// \p _api must outlive the request (e.g. a string literal).
+    template <typename Fn, typename... Args>
+    auto invoke(std::string_view _api, Fn&& _fn, Args&&... _args) -> decltype(auto)
+    {
+        using result_type = std::invoke_result_t<Fn, Args...>;
+
+        tracing::span span{_api, tracing::span_kind::client};
+
+        auto& r = registry::instance();
+        const auto enabled = r.enabled();
+        const auto start = std::chrono::steady_clock::now();
+
+        // The error code is the negative integer returned by the call, or -1 otherwise.
+        const auto record = [&](int _error_code) {
+            if (0 != _error_code) {
+                span.set_error(_error_code);
+            }
+
+            if (!enabled) {
+                return;
+            }
+
+            const label_list labels{{"api", _api}};
+            r.get_counter("irods_rest_irods_api_calls_total", "Calls made to the iRODS server, by API.", labels).increment();
+            r.get_histogram("irods_rest_irods_api_duration_seconds", "Latency of calls to the iRODS server, by API.", labels)
+                .observe(std::chrono::steady_clock::now() - start);
+
+            if (0 != _error_code) {
+                r.get_counter("irods_rest_irods_api_errors_total", "Calls to the iRODS server which failed, by API.", labels).increment();
+            }
+        };
+
+        try {
+            if constexpr (std::is_void_v<result_type>) {
+                std::invoke(std::forward<Fn>(_fn), std::forward<Args>(_args)...);
+                record(0);
+            }
+            else {
+                decltype(auto) result = std::invoke(std::forward<Fn>(_fn), std::forward<Args>(_args)...);
+
+                if constexpr (std::is_integral_v<result_type>) {
+                    record(result < 0 ? static_cast<int>(result) : 0);
+                }
+                else if constexpr (std::is_pointer_v<result_type>) {
+                    record(result ? 0 : -1);
+                }
+                else {
+                    record(0);
+                }
+
+                return static_cast<result_type>(result);
+            }
+        }
+        catch (...) {
+            record(-1);
+            throw;
+        }
+    } // invoke
+} // namespace irods::rest::metrics
+
+#endif // IRODS_REST_CPP_METRICS_HPP
@@ -0,0 +1,67 @@
+#ifndef IRODS_REST_CPP_METRICS_ENDPOINT_HPP
+#define IRODS_REST_CPP_METRICS_ENDPOINT_HPP
+
+#include "irods_rest_api_base.h"
+#include "metrics.hpp"
+
+#include <pistache/endpoint.h>
+#include <pistache/http.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace irods::rest
+{
+    namespace detail
+    {
+        class metrics_handler : public Pistache::Http::Handler
+        {
+        public:
+            HTTP_PROTOTYPE(metrics_handler)
+
+            void onRequest(const Pistache::Http::Request& _request, Pistache::Http::ResponseWriter _response) override
+            {
+                if (Pistache::Http::Method::Get != _request.method() || "/metrics" != _request.resource()) {
+                    _response.send(Pistache::Http::Code::Not_Found);
+                    return;
+                }
+
+                static const auto media_type = Pistache::Http::Mime::MediaType::fromString("text/plain; version=0.0.4");
+                _response.send(Pistache::Http::Code::Ok, metrics::registry::instance().serialize(), media_type);
+            }
+        }; // class metrics_handler
+    } // namespace detail
+
+    /// \brief Serves the metrics of the process at GET /metrics on the port configured as
+    /// "metrics_port" for \p _service_name.
+    ///
+    /// Metrics are only collected while the endpoint is running.
+    ///
+    /// \return The running endpoint, or nullptr if no port is configured.
+    inline auto start_metrics_endpoint(const std::string& _service_name) -> std::unique_ptr<Pistache::Http::Endpoint>
+    {
+        const auto& cfg = configuration::rest_service(_service_name);
+
+        const auto iter = cfg.find(configuration_keywords::metrics_port);
+
+        if (iter == cfg.end()) {
+            return nullptr;
+        }
+
+        auto& registry = metrics::registry::instance();
+        registry.set_constant_labels({{"service", _service_name}});
+
+        const auto addr = Pistache::Address(Pistache::Ipv4::any(), Pistache::Port(iter->get<int>()));
+        auto endpoint = std::make_unique<Pistache::Http::Endpoint>(addr);
+        endpoint->init(Pistache::Http::Endpoint::options().threads(1));
+        endpoint->setHandler(Pistache::Http::make_handler<detail::metrics_handler>());
+        endpoint->serveThreaded();
+
+        registry.enable();
+
+        return endpoint;
+    } // start_metrics_endpoint
+} // namespace irods::rest
+
+#endif // IRODS_REST_CPP_METRICS_ENDPOINT_HPP
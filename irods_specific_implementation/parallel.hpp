@@ -0,0 +1,216 @@
+#ifndef IRODS_REST_CPP_PARALLEL_HPP
+#define IRODS_REST_CPP_PARALLEL_HPP
+
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace irods::rest
+{
+    /// \brief Invokes \p _fn for every index in [0, \p _count) using at most \p _max_workers threads.
+    ///
+    /// The calling thread is one of the workers. Indices are handed out in increasing order, but
+    /// may complete in any order. Callers wanting per-item errors must catch them inside \p _fn.
+    /// Spans started by \p _fn belong to the caller's trace.
+    ///
+    /// \throws The first exception thrown by \p _fn, after every worker has finished.
+    template <typename Fn>
+    auto for_each_index_in_parallel(std::size_t _count, std::size_t _max_workers, Fn _fn) -> void
+    {
+        std::atomic<std::size_t> next{0};
+        std::exception_ptr first_error;
+        std::mutex error_mutex;
+
+        const auto context = tracing::context::current();
+
+        const auto work = [&] {
+            const tracing::context_scope scope{context};
+
+            for (auto i = next++; i < _count; i = next++) {
+                try {
+                    _fn(i);
+                }
+                catch (...) {
+                    std::scoped_lock lk{error_mutex};
+
+                    if (!first_error) {
+                        first_error = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        const auto worker_count = std::clamp<std::size_t>(_max_workers, 1, std::max<std::size_t>(_count, 1));
+
+        std::vector<std::thread> workers;
+        workers.reserve(worker_count - 1);
+
+        for (std::size_t i = 1; i < worker_count; ++i) {
+            workers.emplace_back(work);
+        }
+
+        work();
+
+        for (auto& w : workers) {
+            w.join();
+        }
+
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+    } // for_each_index_in_parallel
+
+    /// \brief A FIFO queue holding at most a fixed number of items, used to hand work from one
+    /// producer to several workers without buffering all of it.
+    template <typename T>
+    class bounded_queue
+    {
+    public:
+        explicit bounded_queue(std::size_t _capacity)
+            : capacity_{std::max<std::size_t>(_capacity, 1)}
+        {
+        }
+
+        bounded_queue(const bounded_queue&) = delete;
+        auto operator=(const bounded_queue&) -> bounded_queue& = delete;
+
+        /// Blocks while the queue is full. Returns false if the queue was cancelled.
+        auto push(T _item) -> bool
+        {
+            std::unique_lock lk{mutex_};
+            not_full_.wait(lk, [this] { return cancelled_ || items_.size() < capacity_; });
+
+            if (cancelled_) {
+                return false;
+            }
+
+            items_.push_back(std::move(_item));
+            not_empty_.notify_one();
+
+            return true;
+        } // push
+
+        /// Blocks until an item is available. Returns nothing once the queue is closed and
+        /// empty, or cancelled.
+        auto pop() -> std::optional<T>
+        {
+            std::unique_lock lk{mutex_};
+            not_empty_.wait(lk, [this] { return cancelled_ || closed_ || !items_.empty(); });
+
+            if (cancelled_ || items_.empty()) {
+                return std::nullopt;
+            }
+
+            auto item = std::move(items_.front());
+            items_.pop_front();
+            not_full_.notify_one();
+
+            return item;
+        } // pop
+
+        /// No more items will be pushed. Workers drain the remaining items.
+        auto close() -> void
+        {
+            std::scoped_lock lk{mutex_};
+            closed_ = true;
+            not_empty_.notify_all();
+        } // close
+
+        /// Discards the remaining items and wakes every waiting producer and worker.
+        auto cancel() -> void
+        {
+            std::scoped_lock lk{mutex_};
+            cancelled_ = true;
+            items_.clear();
+            not_full_.notify_all();
+            not_empty_.notify_all();
+        } // cancel
+
+    private:
+        const std::size_t capacity_;
+        std::mutex mutex_;
+        std::condition_variable not_full_;
+        std::condition_variable not_empty_;
+        std::deque<T> items_;
+        bool closed_ = false;
+        bool cancelled_ = false;
+    }; // class bounded_queue
+
+    /// \brief Runs \p _produce on the calling thread while \p _worker_count threads drain the
+    /// items it pushes.
+    ///
+    /// \p _produce receives a function that pushes an item, blocking while \p _capacity items are
+    /// waiting, and returns false if the work was cancelled. Each worker invokes \p _consume once
+    /// with the queue and pops items until it is empty, so per-worker state such as a connection
+    /// can live on the worker's stack. Callers wanting per-item errors must catch them inside
+    /// \p _consume. Spans started by either function belong to the caller's trace.
+    ///
+    /// \throws The first exception thrown by \p _produce or \p _consume, after every worker has
+    /// finished. The remaining items are discarded.
+    template <typename T, typename Produce, typename Consume>
+    auto produce_and_consume_in_parallel(std::size_t _worker_count, std::size_t _capacity, Produce _produce, Consume _consume) -> void
+    {
+        bounded_queue<T> queue{_capacity};
+        std::exception_ptr first_error;
+        std::mutex error_mutex;
+
+        const auto record_error = [&] {
+            {
+                std::scoped_lock lk{error_mutex};
+
+                if (!first_error) {
+                    first_error = std::current_exception();
+                }
+            }
+
+            queue.cancel();
+        };
+
+        const auto context = tracing::context::current();
+
+        std::vector<std::thread> workers;
+        workers.reserve(std::max<std::size_t>(_worker_count, 1));
+
+        for (std::size_t i = 0; i < std::max<std::size_t>(_worker_count, 1); ++i) {
+            workers.emplace_back([&] {
+                const tracing::context_scope scope{context};
+
+                try {
+                    _consume(queue);
+                }
+                catch (...) {
+                    record_error();
+                }
+            });
+        }
+
+        try {
+            _produce([&queue](T _item) { return queue.push(std::move(_item)); });
+        }
+        catch (...) {
+            record_error();
+        }
+
+        queue.close();
+
+        for (auto& w : workers) {
+            w.join();
+        }
+
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+    } // produce_and_consume_in_parallel
+} // namespace irods::rest
+
+#endif // IRODS_REST_CPP_PARALLEL_HPP
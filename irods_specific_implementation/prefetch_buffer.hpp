@@ -0,0 +1,313 @@
+#ifndef IRODS_REST_CPP_PREFETCH_BUFFER_HPP
+#define IRODS_REST_CPP_PREFETCH_BUFFER_HPP
+
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace irods::rest
+{
+    /// \brief Holds values computed ahead of time on a background thread, such as the page a client
+    /// is expected to request next.
+    ///
+    /// Values are partitioned by user and expire after a short time-to-live. A value is served at
+    /// most once. The buffer is disabled until enable() is called.
+    template <typename Value>
+    class prefetch_buffer
+    {
+    public:
+        using clock_type = std::chrono::steady_clock;
+
+        struct statistics
+        {
+            std::uint64_t scheduled; // Computations queued.
+            std::uint64_t dropped;   // Computations not queued because the queue was full.
+            std::uint64_t hits;      // Lookups served from the buffer.
+            std::uint64_t misses;    // Lookups not served from the buffer.
+            std::uint64_t wasted;    // Values which expired or were evicted before being served.
+        }; // struct statistics
+
+        using report_function = std::function<void(const statistics&)>;
+
+        prefetch_buffer() = default;
+
+        prefetch_buffer(const prefetch_buffer&) = delete;
+        auto operator=(const prefetch_buffer&) -> prefetch_buffer& = delete;
+
+        ~prefetch_buffer()
+        {
+            metrics_.clear();
+
+            {
+                std::scoped_lock lk{mutex_};
+                exit_flag_ = true;
+            }
+
+            cv_.notify_all();
+
+            if (worker_.joinable()) {
+                worker_.join();
+            }
+        } // dtor
+
+        /// \brief Starts the background thread.
+        ///
+        /// \param[in] _time_to_live          How long a value is kept after it has been scheduled.
+        /// \param[in] _max_entries_per_user  The oldest value of a user is evicted beyond this limit.
+        /// \param[in] _report_interval       How often \p _report is invoked with the statistics.
+        auto enable(std::chrono::seconds _time_to_live,
+                    std::size_t _max_entries_per_user,
+                    std::chrono::seconds _report_interval,
+                    report_function _report) -> void
+        {
+            std::scoped_lock lk{mutex_};
+
+            if (worker_.joinable()) {
+                return;
+            }
+
+            time_to_live_ = _time_to_live;
+            max_entries_per_user_ = std::max<std::size_t>(1, _max_entries_per_user);
+            report_interval_ = std::max(_report_interval, std::chrono::seconds{1});
+            report_ = std::move(_report);
+            worker_ = std::thread{&prefetch_buffer::process_queue, this};
+        } // enable
+
+        auto enabled() const noexcept -> bool
+        {
+            return worker_.joinable();
+        } // enabled
+
+        /// \brief Exposes the statistics as Prometheus counters.
+        auto register_metrics() -> void
+        {
+            auto& r = metrics::registry::instance();
+
+            const auto add = [this, &r](std::string_view _name, std::string_view _help, metrics::label_list _labels, auto _fn) {
+                metrics_.push_back(r.add_callback(_name, _help, metrics::metric_type::counter, _labels, [this, _fn] {
+                    return static_cast<double>(_fn(get_statistics()));
+                }));
+            };
+
+            constexpr auto* lookups_help = "Lookups of prefetched pages, by result.";
+
+            add("irods_rest_prefetch_lookups_total", lookups_help, {{"result", "hit"}}, [](const statistics& _s) { return _s.hits; });
+            add("irods_rest_prefetch_lookups_total", lookups_help, {{"result", "miss"}}, [](const statistics& _s) { return _s.misses; });
+            add("irods_rest_prefetch_scheduled_total", "Pages queued for prefetching.", {}, [](const statistics& _s) { return _s.scheduled; });
+            add("irods_rest_prefetch_dropped_total", "Pages not prefetched because the queue was full.", {}, [](const statistics& _s) { return _s.dropped; });
+            add("irods_rest_prefetch_wasted_total", "Prefetched pages which expired, were evicted or were never started.", {},
+                [](const statistics& _s) { return _s.wasted; });
+        } // register_metrics
+
+        /// \brief Removes and returns the value mapped to \p _key for \p _user.
+        ///
+        /// Waits for the value if it is being computed. A value whose computation has not started
+        /// is a miss, because waiting for it would queue the request behind other prefetches.
+        auto take(const std::string& _user, const std::string& _key) -> std::optional<Value>
+        {
+            if (!enabled()) {
+                return std::nullopt;
+            }
+
+            std::shared_future<std::optional<Value>> future;
+
+            {
+                std::scoped_lock lk{mutex_};
+
+                remove_expired_entries(clock_type::now());
+
+                if (auto iter = users_.find(_user); iter != std::end(users_)) {
+                    auto& entries = iter->second;
+
+                    for (auto e = std::begin(entries); e != std::end(entries); ++e) {
+                        if (e->key == _key) {
+                            // The worker removes a task from the queue before running it.
+                            if (auto t = std::find(std::begin(queue_), std::end(queue_), e->task); t != std::end(queue_)) {
+                                queue_.erase(t);
+                                ++stats_.wasted;
+                            }
+                            else {
+                                future = e->value;
+                            }
+
+                            entries.erase(e);
+                            break;
+                        }
+                    }
+
+                    if (entries.empty()) {
+                        users_.erase(iter);
+                    }
+                }
+
+                if (!future.valid()) {
+                    ++stats_.misses;
+                    return std::nullopt;
+                }
+            }
+
+            std::optional<Value> value;
+
+            try {
+                value = future.get();
+            }
+            catch (const std::future_error&) {
+                // The buffer is shutting down.
+            }
+
+            std::scoped_lock lk{mutex_};
+            ++(value ? stats_.hits : stats_.misses);
+
+            return value;
+        } // take
+
+        /// \brief Queues \p _fn to compute the value mapped to \p _key for \p _user.
+        ///
+        /// \p _fn returns an empty optional (or throws) if the result must not be served.
+        template <typename Fn>
+        auto schedule(const std::string& _user, const std::string& _key, Fn _fn) -> void
+        {
+            if (!enabled()) {
+                return;
+            }
+
+            std::scoped_lock lk{mutex_};
+
+            if (queue_.size() >= max_queue_size) {
+                ++stats_.dropped;
+                return;
+            }
+
+            auto& entries = users_[_user];
+
+            for (const auto& e : entries) {
+                if (e.key == _key) {
+                    return;
+                }
+            }
+
+            while (entries.size() >= max_entries_per_user_) {
+                entries.pop_front();
+                ++stats_.wasted;
+            }
+
+            auto task = std::make_shared<std::packaged_task<std::optional<Value>()>>(
+                [fn = std::move(_fn)]() -> std::optional<Value> {
+                    try {
+                        return fn();
+                    }
+                    catch (...) {
+                        return std::nullopt;
+                    }
+                });
+
+            entries.push_back({_key, task, task->get_future().share(), clock_type::now() + time_to_live_});
+            queue_.push_back(std::move(task));
+            ++stats_.scheduled;
+
+            cv_.notify_one();
+        } // schedule
+
+        auto get_statistics() const -> statistics
+        {
+            std::scoped_lock lk{mutex_};
+            return stats_;
+        } // get_statistics
+
+    private:
+        static constexpr std::size_t max_queue_size = 64;
+
+        using task_pointer = std::shared_ptr<std::packaged_task<std::optional<Value>()>>;
+
+        struct entry
+        {
+            std::string key;
+            task_pointer task;
+            std::shared_future<std::optional<Value>> value;
+            clock_type::time_point expires_at;
+        }; // struct entry
+
+        // Requires mutex_ to be held.
+        auto remove_expired_entries(clock_type::time_point _now) -> void
+        {
+            for (auto u = std::begin(users_); u != std::end(users_);) {
+                auto& entries = u->second;
+
+                while (!entries.empty() && entries.front().expires_at <= _now) {
+                    entries.pop_front();
+                    ++stats_.wasted;
+                }
+
+                u = entries.empty() ? users_.erase(u) : std::next(u);
+            }
+        } // remove_expired_entries
+
+        auto process_queue() -> void
+        {
+            auto last_report = clock_type::now();
+
+            while (true) {
+                task_pointer task;
+                std::optional<statistics> report;
+
+                {
+                    std::unique_lock lk{mutex_};
+
+                    cv_.wait_for(lk, report_interval_, [this] { return exit_flag_ || !queue_.empty(); });
+
+                    if (exit_flag_) {
+                        return;
+                    }
+
+                    if (!queue_.empty()) {
+                        task = std::move(queue_.front());
+                        queue_.pop_front();
+                    }
+
+                    if (const auto now = clock_type::now(); now - last_report >= report_interval_) {
+                        remove_expired_entries(now);
+                        report = stats_;
+                        last_report = now;
+                    }
+                }
+
+                if (task) {
+                    (*task)();
+                }
+
+                if (report && report_) {
+                    report_(*report);
+                }
+            }
+        } // process_queue
+
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        std::thread worker_;
+        bool exit_flag_{};
+        std::chrono::seconds time_to_live_{};
+        std::size_t max_entries_per_user_{1};
+        std::chrono::seconds report_interval_{60};
+        report_function report_;
+        std::deque<task_pointer> queue_;
+        std::map<std::string, std::deque<entry>> users_;
+        statistics stats_{};
+        std::vector<metrics::callback_registration> metrics_;
+    }; // class prefetch_buffer
+} // namespace irods::rest
+
+#endif // IRODS_REST_CPP_PREFETCH_BUFFER_HPP
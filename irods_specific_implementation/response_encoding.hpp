@@ -0,0 +1,149 @@
+#ifndef IRODS_REST_CPP_RESPONSE_ENCODING_HPP
+#define IRODS_REST_CPP_RESPONSE_ENCODING_HPP
+
+#include "json_writer.hpp"
+
+#include <nlohmann/json.hpp>
+#include <pistache/http.h>
+#include <pistache/router.h>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+namespace irods::rest
+{
+    enum class response_encoding
+    {
+        json,
+        cbor,
+        msgpack
+    }; // enum class response_encoding
+
+    // Returns true if the Accept header of the request lists _media_type.
+    inline auto accepts(const Pistache::Rest::Request& _request, const std::string_view _media_type) -> bool
+    {
+        const auto accept = _request.headers().tryGet<Pistache::Http::Header::Accept>();
+
+        if (!accept) {
+            return false;
+        }
+
+        const auto& media = accept->media();
+
+        return std::any_of(std::begin(media), std::end(media), [_media_type](const auto& _m) {
+            return _m.toString().rfind(_media_type, 0) == 0;
+        });
+    } // accepts
+
+    inline auto negotiate_response_encoding(const Pistache::Rest::Request& _request) -> response_encoding
+    {
+        if (accepts(_request, "application/cbor")) {
+            return response_encoding::cbor;
+        }
+
+        if (accepts(_request, "application/msgpack") || accepts(_request, "application/x-msgpack")) {
+            return response_encoding::msgpack;
+        }
+
+        return response_encoding::json;
+    } // negotiate_response_encoding
+
+    inline auto to_media_type(response_encoding _encoding) -> Pistache::Http::Mime::MediaType
+    {
+        switch (_encoding) {
+            case response_encoding::cbor:
+                return Pistache::Http::Mime::MediaType::fromString("application/cbor");
+
+            case response_encoding::msgpack:
+                return Pistache::Http::Mime::MediaType::fromString("application/msgpack");
+
+            default:
+                return Pistache::Http::Mime::MediaType::fromString("application/json");
+        }
+    } // to_media_type
+
+    // Re-encodes a JSON document without changing its structure.
+    inline auto encode_json(std::string_view _json, response_encoding _encoding) -> std::string
+    {
+        // Some responses (e.g. from rcZoneReport) include the terminating null character.
+        while (!_json.empty() && '\0' == _json.back()) {
+            _json.remove_suffix(1);
+        }
+
+        if (response_encoding::json == _encoding) {
+            return std::string{_json};
+        }
+
+        const auto doc = nlohmann::json::parse(_json);
+
+        std::string out;
+
+        if (response_encoding::cbor == _encoding) {
+            nlohmann::json::to_cbor(doc, out);
+        }
+        else {
+            nlohmann::json::to_msgpack(doc, out);
+        }
+
+        return out;
+    } // encode_json
+
+    inline auto encode_document(const nlohmann::json& _doc, response_encoding _encoding) -> std::string
+    {
+        std::string out;
+
+        switch (_encoding) {
+            case response_encoding::cbor:
+                nlohmann::json::to_cbor(_doc, out);
+                break;
+
+            case response_encoding::msgpack:
+                nlohmann::json::to_msgpack(_doc, out);
+                break;
+
+            default:
+                out = _doc.dump();
+                break;
+        }
+
+        return out;
+    } // encode_document
+
+    // Invokes _write with a writer for _encoding and returns the encoded document. JSON is
+    // written as text directly. CBOR and MessagePack are encoded from a document built once.
+    template <typename Fn>
+    auto write_document(response_encoding _encoding, Fn&& _write) -> std::string
+    {
+        if (response_encoding::json == _encoding) {
+            std::string body;
+            json_writer writer{body};
+            _write(writer);
+            return body;
+        }
+
+        nlohmann::json doc;
+        json_document_writer writer{doc};
+        _write(writer);
+
+        return encode_document(doc, _encoding);
+    } // write_document
+
+    // Tells handle_request that the body is already encoded as _encoding and must be sent as is.
+    // JSON responses are left without a Content-Type, as before.
+    inline auto set_response_encoding(Pistache::Http::ResponseWriter& _response, response_encoding _encoding) -> void
+    {
+        if (response_encoding::json == _encoding) {
+            return;
+        }
+
+        _response.headers().add<Pistache::Http::Header::ContentType>(to_media_type(_encoding));
+    } // set_response_encoding
+
+    inline auto is_response_encoded(Pistache::Http::ResponseWriter& _response) -> bool
+    {
+        return _response.headers().has<Pistache::Http::Header::ContentType>();
+    } // is_response_encoded
+} // namespace irods::rest
+
+#endif // IRODS_REST_CPP_RESPONSE_ENCODING_HPP
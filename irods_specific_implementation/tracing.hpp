@@ -0,0 +1,651 @@
+#ifndef IRODS_REST_CPP_TRACING_HPP
+#define IRODS_REST_CPP_TRACING_HPP
+
+#include "json_writer.hpp"
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Request-scoped spans, exported as OpenTelemetry (OTLP/JSON) records.
+namespace irods::rest::tracing
+{
+    enum class span_kind
+    {
+        internal = 1,
+        server = 2,
+        client = 3
+    }; // enum class span_kind
+
+    using trace_id_type = std::array<std::uint8_t, 16>;
+
+    struct settings
+    {
+        // Each finished trace is appended to this file as one line of JSON. No file is
+        // written if empty.
+        std::string file;
+
+        // Requests taking at least this long are logged with their spans. Disabled if zero.
+        std::chrono::milliseconds slow_request_threshold{0};
+
+        std::size_t maximum_number_of_spans_per_request = 1024;
+        std::size_t maximum_number_of_queued_traces = 4096;
+    }; // struct settings
+
+    struct span_record
+    {
+        std::string_view name;
+        span_kind kind;
+        std::uint64_t span_id;
+        std::uint64_t parent_span_id;      // Zero for a root span without a remote parent.
+        std::chrono::nanoseconds start;    // Relative to the start of the trace.
+        std::chrono::nanoseconds duration;
+        int error_code;                    // Non-zero if the operation failed.
+    }; // struct span_record
+
+    namespace detail
+    {
+        inline auto random_u64() -> std::uint64_t
+        {
+            thread_local std::mt19937_64 engine{std::random_device{}()};
+
+            std::uint64_t v = 0;
+
+            // Zero is not a valid identifier.
+            while (0 == v) {
+                v = engine();
+            }
+
+            return v;
+        } // random_u64
+
+        inline auto append_hex(std::string& _out, const std::uint8_t* _bytes, std::size_t _size) -> void
+        {
+            constexpr std::string_view digits = "0123456789abcdef";
+
+            for (std::size_t i = 0; i < _size; ++i) {
+                _out += digits[_bytes[i] >> 4];
+                _out += digits[_bytes[i] & 0x0f];
+            }
+        } // append_hex
+
+        inline auto append_hex(std::string& _out, std::uint64_t _v) -> void
+        {
+            std::array<std::uint8_t, 8> bytes{};
+
+            for (int i = 7; i >= 0; --i, _v >>= 8) {
+                bytes[i] = static_cast<std::uint8_t>(_v & 0xff);
+            }
+
+            append_hex(_out, bytes.data(), bytes.size());
+        } // append_hex
+
+        // Parses _size bytes of lowercase hexadecimal. Returns false on any other character.
+        inline auto parse_hex(std::string_view _s, std::uint8_t* _out, std::size_t _size) -> bool
+        {
+            const auto nibble = [](char _c) -> int {
+                if (_c >= '0' && _c <= '9') { return _c - '0'; }
+                if (_c >= 'a' && _c <= 'f') { return _c - 'a' + 10; }
+                return -1;
+            };
+
+            if (_s.size() != 2 * _size) {
+                return false;
+            }
+
+            for (std::size_t i = 0; i < _size; ++i) {
+                const auto hi = nibble(_s[2 * i]);
+                const auto lo = nibble(_s[2 * i + 1]);
+
+                if (hi < 0 || lo < 0) {
+                    return false;
+                }
+
+                _out[i] = static_cast<std::uint8_t>((hi << 4) | lo);
+            }
+
+            return true;
+        } // parse_hex
+    } // namespace detail
+
+    /// \brief The trace and parent span received in a W3C traceparent header.
+    struct traceparent
+    {
+        trace_id_type trace_id;
+        std::uint64_t parent_span_id;
+
+        /// \brief Parses "00-<trace-id>-<parent-id>-<flags>".
+        ///
+        /// \return Nothing if the header is malformed or uses an all-zero identifier.
+        static auto parse(std::string_view _header) -> std::optional<traceparent>
+        {
+            if (_header.size() != 55 || _header.substr(0, 3) != "00-" || '-' != _header[35] || '-' != _header[52]) {
+                return std::nullopt;
+            }
+
+            traceparent tp{};
+            std::array<std::uint8_t, 8> parent{};
+            std::uint8_t flags{};
+
+            if (!detail::parse_hex(_header.substr(3, 32), tp.trace_id.data(), tp.trace_id.size()) ||
+                !detail::parse_hex(_header.substr(36, 16), parent.data(), parent.size()) ||
+                !detail::parse_hex(_header.substr(53, 2), &flags, 1))
+            {
+                return std::nullopt;
+            }
+
+            for (auto b : parent) {
+                tp.parent_span_id = (tp.parent_span_id << 8) | b;
+            }
+
+            const auto all_zero = std::all_of(std::begin(tp.trace_id), std::end(tp.trace_id), [](auto _b) { return 0 == _b; });
+
+            if (all_zero || 0 == tp.parent_span_id) {
+                return std::nullopt;
+            }
+
+            return tp;
+        } // parse
+    }; // struct traceparent
+
+    /// \brief The spans recorded while handling one request.
+    ///
+    /// Spans may be added from any thread which has adopted the trace's context.
+    class trace
+    {
+    public:
+        trace(std::string _name, const std::optional<traceparent>& _parent, std::size_t _max_spans)
+            : name_{std::move(_name)}
+            , trace_id_{}
+            , root_span_id_{detail::random_u64()}
+            , remote_parent_span_id_{}
+            , start_time_{std::chrono::system_clock::now()}
+            , start_{std::chrono::steady_clock::now()}
+            , max_spans_{_max_spans}
+            , dropped_spans_{}
+            , attributes_{}
+            , failed_{}
+        {
+            if (_parent) {
+                trace_id_ = _parent->trace_id;
+                remote_parent_span_id_ = _parent->parent_span_id;
+            }
+            else {
+                const auto hi = detail::random_u64();
+                const auto lo = detail::random_u64();
+
+                for (int i = 0; i < 8; ++i) {
+                    trace_id_[i] = static_cast<std::uint8_t>(hi >> (56 - 8 * i));
+                    trace_id_[8 + i] = static_cast<std::uint8_t>(lo >> (56 - 8 * i));
+                }
+            }
+        }
+
+        trace(const trace&) = delete;
+        auto operator=(const trace&) -> trace& = delete;
+
+        auto root_span_id() const noexcept -> std::uint64_t
+        {
+            return root_span_id_;
+        }
+
+        // Returns the value of a traceparent header identifying the root span.
+        auto make_traceparent() const -> std::string
+        {
+            std::string out{"00-"};
+            detail::append_hex(out, trace_id_.data(), trace_id_.size());
+            out += '-';
+            detail::append_hex(out, root_span_id_);
+            out += "-01";
+            return out;
+        }
+
+        auto elapsed() const noexcept -> std::chrono::nanoseconds
+        {
+            return std::chrono::steady_clock::now() - start_;
+        }
+
+        auto add_span(const span_record& _span) -> void
+        {
+            std::scoped_lock lk{mtx_};
+
+            if (spans_.size() >= max_spans_) {
+                ++dropped_spans_;
+                return;
+            }
+
+            spans_.push_back(_span);
+        }
+
+        auto set_attribute(std::string_view _key, std::string _value) -> void
+        {
+            attributes_.emplace_back(_key, std::move(_value));
+        }
+
+        // Marks the root span as failed.
+        auto set_failed() noexcept -> void
+        {
+            failed_ = true;
+        }
+
+        /// \brief Renders the trace as an OTLP/JSON ExportTraceServiceRequest.
+        ///
+        /// \param[in] _duration The duration of the root span.
+        auto to_otlp_json(std::string_view _service_name, std::chrono::nanoseconds _duration) const -> std::string
+        {
+            std::string out;
+            json_writer w{out};
+
+            w.begin_object().key("resourceSpans").begin_array().begin_object();
+
+            w.key("resource").begin_object().key("attributes").begin_array();
+            write_attribute(w, "service.name", _service_name);
+            w.end_array().end_object();
+
+            w.key("scopeSpans").begin_array().begin_object();
+            w.key("scope").begin_object().member("name", "irods_client_rest_cpp").end_object();
+            w.key("spans").begin_array();
+
+            std::scoped_lock lk{mtx_};
+
+            write_span(w, name_, span_kind::server, root_span_id_, remote_parent_span_id_, {}, _duration, 0, true);
+
+            for (const auto& s : spans_) {
+                write_span(w, s.name, s.kind, s.span_id, s.parent_span_id, s.start, s.duration, s.error_code, false);
+            }
+
+            w.end_array().end_object().end_array();
+            w.end_object().end_array().end_object();
+
+            return out;
+        }
+
+        // Renders the spans as a {"message": ...} log payload, with times in milliseconds
+        // relative to the start of the request.
+        auto to_log_json(std::chrono::nanoseconds _duration) const -> std::string
+        {
+            const auto ms = [](std::chrono::nanoseconds _ns) {
+                return std::chrono::duration_cast<std::chrono::microseconds>(_ns).count() / 1000.0;
+            };
+
+            std::string out;
+            json_writer w{out};
+
+            w.begin_object();
+            w.member("message", fmt::format("Slow request [{}] took [{:.3f}] ms.", name_, ms(_duration)));
+
+            std::vector<span_record> spans;
+
+            {
+                std::scoped_lock lk{mtx_};
+                spans = spans_;
+            }
+
+            // Spans are recorded as they end. Listing them by start time reads like a timeline.
+            // A parent starting at the same time as its child is listed first.
+            std::sort(std::begin(spans), std::end(spans), [](const auto& _l, const auto& _r) {
+                return (_l.start != _r.start) ? _l.start < _r.start : _l.duration > _r.duration;
+            });
+
+            w.key("spans").begin_array();
+
+            for (const auto& s : spans) {
+                std::string id;
+                detail::append_hex(id, s.span_id);
+                std::string parent;
+                detail::append_hex(parent, s.parent_span_id);
+
+                w.begin_object();
+                w.member("duration_ms", fmt::format("{:.3f}", ms(s.duration)));
+                w.member("error_code", s.error_code);
+                w.member("name", s.name);
+                w.member("parent_span_id", parent);
+                w.member("span_id", id);
+                w.member("start_ms", fmt::format("{:.3f}", ms(s.start)));
+                w.end_object();
+            }
+
+            w.end_array();
+
+            std::string trace_id;
+            detail::append_hex(trace_id, trace_id_.data(), trace_id_.size());
+            w.member("trace_id", trace_id);
+
+            w.end_object();
+
+            return out;
+        }
+
+    private:
+        static auto write_attribute(json_writer& _w, std::string_view _key, std::string_view _value) -> void
+        {
+            _w.begin_object();
+            _w.member("key", _key);
+            _w.key("value").begin_object().member("stringValue", _value).end_object();
+            _w.end_object();
+        }
+
+        // Requires mtx_ to be held.
+        auto write_span(json_writer& _w,
+                        std::string_view _name,
+                        span_kind _kind,
+                        std::uint64_t _span_id,
+                        std::uint64_t _parent_span_id,
+                        std::chrono::nanoseconds _start,
+                        std::chrono::nanoseconds _duration,
+                        int _error_code,
+                        bool _root) const -> void
+        {
+            const auto start = std::chrono::duration_cast<std::chrono::nanoseconds>(start_time_.time_since_epoch()) + _start;
+
+            std::string id;
+
+            _w.begin_object();
+
+            detail::append_hex(id, trace_id_.data(), trace_id_.size());
+            _w.member("traceId", id);
+
+            id.clear();
+            detail::append_hex(id, _span_id);
+            _w.member("spanId", id);
+
+            if (0 != _parent_span_id) {
+                id.clear();
+                detail::append_hex(id, _parent_span_id);
+                _w.member("parentSpanId", id);
+            }
+
+            _w.member("name", _name);
+            _w.member("kind", static_cast<int>(_kind));
+
+            // 64-bit integers are encoded as strings in OTLP/JSON.
+            _w.member("startTimeUnixNano", std::to_string(start.count()));
+            _w.member("endTimeUnixNano", std::to_string((start + _duration).count()));
+
+            _w.key("attributes").begin_array();
+
+            if (_root) {
+                for (const auto& [k, v] : attributes_) {
+                    write_attribute(_w, k, v);
+                }
+
+                if (dropped_spans_ > 0) {
+                    write_attribute(_w, "irods.dropped_spans", std::to_string(dropped_spans_));
+                }
+            }
+
+            if (0 != _error_code) {
+                write_attribute(_w, "irods.error_code", std::to_string(_error_code));
+            }
+
+            _w.end_array();
+
+            // STATUS_CODE_OK is 1 and STATUS_CODE_ERROR is 2.
+            const auto failed = (0 != _error_code) || (_root && failed_);
+            _w.key("status").begin_object().member("code", failed ? 2 : 1).end_object();
+
+            _w.end_object();
+        }
+
+        const std::string name_;
+        trace_id_type trace_id_;
+        const std::uint64_t root_span_id_;
+        std::uint64_t remote_parent_span_id_;
+        const std::chrono::system_clock::time_point start_time_;
+        const std::chrono::steady_clock::time_point start_;
+        const std::size_t max_spans_;
+
+        mutable std::mutex mtx_;
+        std::vector<span_record> spans_;
+        std::size_t dropped_spans_;
+
+        // Only modified by the thread handling the request.
+        std::vector<std::pair<std::string_view, std::string>> attributes_;
+        bool failed_;
+    }; // class trace
+
+    // The trace and span that new spans on the calling thread become children of.
+    struct context
+    {
+        trace* trace_ptr;
+        std::uint64_t span_id;
+
+        static auto current() noexcept -> context&
+        {
+            thread_local context ctx{};
+            return ctx;
+        }
+    }; // struct context
+
+    // Makes _ctx the current context of the calling thread for the lifetime of the scope. Used
+    // by worker threads acting on behalf of a request.
+    class context_scope
+    {
+    public:
+        explicit context_scope(const context& _ctx) noexcept
+            : previous_{std::exchange(context::current(), _ctx)}
+        {
+        }
+
+        context_scope(const context_scope&) = delete;
+        auto operator=(const context_scope&) -> context_scope& = delete;
+
+        ~context_scope()
+        {
+            context::current() = previous_;
+        }
+
+    private:
+        context previous_;
+    }; // class context_scope
+
+    /// \brief Times an operation as a child of the current span.
+    ///
+    /// Does nothing unless the calling thread is handling a traced request. \p _name must
+    /// outlive the trace (e.g. a string literal).
+    class span
+    {
+    public:
+        explicit span(std::string_view _name, span_kind _kind = span_kind::internal)
+            : record_{}
+            , previous_{context::current()}
+        {
+            if (!previous_.trace_ptr) {
+                return;
+            }
+
+            record_.name = _name;
+            record_.kind = _kind;
+            record_.span_id = detail::random_u64();
+            record_.parent_span_id = previous_.span_id;
+            record_.start = previous_.trace_ptr->elapsed();
+
+            context::current().span_id = record_.span_id;
+        }
+
+        span(const span&) = delete;
+        auto operator=(const span&) -> span& = delete;
+
+        ~span()
+        {
+            if (!previous_.trace_ptr) {
+                return;
+            }
+
+            context::current() = previous_;
+
+            record_.duration = previous_.trace_ptr->elapsed() - record_.start;
+            previous_.trace_ptr->add_span(record_);
+        }
+
+        auto set_error(int _error_code) noexcept -> void
+        {
+            record_.error_code = _error_code;
+        }
+
+    private:
+        span_record record_;
+        context previous_;
+    }; // class span
+
+    /// \brief Decides whether requests are traced and where finished traces go.
+    ///
+    /// Traces are written to the configured file by a background thread, so the request
+    /// thread only renders them. Traces are dropped if the writer falls behind.
+    class tracer
+    {
+    public:
+        static auto instance() -> tracer&
+        {
+            static tracer t;
+            return t;
+        }
+
+        tracer(const tracer&) = delete;
+        auto operator=(const tracer&) -> tracer& = delete;
+
+        ~tracer()
+        {
+            {
+                std::scoped_lock lk{mtx_};
+                exit_flag_ = true;
+            }
+
+            cv_.notify_one();
+
+            if (writer_.joinable()) {
+                writer_.join();
+            }
+        }
+
+        // Enables tracing. Only the first call has an effect.
+        auto enable(std::string _service_name, settings _settings) -> void
+        {
+            std::call_once(enable_flag_, [this, &_service_name, &_settings] {
+                service_name_ = std::move(_service_name);
+                settings_ = std::move(_settings);
+
+                if (!settings_.file.empty()) {
+                    file_.open(settings_.file, std::ios::app);
+
+                    if (!file_) {
+                        std::string msg;
+                        json_writer{msg}
+                            .begin_object()
+                            .member("file", settings_.file)
+                            .member("message", "Could not open trace file. Traces will not be exported.")
+                            .end_object();
+                        spdlog::error(std::string_view{msg});
+                    }
+                    else {
+                        writer_ = std::thread{&tracer::write_traces, this};
+                    }
+                }
+
+                enabled_.store(true, std::memory_order_release);
+            });
+        }
+
+        auto enabled() const noexcept -> bool
+        {
+            return enabled_.load(std::memory_order_acquire);
+        }
+
+        auto get_settings() const noexcept -> const settings&
+        {
+            return settings_;
+        }
+
+        auto dropped_traces() const noexcept -> std::uint64_t
+        {
+            return dropped_traces_.load(std::memory_order_relaxed);
+        }
+
+        // Logs _trace if it was slow and queues it for export.
+        auto finish(const trace& _trace, std::chrono::nanoseconds _duration) -> void
+        {
+            if (settings_.slow_request_threshold.count() > 0 && _duration >= settings_.slow_request_threshold) {
+                spdlog::warn(std::string_view{_trace.to_log_json(_duration)});
+            }
+
+            if (!writer_.joinable()) {
+                return;
+            }
+
+            auto line = _trace.to_otlp_json(service_name_, _duration);
+
+            {
+                std::scoped_lock lk{mtx_};
+
+                if (queue_.size() >= settings_.maximum_number_of_queued_traces) {
+                    dropped_traces_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                queue_.push_back(std::move(line));
+            }
+
+            cv_.notify_one();
+        }
+
+    private:
+        tracer() = default;
+
+        auto write_traces() -> void
+        {
+            std::deque<std::string> batch;
+
+            while (true) {
+                {
+                    std::unique_lock lk{mtx_};
+                    cv_.wait(lk, [this] { return exit_flag_ || !queue_.empty(); });
+
+                    if (queue_.empty()) {
+                        return;
+                    }
+
+                    batch.swap(queue_);
+                }
+
+                for (const auto& line : batch) {
+                    file_ << line << '\n';
+                }
+
+                file_.flush();
+                batch.clear();
+            }
+        }
+
+        std::once_flag enable_flag_;
+        std::atomic<bool> enabled_{false};
+        std::string service_name_;
+        settings settings_;
+
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        std::deque<std::string> queue_;
+        bool exit_flag_{false};
+        std::atomic<std::uint64_t> dropped_traces_{0};
+        std::ofstream file_;
+        std::thread writer_;
+    }; // class tracer
+} // namespace irods::rest::tracing
+
+#endif // IRODS_REST_CPP_TRACING_HPP
@@ -1,15 +1,44 @@
 #ifndef IRODS_REST_CPP_UTILS_HPP
 #define IRODS_REST_CPP_UTILS_HPP
 
+#include "compression.hpp"
+#include "constants.hpp"
+#include "metrics.hpp"
+#include "response_encoding.hpp"
+#include "tracing.hpp"
+
+#include <fmt/format.h>
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace irods::rest
 {
     class admin;
+    class list;
+    class query;
+    class zone_report;
+
+    // Endpoints whose JSON responses may be re-encoded as CBOR or MessagePack.
+    template <typename ApiImpl>
+    inline constexpr bool supports_binary_encoding_v =
+        std::is_same_v<ApiImpl, list> || std::is_same_v<ApiImpl, query> || std::is_same_v<ApiImpl, zone_report>;
+
+    // Services derived from api_base expose their response compression settings. Lambdas
+    // passed to handle_request do not.
+    template <typename ApiImpl, typename = void>
+    inline constexpr bool has_response_compression_v = false;
+
+    template <typename ApiImpl>
+    inline constexpr bool has_response_compression_v<ApiImpl, std::void_t<decltype(std::declval<const ApiImpl&>().response_compression())>> = true;
 
     inline auto hide_sensitive_data(const Pistache::Http::Uri::Query& _query, nlohmann::json& _request_info) -> void
     {
@@ -32,10 +61,43 @@ namespace irods::rest
         _request_info["query"] = safe_query.as_str();
     } // hide_sensitive_data
 
+    // Compresses _body in place using the coding preferred by the client, provided the
+    // service enables compression and the body is large enough to benefit from it.
+    inline auto compress_response_if_accepted(const compression::settings& _settings,
+                                              const Pistache::Rest::Request& _request,
+                                              Pistache::Http::ResponseWriter& _response,
+                                              std::string& _body) -> void
+    {
+        if (!_settings.enabled || _body.size() < _settings.minimum_size_in_bytes) {
+            return;
+        }
+
+        const auto accept_encoding = _request.headers().tryGetRaw("accept-encoding");
+
+        if (accept_encoding.isEmpty()) {
+            return;
+        }
+
+        const auto coding = compression::negotiate(accept_encoding.get().value());
+
+        if (compression::content_coding::identity == coding) {
+            return;
+        }
+
+        const auto level = (compression::content_coding::zstd == coding) ? _settings.zstd_level : _settings.gzip_level;
+
+        try {
+            _body = compression::compress(_body, coding, level);
+            _response.headers().addRaw(Pistache::Http::Header::Raw{"Content-Encoding", std::string{compression::to_string(coding)}});
+            _response.headers().addRaw(Pistache::Http::Header::Raw{"Vary", "Accept-Encoding"});
+        }
+        catch (const irods::exception& e) {
+            spdlog::error(nlohmann::json{{"message", fmt::format("Could not compress response. Sending uncompressed. {}", e.what())}}.dump());
+        }
+    } // compress_response_if_accepted
+
     template <typename ApiImpl>
-    auto handle_request(ApiImpl& _api_impl,
-                        const Pistache::Rest::Request& _request,
-                        Pistache::Http::ResponseWriter& _response)
+    auto make_request_info(const Pistache::Rest::Request& _request) -> nlohmann::json
     {
         nlohmann::json request_info{
             {"remote_address", _request.address().host()},
@@ -49,18 +111,250 @@ namespace irods::rest
             request_info["query"] = _request.query().as_str();
         }
 
-        spdlog::debug(request_info.dump());
+        return request_info;
+    } // make_request_info
 
-        auto [http_code, msg] = _api_impl(_request, _response);
+    // Request details are only collected when the completion message will be logged. The
+    // default logger may be asynchronous, so the level check is the only work done on the
+    // request thread when logging is disabled.
+    template <typename ApiImpl>
+    auto begin_request_log(const Pistache::Rest::Request& _request) -> std::optional<nlohmann::json>
+    {
+        auto* logger = spdlog::default_logger_raw();
+
+        if (!logger->should_log(spdlog::level::info)) {
+            return std::nullopt;
+        }
+
+        auto request_info = make_request_info<ApiImpl>(_request);
+
+        if (logger->should_log(spdlog::level::debug)) {
+            logger->debug(request_info.dump());
+        }
 
-        request_info["status"] = http_code;
+        return request_info;
+    } // begin_request_log
+
+    inline auto end_request_log(std::optional<nlohmann::json>& _request_info, Pistache::Http::Code _http_code) -> void
+    {
+        if (!_request_info) {
+            return;
+        }
+
+        auto& request_info = *_request_info;
+        request_info["status"] = _http_code;
         request_info["message"] = "Request completed.";
 
         spdlog::info(request_info.dump());
+    } // end_request_log
+
+    // Returns the route a request was sent to, without the base URL.
+    inline auto request_route(const Pistache::Rest::Request& _request) -> std::string_view
+    {
+        std::string_view route = _request.resource();
+
+        if (route.substr(0, base_url.size()) == base_url) {
+            route.remove_prefix(base_url.size());
+        }
+
+        // Job ids would make every request to /jobs a separate route.
+        if (constexpr std::string_view jobs_route = "/jobs/"; route.substr(0, jobs_route.size()) == jobs_route) {
+            return "/jobs/:id";
+        }
+
+        return route;
+    } // request_route
+
+    // Counts a request as in flight for its lifetime and records its status and latency under
+    // the route it was sent to.
+    class request_metrics
+    {
+    public:
+        explicit request_metrics(const Pistache::Rest::Request& _request)
+            : request_{_request}
+            , start_{std::chrono::steady_clock::now()}
+            , in_flight_{}
+        {
+            if (auto& r = metrics::registry::instance(); r.enabled()) {
+                in_flight_ = &r.get_gauge("irods_rest_requests_in_flight", "Requests being handled.");
+                in_flight_->add(1);
+            }
+        }
+
+        request_metrics(const request_metrics&) = delete;
+        auto operator=(const request_metrics&) -> request_metrics& = delete;
+
+        ~request_metrics()
+        {
+            if (in_flight_) {
+                in_flight_->add(-1);
+            }
+        }
 
-        _response.send(http_code, msg);
+        auto complete(Pistache::Http::Code _http_code) -> void
+        {
+            if (!in_flight_) {
+                return;
+            }
+
+            auto& r = metrics::registry::instance();
+
+            const auto endpoint = request_route(request_);
+            const auto method = std::string_view{Pistache::Http::methodString(request_.method())};
+            const auto code = std::to_string(static_cast<int>(_http_code));
+
+            r.get_counter("irods_rest_requests_total",
+                          "Requests handled, by endpoint, method and status code.",
+                          {{"endpoint", endpoint}, {"method", method}, {"code", code}}).increment();
+
+            r.get_histogram("irods_rest_request_duration_seconds",
+                            "Time taken to handle a request, by endpoint and method.",
+                            {{"endpoint", endpoint}, {"method", method}}).observe(std::chrono::steady_clock::now() - start_);
+        }
+
+    private:
+        const Pistache::Rest::Request& request_;
+        std::chrono::steady_clock::time_point start_;
+        metrics::gauge* in_flight_;
+    }; // class request_metrics
+
+    // Traces a request for its lifetime if tracing is enabled. A valid traceparent header makes
+    // the request part of the caller's trace. The response carries a traceparent header
+    // identifying the request's span.
+    class request_trace
+    {
+    public:
+        request_trace(const Pistache::Rest::Request& _request, Pistache::Http::ResponseWriter& _response)
+            : trace_{}
+            , scope_{}
+        {
+            auto& tracer = tracing::tracer::instance();
+
+            if (!tracer.enabled()) {
+                return;
+            }
+
+            std::optional<tracing::traceparent> parent;
+
+            if (const auto h = _request.headers().tryGetRaw("traceparent"); !h.isEmpty()) {
+                parent = tracing::traceparent::parse(h.get().value());
+            }
+
+            const auto method = std::string_view{Pistache::Http::methodString(_request.method())};
+            const auto route = request_route(_request);
+
+            trace_.emplace(fmt::format("{} {}", method, route), parent, tracer.get_settings().maximum_number_of_spans_per_request);
+            trace_->set_attribute("http.method", std::string{method});
+            trace_->set_attribute("http.route", std::string{route});
+
+            scope_.emplace(tracing::context{&*trace_, trace_->root_span_id()});
+
+            _response.headers().addRaw(Pistache::Http::Header::Raw{"traceparent", trace_->make_traceparent()});
+        }
+
+        request_trace(const request_trace&) = delete;
+        auto operator=(const request_trace&) -> request_trace& = delete;
+
+        ~request_trace()
+        {
+            if (!trace_) {
+                return;
+            }
+
+            scope_.reset();
+
+            try {
+                tracing::tracer::instance().finish(*trace_, trace_->elapsed());
+            }
+            catch (const std::exception& e) {
+                spdlog::error(nlohmann::json{{"message", fmt::format("Could not export trace. {}", e.what())}}.dump());
+            }
+        }
+
+        auto complete(Pistache::Http::Code _http_code) -> void
+        {
+            if (!trace_) {
+                return;
+            }
+
+            const auto code = static_cast<int>(_http_code);
+            trace_->set_attribute("http.status_code", std::to_string(code));
+
+            // Every failure is reported as 400 Bad Request by this service.
+            if (code >= 400) {
+                trace_->set_failed();
+            }
+        }
+
+    private:
+        std::optional<tracing::trace> trace_;
+        std::optional<tracing::context_scope> scope_;
+    }; // class request_trace
+
+    template <typename ApiImpl>
+    auto handle_request(ApiImpl& _api_impl,
+                        const Pistache::Rest::Request& _request,
+                        Pistache::Http::ResponseWriter& _response)
+    {
+        request_metrics observer{_request};
+        request_trace trace{_request, _response};
+
+        auto request_info = begin_request_log<ApiImpl>(_request);
+
+        auto [http_code, msg] = _api_impl(_request, _response);
+        observer.complete(http_code);
+        trace.complete(http_code);
+
+        end_request_log(request_info, http_code);
+
+        std::optional<Pistache::Http::Mime::MediaType> media_type;
+
+        // Endpoints which encode their own responses set the Content-Type. Everything else
+        // (e.g. error responses) is re-encoded here.
+        if constexpr (supports_binary_encoding_v<ApiImpl>) {
+            if (const auto encoding = negotiate_response_encoding(_request); response_encoding::json != encoding && !is_response_encoded(_response)) {
+                try {
+                    msg = encode_json(msg, encoding);
+                    media_type = to_media_type(encoding);
+                }
+                catch (const nlohmann::json::exception& e) {
+                    spdlog::error(nlohmann::json{{"message", fmt::format("Could not encode response. Sending JSON. {}", e.what())}}.dump());
+                }
+            }
+        }
+
+        if constexpr (has_response_compression_v<ApiImpl>) {
+            compress_response_if_accepted(_api_impl.response_compression(), _request, _response, msg);
+        }
+
+        if (media_type) {
+            _response.send(http_code, msg, *media_type);
+        }
+        else {
+            _response.send(http_code, msg);
+        }
     } // handle_request
 
+    // Like handle_request, but for operations which write the response themselves (e.g. chunked
+    // transfers). _fn is invoked on _api_impl and must return the status code it sent.
+    template <typename ApiImpl, typename Fn>
+    auto handle_streaming_request(ApiImpl& _api_impl,
+                                  Fn _fn,
+                                  const Pistache::Rest::Request& _request,
+                                  Pistache::Http::ResponseWriter& _response)
+    {
+        request_metrics observer{_request};
+        request_trace trace{_request, _response};
+
+        auto request_info = begin_request_log<ApiImpl>(_request);
+
+        const auto http_code = std::invoke(_fn, _api_impl, _request, _response);
+        observer.complete(http_code);
+        trace.complete(http_code);
+
+        end_request_log(request_info, http_code);
+    } // handle_streaming_request
+
     inline auto is_set(const std::string_view s) -> bool
     {
         return s == "1"; // we only honor "1" for this client
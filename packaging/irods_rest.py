@@ -1,7 +1,8 @@
-import os, pycurl, getopt, sys, urllib
+import os, pycurl, getopt, subprocess, sys, time, urllib
 from functools import partial
 from io import StringIO ## for Python 3
 import base64
+import json
 import tempfile
 
 from . import settings
@@ -38,6 +39,24 @@ def authenticate(_user_name, _password, _auth_type):
 
     return body.decode('utf-8')
 
+def authenticate_with_raw_credentials(_auth_type, _credentials):
+    buffer = BytesIO()
+
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER, ['Authorization: '+_auth_type+' '+_credentials])
+    c.setopt(c.CUSTOMREQUEST, 'POST')
+    url = base_url()+'auth'
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
 def logical_path_rename(_token, _src, _dst):
     buffer = BytesIO()
     c = pycurl.Curl()
@@ -63,7 +82,9 @@ def logical_path_replicate(_token,
                            _repl_num=None,
                            _recursive=None,
                            _dst_resource=None,
-                           _src_resource=None):
+                           _src_resource=None,
+                           _parallelism=None,
+                           _async=None):
     buffer = BytesIO()
     c = pycurl.Curl()
     c.setopt(pycurl.HTTPHEADER,['Accept: application/json'])
@@ -79,6 +100,8 @@ def logical_path_replicate(_token,
     if _repl_num     : url += f'&replica-number={_repl_num}'
     if _src_resource : url += f'&src-resource={_src_resource}'
     if _dst_resource : url += f'&dst-resource={_dst_resource}'
+    if _parallelism  : url += f'&parallelism={_parallelism}'
+    if _async        : url += '&async=1'
 
     c.setopt(c.URL, url)
     c.setopt(c.WRITEDATA, buffer)
@@ -90,6 +113,89 @@ def logical_path_replicate(_token,
 
     return body.decode('utf-8')
 
+def logical_path_copy(_token,
+                      _src,
+                      _dst,
+                      _dst_resource=None,
+                      _overwrite=None,
+                      _recursive=None,
+                      _parallelism=None):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'POST')
+
+    url = base_url()+f'logicalpath/copy?src={_src}&dst={_dst}'
+
+    if _dst_resource : url += f'&dst-resource={_dst_resource}'
+    if _overwrite    : url += '&overwrite=1'
+    if _recursive    : url += '&recursive=1'
+    if _parallelism  : url += f'&parallelism={_parallelism}'
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
+def logical_path_batch(_token, _operations, _ordered=None, _continue_on_error=None):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'POST')
+
+    data = json.dumps(_operations)
+    data_buf = BytesIO(data.encode('utf-8'))
+    c.setopt(c.POSTFIELDSIZE, len(data))
+    c.setopt(c.READDATA, data_buf)
+    c.setopt(c.UPLOAD, 1)
+
+    url = base_url() + 'logicalpath/batch?ordered=' + ('0' if _ordered is False else '1')
+
+    if _continue_on_error: url += '&continue-on-error=1'
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.setopt(pycurl.HTTP_VERSION, pycurl.CURL_HTTP_VERSION_1_1)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
+def get_job(_token, _job_id):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'GET')
+    c.setopt(c.URL, base_url()+f'jobs/{_job_id}')
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
+def cancel_job(_token, _job_id):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'DELETE')
+    c.setopt(c.URL, base_url()+f'jobs/{_job_id}')
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
 def logical_path_delete(_token,
                         _logical_path,
                         _no_trash = None,
@@ -121,7 +227,8 @@ def logical_path_trim(_token,
                       _src_resc=None,
                       _num_copies=None,
                       _admin=None,
-                      _recursive=None):
+                      _recursive=None,
+                      _parallelism=None):
     buffer = BytesIO()
     c = pycurl.Curl()
     c.setopt(pycurl.HTTPHEADER,['Accept: application/json'])
@@ -136,6 +243,7 @@ def logical_path_trim(_token,
     if _repl_num       : url += f'&replica-number={_repl_num}'
     if _src_resc       : url += f'&src-resource={_src_resc}'
     if _num_copies     : url += f'&minimum-number-of-remaining-replicas={_num_copies}'
+    if _parallelism    : url += f'&parallelism={_parallelism}'
 
     c.setopt(c.URL, url)
     c.setopt(c.WRITEDATA, buffer)
@@ -203,6 +311,33 @@ def ticket(_token,
 
     return body.decode('utf-8')
 
+def ticket_batch(_token, _logical_paths, _ticket_type=None, _use_count=None, _recursive=None):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'POST')
+
+    data = json.dumps(_logical_paths)
+    data_buf = BytesIO(data.encode('utf-8'))
+    c.setopt(c.POSTFIELDSIZE, len(data))
+    c.setopt(c.READDATA, data_buf)
+    c.setopt(c.UPLOAD, 1)
+
+    url = base_url()+'ticket/batch?recursive=' + ('1' if _recursive else '0')
+
+    if _ticket_type: url += f'&type={_ticket_type}'
+    if _use_count  : url += f'&use-count={_use_count}'
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.setopt(pycurl.HTTP_VERSION, pycurl.CURL_HTTP_VERSION_1_1)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
 def get_configuration(_token):
     buffer = BytesIO()
     c = pycurl.Curl()
@@ -272,11 +407,13 @@ def put(_token, _physical_path, _logical_path, _ticket_id=None):
     with open(_physical_path, 'r') as f:
         for data in iter(partial(f.read, read_size), ''):
             c = pycurl.Curl()
-            c.setopt(pycurl.HTTPHEADER,['Accept: application/json'])
-            c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+            headers = ['Accept: application/json', 'Authorization: '+_token]
 
+            # Each HTTPHEADER option replaces the previous one, so the headers are set together.
             if _ticket_id:
-                c.setopt(pycurl.HTTPHEADER,['irods-ticket: '+_ticket_id])
+                headers.append('irods-ticket: '+_ticket_id)
+
+            c.setopt(pycurl.HTTPHEADER, headers)
 
             c.setopt(c.CUSTOMREQUEST, 'PUT')
 
@@ -309,11 +446,13 @@ def get(_token, _physical_path, _logical_path, _ticket_id=None):
     with open(_physical_path, 'w') as f:
         while True:
             c = pycurl.Curl()
-            c.setopt(pycurl.HTTPHEADER,['Accept: application/json'])
-            c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+            headers = ['Accept: application/json', 'Authorization: '+_token]
 
+            # Each HTTPHEADER option replaces the previous one, so the headers are set together.
             if _ticket_id:
-                c.setopt(pycurl.HTTPHEADER,['irods-ticket: '+_ticket_id])
+                headers.append('irods-ticket: '+_ticket_id)
+
+            c.setopt(pycurl.HTTPHEADER, headers)
 
             c.setopt(c.CUSTOMREQUEST, 'GET')
 
@@ -336,6 +475,24 @@ def get(_token, _physical_path, _logical_path, _ticket_id=None):
 
     return "Success"
 
+def stream_read(_token, _logical_path, _offset, _count, _ticket_id=None):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+
+    # Without a token, the request relies on anonymous ticket access.
+    headers = []
+    if _token    : headers.append('Authorization: '+_token)
+    if _ticket_id: headers.append('irods-ticket: '+_ticket_id)
+
+    c.setopt(pycurl.HTTPHEADER, headers)
+    c.setopt(c.CUSTOMREQUEST, 'GET')
+    c.setopt(c.URL, base_url()+f'stream?logical-path={_logical_path}&offset={_offset}&count={_count}')
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    return buffer.getvalue().decode('utf-8')
+
 def admin(_token, _action, _target, _arg2, _arg3, _arg4, _arg5, _arg6, _arg7):
     buffer = BytesIO()
     c = pycurl.Curl()
@@ -363,6 +520,32 @@ def admin(_token, _action, _target, _arg2, _arg3, _arg4, _arg5, _arg6, _arg7):
 
     return body.decode('utf-8')
 
+def admin_batch(_token, _operations, _ordered=None, _continue_on_error=None):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'POST')
+
+    data = json.dumps(_operations)
+    data_buf = BytesIO(data.encode('utf-8'))
+    c.setopt(c.POSTFIELDSIZE, len(data))
+    c.setopt(c.READDATA, data_buf)
+    c.setopt(c.UPLOAD, 1)
+
+    url = base_url() + 'admin/batch?ordered=' + ('0' if _ordered is False else '1')
+
+    if _continue_on_error: url += '&continue-on-error=1'
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.setopt(pycurl.HTTP_VERSION, pycurl.CURL_HTTP_VERSION_1_1)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
 def zone_report(_token):
     buffer = BytesIO()
     c = pycurl.Curl()
@@ -380,7 +563,7 @@ def zone_report(_token):
 
     return body.decode('utf-8')
 
-def query(_token, _string, _limit, _offset, _type, _case_sensitive='1', _distinct='1'):
+def query(_token, _string, _limit, _offset, _type, _case_sensitive='1', _distinct='1', _cursor=None, _total=None):
     buffer = BytesIO()
     c = pycurl.Curl()
     c.setopt(pycurl.HTTPHEADER,['Accept: application/json'])
@@ -393,6 +576,8 @@ def query(_token, _string, _limit, _offset, _type, _case_sensitive='1', _distinc
               'type'          : _type,
               'case-sensitive': _case_sensitive,
               'distinct'      : _distinct}
+    if _cursor: params['cursor'] = _cursor
+    if _total: params['total'] = _total
     url = base_url() + 'query?' + urllib.parse.urlencode(params)
 
     c.setopt(c.URL, url)
@@ -404,6 +589,195 @@ def query(_token, _string, _limit, _offset, _type, _case_sensitive='1', _distinc
 
     return body.decode('utf-8')
 
+def query_export(_token, _string, _accept, _limit=None, _parallelism=None, _distinct=None):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token, 'Accept: '+_accept])
+    c.setopt(c.CUSTOMREQUEST, 'GET')
+
+    params = {'query': _string}
+    if _limit: params['limit'] = _limit
+    if _parallelism: params['parallelism'] = _parallelism
+    if _distinct is not None: params['distinct'] = _distinct
+    url = base_url() + 'query?' + urllib.parse.urlencode(params)
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
+def get_encoded(_token, _endpoint, _params, _accept, _accept_encoding=None):
+    buffer = BytesIO()
+    headers = BytesIO()
+    c = pycurl.Curl()
+    http_headers = ['Authorization: '+_token, 'Accept: '+_accept]
+    if _accept_encoding: http_headers.append('Accept-Encoding: '+_accept_encoding)
+    c.setopt(pycurl.HTTPHEADER, http_headers)
+    c.setopt(c.HEADERFUNCTION, headers.write)
+    c.setopt(c.CUSTOMREQUEST, 'GET')
+
+    url = base_url() + _endpoint
+    if _params: url += '?' + urllib.parse.urlencode(_params)
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    content_type = c.getinfo(pycurl.CONTENT_TYPE)
+    c.close()
+
+    if _accept_encoding:
+        content_encoding = None
+        for line in headers.getvalue().decode('iso-8859-1').splitlines():
+            if line.lower().startswith('content-encoding:'):
+                content_encoding = line.split(':', 1)[1].strip()
+        return content_type, content_encoding, buffer.getvalue()
+
+    return content_type, buffer.getvalue()
+
+def put_bytes(_token, _logical_path, _data, _content_encoding=None):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    headers = ['Authorization: '+_token]
+    if _content_encoding: headers.append('Content-Encoding: '+_content_encoding)
+    c.setopt(pycurl.HTTPHEADER, headers)
+    c.setopt(c.CUSTOMREQUEST, 'PUT')
+    c.setopt(c.POSTFIELDS, _data)
+
+    url = base_url() + 'stream?' + urllib.parse.urlencode({'logical-path': _logical_path})
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    return buffer.getvalue().decode('utf-8')
+
+def get_with_headers(_token, _endpoint, _headers):
+    buffer = BytesIO()
+    headers = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER, ['Authorization: '+_token] + _headers)
+    c.setopt(c.HEADERFUNCTION, headers.write)
+    c.setopt(c.CUSTOMREQUEST, 'GET')
+    c.setopt(c.URL, base_url() + _endpoint)
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    response_headers = {}
+    for line in headers.getvalue().decode('iso-8859-1').splitlines():
+        if ':' in line:
+            name, value = line.split(':', 1)
+            response_headers[name.strip().lower()] = value.strip()
+
+    return response_headers, buffer.getvalue().decode('utf-8')
+
+# Restarts every service and waits until /auth and /jobs respond again. The tester image allows
+# the irods user to run the init script with sudo.
+def restart_services(_timeout_in_seconds=60):
+    subprocess.check_call(['sudo', '-n', '/etc/init.d/irods_client_rest_cpp', 'restart'])
+
+    deadline = time.time() + _timeout_in_seconds
+
+    while time.time() < deadline:
+        try:
+            token = authenticate('rods', 'rods', 'native')
+            if 'Job not found' in get_job(token, '0' * 32):
+                return
+        except pycurl.error:
+            pass
+
+        time.sleep(0.5)
+
+    raise RuntimeError('The services did not restart in time.')
+
+def metrics(_port, _host=None):
+    if _host == None:
+        _host = settings.HOSTNAME_1
+
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(c.CUSTOMREQUEST, 'GET')
+    c.setopt(c.URL, f"http://{_host}:{_port}/metrics")
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    return buffer.getvalue().decode('utf-8')
+
+def metric_value(_metrics, _name, _labels):
+    for line in _metrics.splitlines():
+        if line.startswith(_name + '{') and all(f'{k}="{v}"' in line for k, v in _labels.items()):
+            return float(line.rsplit(' ', 1)[1])
+    return 0.0
+
+def query_prepared(_token, _name, _parameters, _limit=None, _offset=None):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'GET')
+
+    params = {'prepared': _name}
+    for i, p in enumerate(_parameters, start=1):
+        params[f'p{i}'] = p
+    if _limit: params['limit'] = _limit
+    if _offset: params['offset'] = _offset
+    url = base_url() + 'query?' + urllib.parse.urlencode(params)
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
+def query_batch(_token, _queries):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'POST')
+
+    data = json.dumps(_queries)
+    data_buf = BytesIO(data.encode('utf-8'))
+    c.setopt(c.POSTFIELDSIZE, len(data))
+    c.setopt(c.READDATA, data_buf)
+    c.setopt(c.UPLOAD, 1)
+
+    url = base_url() + 'query/batch'
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.setopt(pycurl.HTTP_VERSION, pycurl.CURL_HTTP_VERSION_1_1)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
+def query_next(_token, _cursor):
+    buffer = BytesIO()
+    c = pycurl.Curl()
+    c.setopt(pycurl.HTTPHEADER,['Authorization: '+_token])
+    c.setopt(c.CUSTOMREQUEST, 'GET')
+
+    url = base_url() + 'query?' + urllib.parse.urlencode({'cursor': _cursor})
+
+    c.setopt(c.URL, url)
+    c.setopt(c.WRITEDATA, buffer)
+    c.perform()
+    c.close()
+
+    body = buffer.getvalue()
+
+    return body.decode('utf-8')
+
 def logical_path_post(_token,
                       _logical_path,
                       _collection = None,
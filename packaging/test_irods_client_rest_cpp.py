@@ -8,7 +8,16 @@ import shutil
 from .. import lib
 from . import session
 
+import base64
+import concurrent.futures
+import csv
+import gzip
+import io
 import json
+import random
+import re
+import time
+import urllib.parse
 from . import irods_rest
 
 def entity_has_metadata(session, _entity, _entity_type):
@@ -230,6 +239,75 @@ class TestClientRest(session.make_sessions_mixin([], [('alice', 'apass')]), unit
                 os.remove(file_name)
                 admin.assert_icommand(['irm', '-f', file_name])
 
+    def test_ticket_skips_default_modifications_and_cleans_up_on_error(self):
+        with session.make_session_for_existing_admin() as admin:
+            try:
+                file_name = 'test_ticket'
+                lib.make_file(file_name, 1024)
+
+                admin.assert_icommand(['iput', file_name])
+
+                pwd, _ = lib.execute_command(['ipwd'])
+                logical_path = os.path.join(pwd.rstrip(), file_name)
+
+                token = irods_rest.authenticate('rods', 'rods', 'native')
+
+                # Requested values matching the defaults of the catalog are still honored, and
+                # repeated or empty list entries are ignored.
+                json_object = json.loads(irods_rest.ticket(token, logical_path, 'write', _write_file_count=10, _users='rods,,rods'))
+                ticket_id = json_object['headers']['irods-ticket'][0]
+                admin.assert_icommand(['iticket', 'ls', ticket_id], 'STDOUT', [
+                    'write file limit: 10',
+                    'restricted-to user: rods'
+                ])
+                admin.assert_icommand(['iticket', 'delete', ticket_id])
+
+                # Invalid input is rejected before a ticket is created, and a ticket which cannot
+                # be fully configured is deleted.
+                json_object = json.loads(irods_rest.ticket(token, logical_path, _use_count='many'))
+                self.assertEqual(json_object['error_code'], -130000)
+                json_object = json.loads(irods_rest.ticket(token, logical_path, _users='missing_user'))
+                self.assertLess(json_object['error_code'], 0)
+                _, out, _ = admin.run_icommand(['iticket', 'ls'])
+                self.assertNotIn(logical_path, out)
+
+            finally:
+                os.remove(file_name)
+                admin.run_icommand(['irm', '-f', file_name])
+
+    def test_ticket_batch(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            coll_name = 'ticket_batch'
+            coll = os.path.join(admin.home_collection, coll_name)
+            missing = os.path.join(admin.home_collection, 'missing_data_object')
+
+            try:
+                lib.make_large_local_tmp_dir(coll_name, 5, 10)
+                admin.assert_icommand(['iput', '-r', coll_name, coll], 'STDOUT_SINGLELINE', 'Running')
+
+                # Collections require the recursive flag.
+                results = json.loads(irods_rest.ticket_batch(token, [coll]))
+                self.assertEqual(results[0]['error_code'], -402000) # USER_INCOMPATIBLE_PARAMS
+
+                # Every data object of the collection receives a ticket with the shared settings.
+                # Failures are reported in place.
+                results = json.loads(irods_rest.ticket_batch(token, [coll, missing], _use_count=3, _recursive=True))
+                self.assertEqual(len(results), 6)
+                self.assertEqual(results[5]['logical_path'], missing)
+                self.assertLess(results[5]['error_code'], 0)
+
+                for r in results[:5]:
+                    self.assertTrue(r['logical_path'].startswith(coll))
+                    self.assertIn('count=10', r['url'])
+                    admin.assert_icommand(['iticket', 'ls', r['ticket']], 'STDOUT', ['ticket type: read', 'uses limit: 3'])
+                    admin.assert_icommand(['iticket', 'delete', r['ticket']])
+
+            finally:
+                shutil.rmtree(coll_name, ignore_errors=True)
+                admin.run_icommand(['irm', '-r', '-f', coll])
+
     @unittest.skip('Disabled until support in iRODS server is complete.')
     def test_get_configuration(self):
         token  = irods_rest.authenticate('rods', 'rods', 'native')
@@ -459,6 +537,77 @@ class TestClientRest(session.make_sessions_mixin([], [('alice', 'apass')]), unit
                 shutil.rmtree(dir_name)
                 admin.assert_icommand(['irm', '-f', '-r', dir_name])
 
+    def test_percent_encoded_paths_are_decoded_and_malformed_escapes_are_rejected(self):
+        with session.make_session_for_existing_admin() as admin:
+            logical_path = os.path.join(admin.home_collection, 'a b+c%d')
+
+            try:
+                admin.assert_icommand(['itouch', logical_path])
+
+                token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+                lst = json.loads(irods_rest.list(token, urllib.parse.quote(logical_path, safe='')))
+                self.assertEqual(lst['_embedded'][0]['logical_path'], logical_path)
+
+                # A "+" decodes to a space.
+                encoded = urllib.parse.quote(admin.home_collection, safe='') + '%2Fa+b%2Bc%25d'
+                lst = json.loads(irods_rest.list(token, encoded))
+                self.assertEqual(lst['_embedded'][0]['logical_path'], logical_path)
+
+                for malformed in ['%2', '%zz', '%2Ftmp%G1']:
+                    self.assertIn('Failed to decode URL', irods_rest.list(token, malformed))
+
+                # Credentials which are not valid base64 are rejected.
+                self.assertIn('error', irods_rest.authenticate_with_raw_credentials('Native', 'cm9kczpyb2Rz!'))
+
+            finally:
+                admin.run_icommand(['irm', '-f', logical_path])
+
+    def test_percent_decoding_round_trips_and_rejects_random_malformed_input(self):
+        rng = random.Random(37)
+
+        with session.make_session_for_existing_admin() as admin:
+            collection = os.path.join(admin.home_collection, 'percent_decoding_round_trip')
+            admin.assert_icommand(['imkdir', collection])
+
+            try:
+                token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+                # Names around the 16 and 32 byte block sizes exercise both the vector loop and the
+                # scalar tail of the decoder.
+                alphabet = 'abcXYZ019 +%&=#?~-_é日'
+                for length in [1, 15, 16, 17, 31, 32, 33, 70]:
+                    name = 'n' + ''.join(rng.choice(alphabet) for _ in range(length)) + 'n'
+                    logical_path = os.path.join(collection, name)
+                    admin.assert_icommand(['itouch', logical_path])
+
+                    lst = json.loads(irods_rest.list(token, urllib.parse.quote(logical_path, safe='')))
+                    self.assertEqual(lst['_embedded'][0]['logical_path'], logical_path)
+
+                # Random strings of escapes, partial escapes and plain characters must either decode
+                # or be rejected, exactly as a strict decoder would.
+                well_formed = re.compile(r'^(?:[^%]|%[0-9A-Fa-f]{2})*$')
+                for _ in range(200):
+                    encoded = ''.join(rng.choice('%%%2F4aGz+-_.~0') for _ in range(rng.randint(1, 48)))
+                    response = irods_rest.list(token, encoded)
+
+                    if well_formed.match(encoded):
+                        self.assertNotIn('Failed to decode URL', response)
+                    else:
+                        self.assertIn('Failed to decode URL', response)
+
+                # Random credentials are rejected without disturbing the service. Valid ones still
+                # round trip through base64 afterwards.
+                for _ in range(50):
+                    garbage = ''.join(rng.choice('AZaz09+/=!*-_') for _ in range(rng.randint(1, 24)))
+                    self.assertIn('error', irods_rest.authenticate_with_raw_credentials('Native', garbage))
+
+                credentials = base64.b64encode(f'{admin.username}:{admin.password}'.encode()).decode()
+                self.assertNotIn('error', irods_rest.authenticate_with_raw_credentials('Native', credentials))
+
+            finally:
+                admin.run_icommand(['irm', '-rf', collection])
+
     def test_list_honors_recursive__issue_114(self):
         with session.make_session_for_existing_admin() as admin:
             try:
@@ -593,6 +742,47 @@ class TestClientRest(session.make_sessions_mixin([], [('alice', 'apass')]), unit
                 shutil.rmtree(physical_path)
                 admin.run_icommand(['irm', '-r', '-f', logical_path])
 
+    def test_list_and_query_serve_prefetched_pages(self):
+        # The metrics ports of the list and query services. The test configuration enables prefetching for both.
+        list_metrics_port = 9082
+        query_metrics_port = 9083
+
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            collection = os.path.join(admin.home_collection, 'prefetch_collection')
+            query = f"SELECT DATA_NAME WHERE COLL_NAME = '{collection}'"
+
+            fetchers = [
+                (list_metrics_port, lambda offset: irods_rest.list(token, collection, _offset=offset, _limit=3)),
+                (query_metrics_port, lambda offset: irods_rest.query(token, query, 3, offset, 'general'))
+            ]
+
+            try:
+                admin.assert_icommand(['imkdir', collection])
+                for i in range(9):
+                    admin.assert_icommand(['itouch', os.path.join(collection, f'prefetch_{i}')])
+
+                for port, fetch in fetchers:
+                    def hits():
+                        return irods_rest.metric_value(irods_rest.metrics(port), 'irods_rest_prefetch_lookups_total', {'result': 'hit'})
+
+                    hits_before = hits()
+
+                    # A full page schedules the next one. Give it time to be computed.
+                    fetch(0)
+                    time.sleep(2)
+
+                    prefetched = json.loads(fetch(3))
+                    self.assertEqual(hits(), hits_before + 1)
+
+                    # A prefetched page is served once and matches the page computed on demand.
+                    self.assertEqual(json.loads(fetch(3)), prefetched)
+                    self.assertEqual(hits(), hits_before + 1)
+
+            finally:
+                admin.run_icommand(['irm', '-r', '-f', collection])
+
     def test_query_handles_case_insensitivity__issue_124(self):
         with session.make_session_for_existing_admin() as admin:
             try:
@@ -731,6 +921,302 @@ class TestClientRest(session.make_sessions_mixin([], [('alice', 'apass')]), unit
             result = irods_rest.query(token, 'select COLL_NAME', 1, 0, 'general', _distinct='nopes')
             self.assertIn('error', result)
 
+    def test_concurrent_identical_queries_share_a_single_execution(self):
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            gql = "SELECT COLL_NAME WHERE COLL_NAME = '{0}'".format(admin.home_collection)
+
+            # Identical queries issued at the same time must not fight over the same pooled connection.
+            with concurrent.futures.ThreadPoolExecutor(max_workers=8) as executor:
+                futures = [executor.submit(irods_rest.query, token, gql, 1, 0, 'general') for _ in range(8)]
+                results = [f.result() for f in futures]
+
+            for result in results:
+                res = json.loads(result)
+                self.assertEqual(len(res['_embedded']), 1)
+                self.assertEqual(res['_embedded'][0][0], admin.home_collection)
+
+    def test_query_cursor_returns_all_rows_without_reexecution(self):
+        with session.make_session_for_existing_admin() as admin:
+            try:
+                file_count = 10
+
+                dir_name = 'test_query_cursor_directory'
+                lib.make_large_local_tmp_dir(dir_name, file_count, 1024)
+
+                admin.assert_icommand(['iput', '-r', dir_name], 'STDOUT_SINGLELINE', 'Running')
+
+                pwd, _ = lib.execute_command(['ipwd'])
+                pwd = pwd.rstrip()
+                logical_path = os.path.join(pwd, dir_name)
+
+                token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+                query = "SELECT DATA_NAME WHERE COLL_NAME = '" + logical_path + "'"
+
+                res = json.loads(irods_rest.query(token, query, 3, 0, 'general', _cursor='1', _total='1'))
+                self.assertEqual(res['total'], str(file_count))
+
+                data_names = [row[0] for row in res['_embedded']]
+
+                while 'cursor' in res:
+                    self.assertIn('next', res['_links'])
+                    self.assertLessEqual(len(res['_embedded']), 3)
+
+                    res = json.loads(irods_rest.query_next(token, res['cursor']))
+                    self.assertNotIn('total', res)
+                    data_names += [row[0] for row in res['_embedded']]
+
+                self.assertNotIn('next', res['_links'])
+                self.assertEqual(sorted(data_names), ['junk000' + str(i) for i in range(file_count)])
+
+            finally:
+                shutil.rmtree(dir_name)
+                admin.run_icommand(['irm', '-f', '-r', dir_name])
+
+    def test_query_cursor_is_rejected_for_other_users(self):
+        with session.make_session_for_existing_admin() as admin:
+            admin_token = irods_rest.authenticate(admin.username, admin.password, 'native')
+            alice_token = irods_rest.authenticate('alice', 'apass', 'native')
+
+            res = json.loads(irods_rest.query(admin_token, 'SELECT COLL_NAME', 1, 0, 'general', _cursor='1'))
+            self.assertIn('cursor', res)
+
+            self.assertIn('error', irods_rest.query_next(alice_token, res['cursor']))
+            self.assertIn('error', irods_rest.query_next(admin_token, 'does_not_exist'))
+
+    def test_query_returns_error_for_unknown_prepared_query(self):
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            result = irods_rest.query_prepared(token, 'does_not_exist', [admin.home_collection])
+            self.assertIn('error', result)
+            self.assertIn('does_not_exist', result)
+
+    def test_prepared_query_binds_parameters_and_pages(self):
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            collection = os.path.join(admin.home_collection, 'prepared_query_collection')
+            other_collection = os.path.join(admin.home_collection, 'prepared_query_other')
+            names = [f'prepared_{i}' for i in range(5)]
+
+            try:
+                admin.assert_icommand(['imkdir', collection, other_collection])
+                for name in names:
+                    admin.assert_icommand(['itouch', os.path.join(collection, name)])
+                admin.assert_icommand(['itouch', os.path.join(other_collection, 'not_returned')])
+
+                # The parameter restricts the rows to the data objects in the collection.
+                result = json.loads(irods_rest.query_prepared(token, 'data_objects_in_collection', [collection], _limit=3))
+                self.assertEqual(result['count'], '3')
+                self.assertEqual(result['total'], '5')
+                self.assertIn('next', result['_links'])
+
+                # The last page has no next link and reports the same total.
+                last = json.loads(irods_rest.query_prepared(token, 'data_objects_in_collection', [collection], _limit=3, _offset=3))
+                self.assertEqual(last['count'], '2')
+                self.assertEqual(last['total'], '5')
+                self.assertNotIn('next', last['_links'])
+
+                returned = sorted(row[0] for row in result['_embedded'] + last['_embedded'])
+                self.assertEqual(returned, names)
+
+            finally:
+                admin.run_icommand(['irm', '-r', '-f', collection, other_collection])
+
+    def test_prepared_query_does_not_substitute_parameters_inside_bound_values(self):
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            collection = os.path.join(admin.home_collection, 'prepared_query_markers')
+
+            # The first name contains the marker which stands for the second name.
+            names = ['a__IRODS_REST_PARAMETER_2__', 'b']
+
+            try:
+                admin.assert_icommand(['imkdir', collection])
+                for name in names:
+                    admin.assert_icommand(['itouch', os.path.join(collection, name)])
+
+                result = json.loads(irods_rest.query_prepared(token, 'data_objects_named', [collection] + names))
+                self.assertEqual(sorted(row[0] for row in result['_embedded']), names)
+
+            finally:
+                admin.run_icommand(['irm', '-r', '-f', collection])
+
+    def test_query_batch_returns_results_in_input_order(self):
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            gql = "SELECT COLL_NAME WHERE COLL_NAME = '{0}'"
+            collections = [admin.home_collection, '/' + admin.zone_name, '/' + admin.zone_name + '/home']
+
+            queries = [{'query': gql.format(c), 'limit': 1} for c in collections]
+            queries.insert(1, {'query': 'SELECT NOT_A_COLUMN'})
+            queries.append({'query': gql.format(admin.home_collection), 'case-sensitive': 'nopes'})
+
+            res = json.loads(irods_rest.query_batch(token, queries))
+            self.assertEqual(len(res), len(queries))
+
+            self.assertEqual(res[0]['_embedded'][0][0], collections[0])
+            self.assertIn('error_code', res[1])
+            self.assertEqual(res[2]['_embedded'][0][0], collections[1])
+            self.assertEqual(res[3]['_embedded'][0][0], collections[2])
+            self.assertIn('error_code', res[4])
+
+            # The body must be an array.
+            self.assertIn('error', irods_rest.query_batch(token, {'query': gql.format(admin.home_collection)}))
+
+    def test_binary_response_encodings_match_json(self):
+        try:
+            import cbor2
+            import msgpack
+        except ImportError:
+            raise unittest.SkipTest('cbor2 and msgpack are required')
+
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            query = {'query': "SELECT COLL_NAME WHERE COLL_NAME = '" + admin.home_collection + "'",
+                     'limit': '10', 'offset': '0', 'type': 'general'}
+
+            for endpoint, params in [('query', query), ('zonereport', None)]:
+                _, body = irods_rest.get_encoded(token, endpoint, params, 'application/json')
+                expected = json.loads(body.rstrip(b'\0'))
+
+                content_type, body = irods_rest.get_encoded(token, endpoint, params, 'application/cbor')
+                self.assertEqual(content_type, 'application/cbor')
+                self.assertEqual(cbor2.loads(body), expected)
+
+                content_type, body = irods_rest.get_encoded(token, endpoint, params, 'application/msgpack')
+                self.assertEqual(content_type, 'application/msgpack')
+                self.assertEqual(msgpack.unpackb(body), expected)
+
+    def test_compressed_responses_and_uploads(self):
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            _, expected = irods_rest.get_encoded(token, 'zonereport', None, 'application/json')
+
+            _, content_encoding, body = irods_rest.get_encoded(token, 'zonereport', None, 'application/json', 'gzip')
+            self.assertEqual(content_encoding, 'gzip')
+            self.assertEqual(gzip.decompress(body), expected)
+
+            # Compression is not applied unless requested.
+            _, content_encoding, body = irods_rest.get_encoded(token, 'zonereport', None, 'application/json', 'identity')
+            self.assertIsNone(content_encoding)
+            self.assertEqual(body, expected)
+
+            logical_path = os.path.join(admin.home_collection, 'test_compressed_upload')
+            data = b'compressible data\n' * 10000
+
+            try:
+                self.assertIn('Success', irods_rest.put_bytes(token, logical_path, gzip.compress(data), 'gzip'))
+                stdout, _, _ = admin.run_icommand(['iget', logical_path, '-'])
+                self.assertEqual(stdout.encode('utf-8'), data)
+
+                # A body which does not match the declared coding is rejected.
+                self.assertIn('error', irods_rest.put_bytes(token, logical_path, b'not compressed', 'gzip'))
+
+            finally:
+                admin.run_icommand(['irm', '-f', logical_path])
+
+    def test_metrics_report_requests_and_irods_api_calls(self):
+        # The metrics port of the zonereport service from the default configuration.
+        metrics_port = 9086
+
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            labels = {'endpoint': '/zonereport', 'method': 'GET', 'code': '200'}
+            before = irods_rest.metrics(metrics_port)
+            requests_before = irods_rest.metric_value(before, 'irods_rest_requests_total', labels)
+            calls_before = irods_rest.metric_value(before, 'irods_rest_irods_api_calls_total', {'api': 'rcZoneReport'})
+
+            irods_rest.zone_report(token)
+
+            after = irods_rest.metrics(metrics_port)
+            self.assertEqual(irods_rest.metric_value(after, 'irods_rest_requests_total', labels), requests_before + 1)
+            self.assertEqual(irods_rest.metric_value(after, 'irods_rest_irods_api_calls_total', {'api': 'rcZoneReport'}), calls_before + 1)
+            self.assertIn('# TYPE irods_rest_request_duration_seconds histogram', after)
+            self.assertIn('irods_rest_connection_pool_connections{service="irods_rest_cpp_zonereport_server",state="in_use"}', after)
+
+    def test_traceparent_is_propagated(self):
+        with session.make_session_for_existing_admin() as admin:
+            token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+            trace_id = '4bf92f3577b34da6a3ce929d0e0e4736'
+            parent_id = '00f067aa0ba902b7'
+            headers, _ = irods_rest.get_with_headers(token, 'zonereport', [f'traceparent: 00-{trace_id}-{parent_id}-01'])
+
+            # The response identifies the request's own span within the caller's trace.
+            version, response_trace_id, span_id, _ = headers['traceparent'].split('-')
+            self.assertEqual(version, '00')
+            self.assertEqual(response_trace_id, trace_id)
+            self.assertNotEqual(span_id, parent_id)
+
+            # A malformed header starts a new trace.
+            headers, _ = irods_rest.get_with_headers(token, 'zonereport', ['traceparent: not-a-traceparent'])
+            self.assertNotEqual(headers['traceparent'].split('-')[1], trace_id)
+
+    def test_query_export_as_csv_and_ndjson(self):
+        with session.make_session_for_existing_admin() as admin:
+            try:
+                # More rows than two export windows (4 GenQuery batches each).
+                file_count = 2500
+
+                dir_name = 'test_query_export_directory'
+                lib.make_large_local_tmp_dir(dir_name, file_count, 1)
+
+                admin.assert_icommand(['iput', '-r', dir_name], 'STDOUT_SINGLELINE', 'Running')
+
+                pwd, _ = lib.execute_command(['ipwd'])
+                pwd = pwd.rstrip()
+                logical_path = os.path.join(pwd, dir_name)
+
+                # A name which must be quoted in CSV.
+                special_name = 'a,"b"'
+                admin.assert_icommand(['itouch', logical_path + '/' + special_name])
+
+                token = irods_rest.authenticate(admin.username, admin.password, 'native')
+
+                query = "SELECT DATA_NAME WHERE COLL_NAME = '" + logical_path + "'"
+
+                # More rows than a single GenQuery batch.
+                lines = irods_rest.query_export(token, query, 'application/x-ndjson').splitlines()
+                rows = [json.loads(line) for line in lines]
+                self.assertEqual(len(rows), file_count + 1)
+                self.assertIn([special_name], rows)
+
+                records = list(csv.reader(io.StringIO(irods_rest.query_export(token, query, 'text/csv'), newline='')))
+                self.assertEqual(records[0], ['DATA_NAME'])
+                self.assertEqual(len(records), file_count + 2)
+                self.assertIn([special_name], records)
+
+                lines = irods_rest.query_export(token, query, 'application/x-ndjson', _limit=5).splitlines()
+                self.assertEqual(len(lines), 5)
+
+                # Parallel exports return the same rows in the same order.
+                for accept in ['application/x-ndjson', 'text/csv']:
+                    serial = irods_rest.query_export(token, query, accept)
+                    self.assertEqual(irods_rest.query_export(token, query, accept, _parallelism=3), serial)
+
+                serial = irods_rest.query_export(token, query, 'application/x-ndjson').splitlines()
+
+                lines = irods_rest.query_export(token, query, 'application/x-ndjson', _limit=1500, _parallelism=2).splitlines()
+                self.assertEqual(lines, serial[:1500])
+
+                # Results without distinct have no stable order, so they are not split into windows.
+                lines = irods_rest.query_export(token, query, 'application/x-ndjson', _parallelism=3, _distinct=0).splitlines()
+                self.assertEqual(len(lines), file_count + 1)
+                self.assertEqual(sorted(lines), sorted(serial))
+
+            finally:
+                shutil.rmtree(dir_name)
+                admin.run_icommand(['irm', '-f', '-r', dir_name])
+
     def test_stream_put_and_get(self):
         with session.make_session_for_existing_admin() as admin:
             try:
@@ -762,6 +1248,100 @@ class TestClientRest(session.make_sessions_mixin([], [('alice', 'apass')]), unit
                     os.remove(downloaded_file_name)
                 admin.run_icommand(['irm', '-f', file_name])
 
+    def test_session_ticket_is_applied_once_per_pooled_connection(self):
+        # The metrics port of the stream GET service from the default configuration.
+        metrics_port = 9084
+
+        with session.make_session_for_existing_admin() as admin:
+            try:
+                file_name = 'session_ticket_file'
+                downloaded_file_name = file_name + '2'
+                lib.make_file(file_name, 1024)
+
+                admin.assert_icommand(['iput', file_name])
+                pwd, _ = lib.execute_command(['ipwd'])
+                logical_path = os.path.join(pwd.rstrip(), file_name)
+
+                token = irods_rest.authenticate('rods', 'rods', 'native')
+                ticket_id = json.loads(irods_rest.ticket(token, logical_path))['headers']['irods-ticket'][0]
+
+                calls = {'api': 'rcTicketAdmin'}
+                before = irods_rest.metric_value(irods_rest.metrics(metrics_port), 'irods_rest_irods_api_calls_total', calls)
+
+                # Both downloads are served by the connection reserved for the ticket.
+                for _ in range(2):
+                    irods_rest.get(token, downloaded_file_name, logical_path, ticket_id)
+                    self.assertEqual(os.path.getsize(downloaded_file_name), 1024)
+
+                after = irods_rest.metric_value(irods_rest.metrics(metrics_port), 'irods_rest_irods_api_calls_total', calls)
+                self.assertEqual(after, before + 1)
+
+                admin.assert_icommand(['iticket', 'delete', ticket_id])
+
+            finally:
+                for f in [file_name, downloaded_file_name]:
+                    if os.path.exists(f):
+                        os.remove(f)
+                admin.run_icommand(['irm', '-f', file_name])
+
+    def test_stream_get_with_only_a_ticket_shares_a_bounded_set_of_anonymous_connections(self):
+        # The metrics port of the stream GET service and the number of anonymous connections from
+        # the test configuration, which enables anonymous ticket access.
+        metrics_port = 9084
+        anonymous_connections = 2
+
+        with session.make_session_for_existing_admin() as admin:
+            try:
+                file_name = 'anonymous_ticket_file'
+                lib.make_file(file_name, 1024)
+
+                admin.assert_icommand(['iput', file_name])
+                pwd, _ = lib.execute_command(['ipwd'])
+                logical_path = os.path.join(pwd.rstrip(), file_name)
+
+                # The user anonymous requests are served as. It may already exist.
+                admin.run_icommand(['iadmin', 'mkuser', 'anonymous', 'rodsuser'])
+
+                token = irods_rest.authenticate('rods', 'rods', 'native')
+                ticket_ids = [json.loads(irods_rest.ticket(token, logical_path))['headers']['irods-ticket'][0] for _ in range(4)]
+
+                # A ticket is still required.
+                res = json.loads(irods_rest.stream_read(None, logical_path, 0, 1024, None))
+                self.assertEqual(res['error_code'], -826000) # CAT_INVALID_AUTHENTICATION
+
+                created = {}
+                before = irods_rest.metric_value(irods_rest.metrics(metrics_port), 'irods_rest_connection_pool_connections_created_total', created)
+
+                def read(_ticket_id):
+                    return irods_rest.stream_read(None, logical_path, 0, 1024, _ticket_id)
+
+                # More concurrent downloaders and tickets than connections. Each download either
+                # succeeds or is rejected once every connection stayed busy for too long.
+                with concurrent.futures.ThreadPoolExecutor(max_workers=8) as executor:
+                    results = list(executor.map(read, ticket_ids * 8))
+
+                for r in results:
+                    if len(r) != 1024:
+                        self.assertEqual(json.loads(r)['error_code'], -169000) # SYS_NOT_ALLOWED
+
+                self.assertIn(1024, [len(r) for r in results])
+
+                # Sequential downloads with alternating tickets always succeed.
+                for t in ticket_ids:
+                    self.assertEqual(len(read(t)), 1024)
+
+                # No more connections were created than are reserved for anonymous access.
+                after = irods_rest.metric_value(irods_rest.metrics(metrics_port), 'irods_rest_connection_pool_connections_created_total', created)
+                self.assertLessEqual(after - before, anonymous_connections)
+
+                for t in ticket_ids:
+                    admin.assert_icommand(['iticket', 'delete', t])
+
+            finally:
+                if os.path.exists(file_name):
+                    os.remove(file_name)
+                admin.run_icommand(['irm', '-f', file_name])
+
     def test_zone_report(self):
         with session.make_session_for_existing_admin() as admin:
             zr0, _ = lib.execute_command(['izonereport'])
@@ -795,6 +1375,60 @@ class TestClientRest(session.make_sessions_mixin([], [('alice', 'apass')]), unit
         self.user.assert_icommand(['iinit'], 'STDOUT', 'Enter your current iRODS password:', input=old_password + '\n')
         self.user.assert_icommand(['ils', '-ld'], 'STDOUT', [self.user.session_collection])
 
+    def test_admin_batch(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            group = 'batch_group'
+            users = [f'batch_user_{i}' for i in range(4)]
+
+            try:
+                # An ordered batch stops at the first failure.
+                results = json.loads(irods_rest.admin_batch(token, [
+                    {'action': 'add', 'target': 'user', 'arg2': group, 'arg3': 'rodsgroup'},
+                    {'action': 'add', 'target': 'user', 'arg2': users[0], 'arg3': 'rodsuser'},
+                    {'action': 'add', 'target': 'user', 'arg2': users[0], 'arg3': 'rodsuser'},
+                    {'action': 'add', 'target': 'user', 'arg2': users[1], 'arg3': 'rodsuser'}
+                ]))
+                self.assertEqual([r['status'] for r in results], ['ok', 'ok', 'error', 'skipped'])
+                self.assertLess(results[2]['error_code'], 0)
+                admin.assert_icommand(['iadmin', 'lu', users[0]], 'STDOUT', 'user_type_name: rodsuser')
+
+                # An unordered batch which continues on error attempts every operation.
+                operations = []
+                for user in users[1:]:
+                    operations.append({'action': 'add', 'target': 'user', 'arg2': user, 'arg3': 'rodsuser'})
+                results = json.loads(irods_rest.admin_batch(token, operations + [{'action': 'add'}], _ordered=False, _continue_on_error=True))
+                self.assertEqual([r['status'] for r in results], ['ok'] * 3 + ['error'])
+
+                # Set the passwords and group memberships in a single batch.
+                operations = []
+                for user in users:
+                    operations.append({'action': 'modify', 'target': 'user', 'arg2': user, 'arg3': 'password', 'arg4': user + '_pass'})
+                    operations.append({'action': 'modify', 'target': 'group', 'arg2': group, 'arg3': 'add', 'arg4': user})
+                results = json.loads(irods_rest.admin_batch(token, operations))
+                self.assertEqual([r['status'] for r in results], ['ok'] * len(operations))
+
+                admin.assert_icommand(['iadmin', 'lg', group], 'STDOUT', users)
+                self.assertNotIn('error_code', irods_rest.authenticate(users[3], users[3] + '_pass', 'native'))
+                self.assertIn('error_code', irods_rest.authenticate(users[3], 'wrong_pass', 'native'))
+
+                # An unordered batch may not modify passwords, so nothing in it is executed.
+                operations = [
+                    {'action': 'modify', 'target': 'user', 'arg2': users[0], 'arg3': 'password', 'arg4': 'unordered_pass'},
+                    {'action': 'modify', 'target': 'user', 'arg2': users[1], 'arg3': 'type', 'arg4': 'groupadmin'}
+                ]
+                result = json.loads(irods_rest.admin_batch(token, operations, _ordered=False))
+                self.assertEqual(result['error_code'], -130000) # SYS_INVALID_INPUT_PARAM
+                self.assertNotIn('error_code', irods_rest.authenticate(users[0], users[0] + '_pass', 'native'))
+                self.assertIn('error_code', irods_rest.authenticate(users[0], 'unordered_pass', 'native'))
+                admin.assert_icommand(['iadmin', 'lu', users[1]], 'STDOUT', 'user_type_name: rodsuser')
+
+            finally:
+                for user in users:
+                    admin.run_icommand(['iadmin', 'rmuser', user])
+                admin.run_icommand(['iadmin', 'rmgroup', group])
+
     def test_replicate_data_object(self):
         token = irods_rest.authenticate('rods', 'rods', 'native')
 
@@ -854,6 +1488,228 @@ class TestClientRest(session.make_sessions_mixin([], [('alice', 'apass')]), unit
                 admin.run_icommand(['iadmin', 'rmresc', resc_one])
                 admin.run_icommand(['irm', '-r', '-f', coll])
 
+    def test_replicate_collection_in_parallel_reports_each_failure(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            coll_name = 'parallel_replication'
+            coll = os.path.join(admin.home_collection, coll_name)
+            data_objects = [os.path.join(coll, f'junk{i:04}') for i in range(10)]
+
+            resc = 'parallelReplResc'
+
+            try:
+                lib.make_large_local_tmp_dir(coll_name, 10, 10)
+                admin.assert_icommand(['iput', '-r', coll_name, coll], 'STDOUT_SINGLELINE', 'Running')
+                lib.create_ufs_resource(resc, admin)
+
+                # Every data object is replicated, each by one of several workers.
+                res = irods_rest.logical_path_replicate(token, coll, _dst_resource=resc, _recursive=True, _parallelism=4)
+                self.assertEqual(res, '')
+                for data_obj in data_objects:
+                    self.assertTrue(lib.replica_exists_on_resource(admin, data_obj, resc))
+
+                # A failure does not stop the operation and is reported per data object.
+                res = json.loads(irods_rest.logical_path_replicate(token, coll, _dst_resource='missingResc', _recursive=True, _parallelism=4))
+                self.assertIn('10 of 10 data objects', res['error_message'])
+                self.assertEqual(sorted(f['logical_path'] for f in res['failures']), data_objects)
+                for f in res['failures']:
+                    self.assertLess(f['error_code'], 0)
+
+            finally:
+                shutil.rmtree(coll_name, ignore_errors=True)
+                admin.run_icommand(['irm', '-r', '-f', coll])
+                admin.run_icommand(['iadmin', 'rmresc', resc])
+
+    def test_replicate_collection_as_job(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            coll_name = 'replication_job'
+            coll = os.path.join(admin.home_collection, coll_name)
+
+            resc = 'replicationJobResc'
+
+            try:
+                lib.make_large_local_tmp_dir(coll_name, 10, 10)
+                admin.assert_icommand(['iput', '-r', coll_name, coll], 'STDOUT_SINGLELINE', 'Running')
+                lib.create_ufs_resource(resc, admin)
+
+                job = json.loads(irods_rest.logical_path_replicate(token, coll, _dst_resource=resc, _recursive=True, _async=True))
+                self.assertEqual(job['operation'], 'replicate')
+                self.assertIn(job['state'], ['queued', 'running'])
+
+                for _ in range(100):
+                    job = json.loads(irods_rest.get_job(token, job['job_id']))
+                    if job['state'] not in ['queued', 'running']:
+                        break
+                    time.sleep(0.1)
+
+                self.assertEqual(job['state'], 'succeeded')
+                self.assertEqual(job['progress']['data_objects'], 10)
+                self.assertEqual(job['progress']['bytes'], 100)
+                self.assertEqual(job['failures'], [])
+                self.assertTrue(lib.replica_exists_on_resource(admin, os.path.join(coll, 'junk0000'), resc))
+
+                # A finished job cannot be cancelled.
+                self.assertEqual(json.loads(irods_rest.cancel_job(token, job['job_id']))['state'], 'succeeded')
+
+                # Unknown jobs are not found.
+                self.assertIn('Job not found', irods_rest.get_job(token, '0' * 32))
+
+            finally:
+                shutil.rmtree(coll_name, ignore_errors=True)
+                admin.run_icommand(['irm', '-r', '-f', coll])
+                admin.run_icommand(['iadmin', 'rmresc', resc])
+
+    def wait_for_job(self, _token, _job_id):
+        for _ in range(100):
+            job = json.loads(irods_rest.get_job(_token, _job_id))
+            if job['state'] not in ['queued', 'running']:
+                return job
+            time.sleep(0.1)
+
+        self.fail(f'Job [{_job_id}] did not finish.')
+
+    def test_jobs_are_only_visible_to_their_owner(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+        other_token = irods_rest.authenticate('alice', 'apass', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            coll = os.path.join(admin.home_collection, 'job_isolation')
+            resc = 'jobIsolationResc'
+
+            try:
+                admin.assert_icommand(['imkdir', coll])
+                admin.assert_icommand(['itouch', os.path.join(coll, 'foo')])
+                lib.create_ufs_resource(resc, admin)
+
+                job = json.loads(irods_rest.logical_path_replicate(token, coll, _dst_resource=resc, _recursive=True, _async=True))
+
+                # Another user can neither see nor cancel the job.
+                self.assertIn('Job not found', irods_rest.get_job(other_token, job['job_id']))
+                self.assertIn('Job not found', irods_rest.cancel_job(other_token, job['job_id']))
+
+                job = self.wait_for_job(token, job['job_id'])
+                self.assertEqual(job['state'], 'succeeded')
+                self.assertFalse(job['cancellation_requested'])
+
+                self.assertIn('Job not found', irods_rest.get_job(other_token, job['job_id']))
+
+            finally:
+                admin.run_icommand(['irm', '-r', '-f', coll])
+                admin.run_icommand(['iadmin', 'rmresc', resc])
+
+    def test_jobs_are_replayed_from_the_journal_after_a_restart(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            coll = os.path.join(admin.home_collection, 'job_replay')
+            resc = 'jobReplayResc'
+
+            try:
+                admin.assert_icommand(['imkdir', coll])
+                admin.assert_icommand(['itouch', os.path.join(coll, 'foo')])
+                lib.create_ufs_resource(resc, admin)
+
+                job = json.loads(irods_rest.logical_path_replicate(token, coll, _dst_resource=resc, _recursive=True, _async=True))
+                job = self.wait_for_job(token, job['job_id'])
+                self.assertEqual(job['state'], 'succeeded')
+
+                irods_rest.restart_services()
+
+                # The job is restored with its outcome and is still only visible to its owner.
+                token = irods_rest.authenticate('rods', 'rods', 'native')
+                replayed = json.loads(irods_rest.get_job(token, job['job_id']))
+                for key in ['state', 'operation', 'logical_path', 'submitted_at', 'finished_at', 'progress']:
+                    self.assertEqual(replayed[key], job[key])
+
+                other_token = irods_rest.authenticate('alice', 'apass', 'native')
+                self.assertIn('Job not found', irods_rest.get_job(other_token, job['job_id']))
+
+                # The journal's directory is only accessible by the service's user.
+                journal_dir = '/var/lib/irods_client_rest_cpp'
+                self.assertEqual(os.stat(journal_dir).st_mode & 0o777, 0o700)
+                with self.assertRaises(PermissionError):
+                    os.stat(os.path.join(journal_dir, 'logicalpath_jobs.jsonl'))
+
+            finally:
+                admin.run_icommand(['irm', '-r', '-f', coll])
+                admin.run_icommand(['iadmin', 'rmresc', resc])
+
+    def test_copy_collection_in_parallel(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            coll_name = 'copy_source'
+            src = os.path.join(admin.home_collection, coll_name)
+            dst = os.path.join(admin.home_collection, 'copy_archive', coll_name)
+
+            resc = 'copyResc'
+
+            try:
+                lib.make_large_local_tmp_dir(os.path.join(coll_name, 'sub'), 10, 10)
+                admin.assert_icommand(['iput', '-r', coll_name, src], 'STDOUT_SINGLELINE', 'Running')
+                lib.create_ufs_resource(resc, admin)
+
+                # A collection is only copied when asked to, and never into itself.
+                res = irods_rest.logical_path_copy(token, src, dst, _dst_resource=resc)
+                self.assertIn('Make sure you want to copy the whole sub-tree', res)
+                res = irods_rest.logical_path_copy(token, src, os.path.join(src, 'self'), _recursive=True)
+                self.assertIn('Cannot copy a collection into itself', res)
+
+                # Every data object is copied to the destination resource, each by one of several workers.
+                res = irods_rest.logical_path_copy(token, src, dst, _dst_resource=resc, _recursive=True, _parallelism=4)
+                self.assertEqual(res, '')
+                for i in range(10):
+                    self.assertTrue(lib.replica_exists_on_resource(admin, os.path.join(dst, 'sub', f'junk{i:04}'), resc))
+
+                # Existing data objects are only replaced when asked to.
+                data_obj = os.path.join(src, 'sub', 'junk0000')
+                copy = os.path.join(dst, 'sub', 'junk0000')
+                res = json.loads(irods_rest.logical_path_copy(token, data_obj, copy))
+                self.assertEqual(res['error_code'], -312000) # OVERWRITE_WITHOUT_FORCE_FLAG
+                self.assertEqual(irods_rest.logical_path_copy(token, data_obj, copy, _overwrite=True), '')
+
+            finally:
+                shutil.rmtree(coll_name, ignore_errors=True)
+                admin.run_icommand(['irm', '-r', '-f', src])
+                admin.run_icommand(['irm', '-r', '-f', os.path.dirname(dst)])
+                admin.run_icommand(['iadmin', 'rmresc', resc])
+
+    def test_logical_path_batch(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            project = os.path.join(admin.home_collection, 'batch_project')
+            raw = os.path.join(project, 'raw')
+            data_obj = os.path.join(admin.home_collection, 'batch_data_object')
+
+            try:
+                admin.assert_icommand(['itouch', data_obj])
+
+                # An ordered batch stops at the first failure.
+                results = json.loads(irods_rest.logical_path_batch(token, [
+                    {'op': 'mkdir', 'logical-path': raw, 'create-parent-collections': 1},
+                    {'op': 'rename', 'src': data_obj, 'dst': os.path.join(raw, 'moved')},
+                    {'op': 'rename', 'src': data_obj, 'dst': os.path.join(raw, 'missing')},
+                    {'op': 'delete', 'logical-path': project, 'recursive': 1}
+                ]))
+                self.assertEqual([r['status'] for r in results], ['ok', 'ok', 'error', 'skipped'])
+                self.assertLess(results[2]['error_code'], 0)
+                admin.assert_icommand(['ils', raw], 'STDOUT', 'moved')
+
+                # An unordered batch which continues on error attempts every operation.
+                results = json.loads(irods_rest.logical_path_batch(token, [
+                    {'op': 'mkdir', 'logical-path': os.path.join(project, f'c{i}')} for i in range(8)
+                ] + [{'op': 'unknown'}], _ordered=False, _continue_on_error=True))
+                self.assertEqual([r['status'] for r in results], ['ok'] * 8 + ['error'])
+                admin.assert_icommand(['ils', os.path.join(project, 'c7')], 'STDOUT', 'c7')
+
+            finally:
+                admin.run_icommand(['irm', '-r', '-f', project])
+                admin.run_icommand(['irm', '-f', data_obj])
+
     def test_trim_data_object(self):
         token = irods_rest.authenticate('rods', 'rods', 'native')
 
@@ -933,6 +1789,42 @@ class TestClientRest(session.make_sessions_mixin([], [('alice', 'apass')]), unit
                 for resc in resources:
                    admin.run_icommand(['iadmin', 'rmresc', resc])
 
+    def test_trim_collection_in_parallel(self):
+        token = irods_rest.authenticate('rods', 'rods', 'native')
+
+        with session.make_session_for_existing_admin() as admin:
+            coll_name = 'parallel_trim'
+            coll = os.path.join(admin.home_collection, coll_name)
+            data_objects = [os.path.join(coll, f'junk{i:04}') for i in range(10)]
+
+            resc = 'parallelTrimResc'
+
+            try:
+                lib.make_large_local_tmp_dir(coll_name, 10, 10)
+                admin.assert_icommand(['iput', '-r', coll_name, coll], 'STDOUT_SINGLELINE', 'Running')
+                lib.create_ufs_resource(resc, admin)
+                admin.assert_icommand(['irepl', '-r', coll, '-R', resc])
+
+                # Every replica on the resource is trimmed, each by one of several workers. The
+                # replicas on the default resource remain.
+                res = irods_rest.logical_path_trim(token, coll, _src_resc=resc, _recursive=True, _parallelism=4)
+                self.assertEqual(res, '')
+                for data_obj in data_objects:
+                    self.assertFalse(lib.replica_exists_on_resource(admin, data_obj, resc))
+                    self.assertTrue(lib.replica_exists_on_resource(admin, data_obj, admin.default_resource))
+
+                # A failure does not stop the operation and is reported per data object.
+                res = json.loads(irods_rest.logical_path_trim(token, coll, _src_resc='missingResc', _recursive=True, _parallelism=4))
+                self.assertIn('10 of 10 data objects', res['error_message'])
+                self.assertEqual(sorted(f['logical_path'] for f in res['failures']), data_objects)
+                for f in res['failures']:
+                    self.assertLess(f['error_code'], 0)
+
+            finally:
+                shutil.rmtree(coll_name, ignore_errors=True)
+                admin.run_icommand(['irm', '-r', '-f', coll])
+                admin.run_icommand(['iadmin', 'rmresc', resc])
+
 
 def collection_exists(session, full_collection_path):
     out = session.run_icommand(['iquest',